@@ -0,0 +1,73 @@
+// Compares scanlines/second of the scanline compositor kernels on random background and sprite lines
+// Usage: compositor_benchmark [lines]
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "ppu/scanline_compositor.h"
+
+namespace {
+    constexpr int kLineSets = 64;
+
+    struct Config {
+        const char* name_;
+        ScanlineCompositor::Kernel kernel_;
+    };
+
+    using Line = std::array<uint8_t, ScanlineCompositor::kWidth>;
+
+    // Returns composed lines per second. The hit results are summed so the work is not optimized away.
+    double Run(const Config& config, const Line (&backgrounds)[kLineSets], const Line (&sprites)[kLineSets],
+               const uint64_t lines, uint64_t& hits) {
+        Line out{};
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < lines; i++) {
+            const int set = static_cast<int>(i % kLineSets);
+            hits += ScanlineCompositor::Compose(config.kernel_, backgrounds[set].data(), sprites[set].data(), set & 1,
+                                                set & 2, out.data());
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        hits += out[lines % ScanlineCompositor::kWidth];
+        return static_cast<double>(lines) / elapsed.count();
+    }
+}
+
+int main(const int argc, char** argv) {
+    const uint64_t lines = argc >= 2 ? std::stoull(argv[1]) : 20'000'000;
+
+    // Roughly what games draw: mostly background, a few sprites per line
+    static Line backgrounds[kLineSets], sprites[kLineSets];
+    uint32_t seed = 1;
+    for (int set = 0; set < kLineSets; set++) {
+        for (int x = 0; x < ScanlineCompositor::kWidth; x++) {
+            seed = seed * 1103515245 + 12345;
+            backgrounds[set][x] = (seed >> 16) % 4 ? (seed >> 20) & 0x0F : 0;
+            sprites[set][x] = (seed >> 24) % 8 == 0 ? 0x10 | ((seed >> 12) & 0x0F) | ((seed >> 8) & 0xC0) : 0;
+        }
+    }
+
+    const Config configs[] = {
+        {"Scalar:", ScanlineCompositor::Kernel::kScalar},
+        {"SSE2:  ", ScanlineCompositor::Kernel::kSse2},
+        {"AVX2:  ", ScanlineCompositor::Kernel::kAvx2},
+    };
+
+    uint64_t hits = 0;
+    double baseline = 0.0;
+    for (const Config& config : configs) {
+        if (!ScanlineCompositor::IsSupported(config.kernel_)) {
+            std::cout << config.name_ << " not supported" << std::endl;
+            continue;
+        }
+        Run(config, backgrounds, sprites, lines / 10, hits); // Warm up
+        const double rate = Run(config, backgrounds, sprites, lines, hits);
+        if (baseline == 0.0) baseline = rate;
+        std::cout << config.name_ << " " << static_cast<uint64_t>(rate) << " lines/s (" << rate / baseline << "x)"
+            << std::endl;
+    }
+    std::cout << "Hits: " << hits << std::endl;
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Compares emulated cycles/second of the CPU cores on the nestest automation run
+// Usage: cpu_dispatch_benchmark [rom.nes] [cycles]
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "bus.h"
+#include "cpu.h"
+#include "ppu.h"
+
+namespace {
+    struct Config {
+        const char* name_;
+        CPU::Core core_;
+        bool fusion_;
+    };
+
+    // Returns emulated CPU cycles per second. Cycles rather than instructions are counted,
+    // as one step of the JIT core runs a whole block.
+    double Run(CPU& cpu, const Config& config, const uint64_t cycles) {
+        cpu.set_core(config.core_);
+        cpu.set_fusion_enabled(config.fusion_);
+
+        const auto start = std::chrono::steady_clock::now();
+        uint64_t executed = 0;
+        while (executed < cycles) {
+            // nestest automation starts at $C000 and ends when the final RTS empties the stack
+            cpu.Reset();
+            cpu.StepInstruction();
+            cpu.set_PC(0xC000);
+            while (cpu.SP() != 0xFF && executed < cycles) {
+                const uint64_t before = cpu.TotalCycles();
+                cpu.StepInstruction();
+                executed += cpu.TotalCycles() - before;
+            }
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(executed) / elapsed.count();
+    }
+}
+
+int main(const int argc, char** argv) {
+    const std::string rom_path = argc >= 2 ? argv[1] : "roms/nestest.nes";
+    const uint64_t cycles = argc >= 3 ? std::stoull(argv[2]) : 60'000'000;
+
+    CPU cpu;
+    PPU ppu;
+    Bus bus(&cpu, &ppu);
+    if (!bus.LoadCartridge(rom_path)) return 1;
+
+    const Config configs[] = {
+        {"Table core: ", CPU::Core::kTable, false},
+        {"Switch core:", CPU::Core::kSwitch, false},
+        {"Cached core:", CPU::Core::kCached, false},
+        {"Fused core: ", CPU::Core::kCached, true},
+        {"JIT core:   ", CPU::Core::kJit, false},
+    };
+
+    // Warm up every core once before measuring
+    for (const Config& config : configs) {
+        Run(cpu, config, cycles / 10);
+    }
+
+    double baseline = 0.0;
+    for (const Config& config : configs) {
+        const double rate = Run(cpu, config, cycles);
+        if (baseline == 0.0) baseline = rate;
+        std::cout << config.name_ << " " << static_cast<uint64_t>(rate) << " cycles/s ("
+            << rate / baseline << "x)" << std::endl;
+    }
+    return 0;
+}
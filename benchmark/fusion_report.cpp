@@ -0,0 +1,69 @@
+// Reports which superinstructions a ROM uses: the pair sites found by the disassembly walk,
+// and how often each pair ran over some frames, i.e. how many dispatches fusion saved
+// Usage: fusion_report [rom.nes] [frames]
+
+#include <array>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "bus.h"
+#include "cpu.h"
+#include "ppu.h"
+
+namespace {
+    // Counts the pairs formed by adjacent instructions that the disassembly walk reached
+    std::array<uint64_t, Superinstructions::kPairs.size()> CountSites(Bus& bus) {
+        std::array<uint64_t, Superinstructions::kPairs.size()> sites{};
+        for (const auto& [address, line] : bus.disassembly_) {
+            const uint8_t opcode = bus.Read(address);
+            const uint16_t next = address + OpcodeInfo::Get(opcode).length_;
+            if (bus.disassembly_.count(next) == 0) continue;
+
+            const uint8_t next_opcode = bus.Read(next);
+            const uint8_t next_length = OpcodeInfo::Get(next_opcode).length_;
+            uint16_t operand = 0x0000;
+            if (next_length > 1) operand |= bus.Read(next + 1);
+            if (next_length > 2) operand |= bus.Read(next + 2) << 8;
+
+            const size_t pair = Superinstructions::Match(opcode, next_opcode, operand);
+            if (pair != Superinstructions::kNoPair) sites[pair]++;
+        }
+        return sites;
+    }
+}
+
+int main(const int argc, char** argv) {
+    const std::string rom_path = argc >= 2 ? argv[1] : "roms/nestest.nes";
+    const int frames = argc >= 3 ? std::stoi(argv[2]) : 600;
+
+    CPU cpu;
+    PPU ppu;
+    Bus bus(&cpu, &ppu);
+    if (!bus.LoadCartridge(rom_path)) return 1;
+
+    const auto sites = CountSites(bus);
+
+    cpu.set_fusion_enabled(true);
+    for (int frame = 0; frame < frames; frame++) {
+        do {
+            bus.Step();
+        }
+        while (!ppu.frame_complete_);
+        ppu.frame_complete_ = false;
+    }
+
+    std::cout << std::left << std::setw(20) << "Pair" << std::right << std::setw(8) << "Sites"
+        << std::setw(16) << "Saved" << std::endl;
+
+    uint64_t saved = 0;
+    for (size_t i = 0; i < Superinstructions::kPairs.size(); i++) {
+        const uint64_t count = cpu.FusedCounts()[i];
+        saved += count;
+        std::cout << std::left << std::setw(20) << Superinstructions::kPairs[i].name_ << std::right
+            << std::setw(8) << sites[i] << std::setw(16) << count << std::endl;
+    }
+    std::cout << "Dispatches saved over " << frames << " frames: " << saved << std::endl;
+    return 0;
+}
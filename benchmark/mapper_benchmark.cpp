@@ -0,0 +1,116 @@
+// Compares emulated frames/second of each supported mapper on a synthetic ROM that renders with
+// background and sprites on, writes a bank register and reads PRG ROM in its main loop, and starts
+// an OAM DMA from its NMI handler. Every cartridge access of the frame goes through the mapper,
+// either through virtual MapperBase reads, as before the bank windows, or through the windows.
+// Usage: mapper_benchmark [frames]
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bus.h"
+#include "cpu.h"
+#include "ppu.h"
+#include "test_rom.h"
+
+namespace {
+    struct Config {
+        const char* name_;
+        uint8_t mapper_;
+        uint8_t prg_chunks_; // 16KB units
+        uint8_t chr_chunks_; // 8KB units
+    };
+
+    // The program sits in the last 16KB of PRG ROM, which every mapper here maps at $C000
+    TestRom WriteRom(const Config& config) {
+        std::vector<uint8_t> prg(config.prg_chunks_ * 0x4000, 0xEA);
+        const size_t last = prg.size() - 0x4000;
+
+        const std::vector<uint8_t> code = {
+            0xA9, 0x3F, 0x8D, 0x06, 0x20, // $C000 LDA #$3F, STA $2006
+            0xA9, 0x00, 0x8D, 0x06, 0x20, // $C005 LDA #$00, STA $2006
+            0xA9, 0x0F, 0x8D, 0x07, 0x20, // $C00A LDA #$0F, STA $2007
+            0xA9, 0x16, 0x8D, 0x07, 0x20, // $C00F LDA #$16, STA $2007
+            0xA9, 0x2A, 0x8D, 0x07, 0x20, // $C014 LDA #$2A, STA $2007
+            0xA9, 0x12, 0x8D, 0x07, 0x20, // $C019 LDA #$12, STA $2007
+            0xA9, 0x1E, 0x8D, 0x01, 0x20, // $C01E LDA #$1E, STA $2001
+            0xA9, 0x80, 0x8D, 0x00, 0x20, // $C023 LDA #$80, STA $2000
+            0xE8, 0x8A, 0x8D, 0x00, 0xA0, // $C028 INX, TXA, STA $A000 (CHR bank on mappers 1 and 3, mirroring on 4)
+            0xBD, 0x00, 0x80, 0x9D, 0x00, 0x02, // $C02D LDA $8000,X, STA $0200,X
+            0x4C, 0x28, 0xC0 // $C033 JMP $C028
+        };
+        std::copy(code.begin(), code.end(), prg.begin() + last);
+
+        const std::vector<uint8_t> nmi = {
+            0xA9, 0x02, 0x8D, 0x14, 0x40, 0x40 // $C050 LDA #$02, STA $4014, RTI
+        };
+        std::copy(nmi.begin(), nmi.end(), prg.begin() + last + 0x50);
+
+        prg[last + 0x3FFA] = 0x50; // NMI vector $C050
+        prg[last + 0x3FFB] = 0xC0;
+        prg[last + 0x3FFC] = 0x00; // Reset vector $C000
+        prg[last + 0x3FFD] = 0xC0;
+
+        // Pseudo-random tiles, so that every bank draws something different
+        std::vector<uint8_t> chr(config.chr_chunks_ * 0x2000u);
+        uint32_t seed = 1;
+        for (uint8_t& byte : chr) {
+            seed = seed * 1103515245 + 12345;
+            byte = static_cast<uint8_t>(seed >> 16);
+        }
+        return {config.mapper_, prg, chr};
+    }
+
+    // Returns emulated frames per second, or 0 if the ROM did not load
+    double Run(const Config& config, const int frames, const bool virtual_reads) {
+        const TestRom rom = WriteRom(config);
+        CPU cpu;
+        PPU ppu;
+        Bus bus(&cpu, &ppu);
+        if (!bus.LoadCartridge(rom.Path())) return 0.0;
+        bus.EnableVirtualMapperReads(virtual_reads);
+
+        // Warm up the caches before measuring
+        for (int frame = 0; frame < frames / 10; frame++) {
+            bus.RunFrame();
+            ppu.frame_complete_ = false;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            bus.RunFrame();
+            ppu.frame_complete_ = false;
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return frames / elapsed.count();
+    }
+}
+
+int main(const int argc, char** argv) {
+    const int frames = argc >= 2 ? std::stoi(argv[1]) : 2000;
+
+    const Config configs[] = {
+        {"Mapper 0 (NROM): ", 0, 2, 1},
+        {"Mapper 1 (MMC1): ", 1, 8, 16},
+        {"Mapper 3 (CNROM):", 3, 2, 4},
+        {"Mapper 4 (MMC3): ", 4, 8, 16},
+    };
+
+    // Loading prints, so the table comes after every run
+    std::vector<std::pair<uint64_t, uint64_t>> results;
+    for (const Config& config : configs) {
+        results.emplace_back(static_cast<uint64_t>(Run(config, frames, true)),
+                             static_cast<uint64_t>(Run(config, frames, false)));
+    }
+
+    std::cout << "Frames/s                 virtual  windows" << std::endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        std::cout << configs[i].name_ << std::setw(16) << results[i].first << std::setw(9) << results[i].second
+                  << std::endl;
+    }
+    return 0;
+}
@@ -5,6 +5,7 @@
 #include "bus.h"
 #include "cpu.h"
 #include "ppu.h"
+#include "ppu_render_thread.h"
 #include <iostream>
 #include <queue>
 #include <set>
@@ -14,6 +15,7 @@
 Bus::Bus(CPU* cpu, PPU* ppu) : cpu_(cpu), ppu_(ppu) {
     cpu->Bus(this);
     ram_.fill(0);
+    MapRamPages();
     cpu->Reset();
 }
 
@@ -21,26 +23,9 @@ Bus::~Bus() = default;
 
 void Bus::Step() {
     ppu_->Step();
-    if (total_cycles_ % 3 == 0) {
-        // Perform DMA read/write every 2 cycles
-        if (dma_active_ && dma_dummy_ && total_cycles_ % 2 == 1) {
-            // dma_dummy is used to wait 1 cycle before stating transfer if the current cycle is even
-            // This guarantees that the transfer starts on a read
-            dma_dummy_ = false;
-        }
-        else if (dma_active_ && !dma_dummy_ && total_cycles_ % 2 == 0) { // Read after sync
-            dma_data_ = Read(256 * dma_page_ + dma_addr_);
-        }
-        else if (dma_active_ && !dma_dummy_ && total_cycles_ % 2 == 1) {
-            ppu_->oam_.bytes[dma_addr_] = dma_data_;
-            dma_addr_++;
-            if (dma_addr_ == 0) { // Detect DMA end with overflow
-                dma_active_ = false;
-                dma_dummy_ = true;
-            }
-        }else { // No dma, normal step
-            cpu_->Step();
-        }
+    if (total_cycles_ == next_cpu_tick_) {
+        CpuTick();
+        next_cpu_tick_ += 3;
     }
 
     if (ppu_->was_nmi_triggered_) {
@@ -49,12 +34,219 @@ void Bus::Step() {
     }
 
     total_cycles_++;
+    if (ppu_->dot_count_ >= next_a12_dot_) HandleA12Rise();
+}
+
+// One CPU cycle, in which either the CPU or the OAM DMA uses the bus
+void Bus::CpuTick() {
+    if (!dma_active_) {
+        cpu_->Step();
+        return;
+    }
+
+    // Perform DMA read/write every 2 cycles. CPU cycles start on multiples of 3 master ticks,
+    // so the parity of the tick is the parity of the CPU cycle.
+    const bool odd_cycle = (next_cpu_tick_ & 1) == 1;
+    if (dma_dummy_ && odd_cycle) {
+        // dma_dummy is used to wait 1 cycle before stating transfer if the current cycle is even
+        // This guarantees that the transfer starts on a read
+        dma_dummy_ = false;
+    }
+    else if (!dma_dummy_ && !odd_cycle) { // Read after sync
+        dma_data_ = Read(256 * dma_page_ + dma_addr_);
+    }
+    else if (!dma_dummy_ && odd_cycle) {
+        ppu_->oam_.bytes[dma_addr_] = dma_data_;
+        ppu_->InvalidateOamIndex();
+        if (render_thread_) {
+            render_thread_->Log({ppu_->dot_count_, dma_addr_, dma_data_, PpuRenderThread::Input::Kind::kOamWrite});
+        }
+        dma_addr_++;
+        if (dma_addr_ == 0) { // Detect DMA end with overflow
+            dma_active_ = false;
+            dma_dummy_ = true;
+        }
+    }
+    else { // The CPU keeps running until the DMA syncs to an odd cycle
+        cpu_->Step();
+    }
+}
+
+void Bus::RunFrame() {
+    ScheduleEvents();
+
+    while (!ppu_->frame_complete_) {
+        // Nothing outside of the CPU can change before the next event, so the CPU, or the DMA
+        // halting it, runs every cycle up to its tick at once
+        const uint64_t event_tick = scheduler_.NextTimestamp();
+        if (dma_active_) {
+            RunDma(event_tick);
+        }
+        else {
+            RunCpu(event_tick);
+        }
+        if (next_cpu_tick_ <= event_tick) continue; // Cut short by an OAM DMA, which goes on from here
+
+        CatchUpPpu(event_tick + 1);
+        HandleEvent(scheduler_.Pop());
+    }
+
+    if (render_thread_) render_thread_->Publish(ppu_->dot_count_);
+}
+
+// Runs the CPU for its cycles up to and including last_tick, or until it starts an OAM DMA
+void Bus::RunCpu(const uint64_t last_tick) {
+    if (next_cpu_tick_ > last_tick) return;
+
+    run_start_tick_ = next_cpu_tick_;
+    run_start_cycles_ = cpu_->TotalCycles();
+
+    cpu_running_ = true;
+    cpu_->Run(static_cast<int32_t>((last_tick - next_cpu_tick_) / 3 + 1));
+    cpu_running_ = false;
+
+    next_cpu_tick_ += 3 * (cpu_->TotalCycles() - run_start_cycles_);
+}
+
+// Runs the OAM DMA for its cycles up to and including last_tick, or until it completes. Each
+// cycle reads or writes memory the PPU may see, so the PPU is kept in step.
+void Bus::RunDma(const uint64_t last_tick) {
+    while (dma_active_ && next_cpu_tick_ <= last_tick) {
+        CatchUpPpu(next_cpu_tick_ + 1);
+        CpuTick();
+        next_cpu_tick_ += 3;
+    }
+}
+
+// Step() runs without the scheduler, so events are scheduled again from the state of the PPU
+// and of the DMA at the start of every frame
+void Bus::ScheduleEvents() {
+    scheduler_.Schedule(Scheduler::Event::kNmi, total_cycles_ + ppu_->DotsUntilVblank() - 1);
+    scheduler_.Schedule(Scheduler::Event::kFrameEnd, total_cycles_ + ppu_->DotsUntilFrameComplete() - 1);
+
+    if (dma_active_) {
+        scheduler_.Schedule(Scheduler::Event::kDmaEnd, DmaEndTick(next_cpu_tick_));
+    }
+    else {
+        scheduler_.Cancel(Scheduler::Event::kDmaEnd);
+    }
+    ScheduleA12Rise();
 }
 
+// Called once every component has run through the tick of the event
+void Bus::HandleEvent(const Scheduler::Event event) {
+    switch (event) {
+    case Scheduler::Event::kNmi:
+        if (ppu_->was_nmi_triggered_) {
+            cpu_->NMI();
+            ppu_->was_nmi_triggered_ = false;
+        }
+        // The distance is never overestimated, an early event finds no NMI and schedules again
+        scheduler_.Schedule(event, total_cycles_ + ppu_->DotsUntilVblank() - 1);
+        break;
+    case Scheduler::Event::kFrameEnd:
+        scheduler_.Schedule(event, total_cycles_ + ppu_->DotsUntilFrameComplete() - 1);
+        break;
+    case Scheduler::Event::kA12Rise:
+        HandleA12Rise();
+        break;
+    case Scheduler::Event::kDmaEnd:
+    case Scheduler::Event::kCount:
+        break; // The CPU takes the bus back from the next cycle
+    }
+}
+
+// Predicts the next A12 rise for a mapper counting them, again whenever the PPU settings it
+// depends on change. The PPU is caught up, so its dot count matches total_cycles_.
+void Bus::ScheduleA12Rise() {
+    const bool counts = cartridge_ && cartridge_->isLoaded() && cartridge_->CountsA12Rises();
+    const uint32_t dots = counts ? ppu_->DotsUntilA12Rise() : 0;
+    if (dots == 0) {
+        next_a12_dot_ = UINT64_MAX;
+        scheduler_.Cancel(Scheduler::Event::kA12Rise);
+        return;
+    }
+    next_a12_dot_ = ppu_->dot_count_ + dots;
+    scheduler_.Schedule(Scheduler::Event::kA12Rise, total_cycles_ + dots - 1);
+    if (cpu_running_) cpu_->EndRun(); // The rise may come before the end of the run
+}
+
+// The prediction is never late, an early one finds no rise and predicts again
+void Bus::HandleA12Rise() {
+    if (ppu_->A12RoseOnLastDot()) {
+        cartridge_->OnA12Rise();
+        UpdateIrqLine();
+    }
+    ScheduleA12Rise();
+}
+
+void Bus::UpdateIrqLine() {
+    cpu_->SetIrqLine(cartridge_ && cartridge_->Irq());
+}
+
+// Master tick of the last cycle of the OAM DMA in progress, first_tick being its next cycle
+uint64_t Bus::DmaEndTick(const uint64_t first_tick) const {
+    // A read on every even cycle and a write on the following odd one, after the CPU ran until
+    // an odd cycle and one idle cycle
+    const int64_t writes_left = 256 - dma_addr_;
+    const bool odd_cycle = (first_tick & 1) == 1;
+
+    int64_t cycles = 2 * writes_left - 1; // From a read on the first cycle
+    if (dma_dummy_) {
+        cycles += odd_cycle ? 1 : 2;
+    }
+    else if (odd_cycle) {
+        cycles -= 1; // The read of the next write is done
+    }
+    return first_tick + 3 * static_cast<uint64_t>(cycles);
+}
+
+// Master tick of the CPU cycle in progress inside CPU::Run()
+uint64_t Bus::RunningCpuTick() const {
+    return run_start_tick_ + 3 * (cpu_->TotalCycles() - run_start_cycles_);
+}
+
+// Steps the PPU up to and including the master tick of the CPU cycle in progress, as Step()
+// runs the PPU before the CPU on the same tick
+void Bus::SyncPpu() {
+    CatchUpPpu(RunningCpuTick() + 1);
+}
+
+// NMIs are left pending, RunFrame() never lets the CPU run past the tick raising them
+void Bus::CatchUpPpu(const uint64_t tick) {
+    if (tick <= total_cycles_) return;
+    ppu_->Run(static_cast<uint32_t>(tick - total_cycles_));
+    total_cycles_ = tick;
+}
+
+
+void Bus::EnableRenderThread(const bool enable) {
+    if (enable && !render_thread_ && ppu_->GetCartridge()) {
+        render_thread_ = std::make_unique<PpuRenderThread>(*ppu_);
+        ppu_->render_pixels_ = false;
+    }
+    else if (!enable && render_thread_) {
+        render_thread_->Stop(ppu_->dot_count_, *ppu_);
+        render_thread_.reset();
+        ppu_->render_pixels_ = true;
+    }
+}
+
+void Bus::EnableVirtualMapperReads(const bool enable) {
+    if (!cartridge_) return;
+    cartridge_->set_virtual_reads(enable);
+    MapCartridgePages();
+}
 
 bool Bus::LoadCartridge(const std::string& filename) {
+    EnableRenderThread(false);
+
     // Create a new cartridge object
     cartridge_ = std::make_shared<Cartridge>(filename);
+    // The pages and the IRQ of the previous cartridge are gone, even if this one fails to load
+    MapCartridgePages();
+    UpdateIrqLine();
+    ScheduleA12Rise();
 
     if (!cartridge_->isLoaded()) {
         std::cerr << "Failed to load ROM: " << filename << std::endl;
@@ -62,7 +254,7 @@ bool Bus::LoadCartridge(const std::string& filename) {
     }
     // Reset CPU state
     cpu_->Reset();
-    ppu_->cartridge_ = cartridge_;
+    ppu_->SetCartridge(cartridge_);
 
     GenerateDisassembly();
     std::cout << "ROM loaded successfully: " << filename << std::endl;
@@ -76,6 +268,9 @@ bool Bus::InitEmptyCartridge() {
         std::cerr << "Failed to initialize empty cartridge." << std::endl;
         return false;
     }
+    MapCartridgePages();
+    UpdateIrqLine();
+    ScheduleA12Rise();
     // Reset CPU state
     cpu_->Reset();
 
@@ -83,14 +278,35 @@ bool Bus::InitEmptyCartridge() {
     return true;
 }
 
+// The 2KB of RAM, mirrored four times over $0000-$1FFF
+void Bus::MapRamPages() {
+    for (int page = 0; page < (0x2000 >> kPageBits); page++) {
+        uint8_t* memory = ram_.data() + ((page << kPageBits) & 0x7FF);
+        read_pages_[page] = memory;
+        write_pages_[page] = memory;
+    }
+}
 
-uint8_t Bus::Read(const uint16_t address) {
-    // CPU RAM with 2Kb mirroring
-    if (address >= 0x0000 && address <= 0x1FFF) {
-        return ram_[address & 0x7FF];
+// PRG RAM and PRG ROM at $6000-$FFFF as the mapper currently banks them. Mapper registers and
+// memory the mapper does not expose whole pages of stay with the handlers.
+void Bus::MapCartridgePages() {
+    for (int page = 0x6000 >> kPageBits; page < kPageCount; page++) {
+        const auto address = static_cast<uint16_t>(page << kPageBits);
+        read_pages_[page] = cartridge_ ? cartridge_->CpuReadPage(address) : nullptr;
+        write_pages_[page] = cartridge_ ? cartridge_->CpuWritePage(address) : nullptr;
     }
-    else if (address >= 0x2000 && address <= 0x3FFF) {
-        return ppu_->CpuRead(address & 0x0007); // PPU registers are mirrored every 8 bytes
+    mapped_prg_version_ = cartridge_ ? cartridge_->PrgWindowVersion() : 0;
+}
+
+uint8_t Bus::ReadHandler(const uint16_t address) {
+    if (address >= 0x2000 && address <= 0x3FFF) {
+        if (cpu_running_) SyncPpu();
+        const uint16_t reg = address & 0x0007; // PPU registers are mirrored every 8 bytes
+        const uint8_t data = ppu_->CpuRead(reg);
+        if (render_thread_ && (reg == 0x0002 || reg == 0x0007)) {
+            render_thread_->Log({ppu_->dot_count_, reg, 0, PpuRenderThread::Input::Kind::kRegisterRead});
+        }
+        return data;
     }
     else if (address >= 0x4016 && address <= 0x4017) {
         // Controller input handling
@@ -104,25 +320,41 @@ uint8_t Bus::Read(const uint16_t address) {
     return 0x00;
 }
 
-void Bus::Write(const uint16_t address, const uint8_t value) {
-    if (address >= 0x0000 && address <= 0x1FFF) {
-        ram_[address & 0x7FF] = value;
-    }
-    else if (address >= 0x2000 && address <= 0x3FFF) {
-        ppu_->CpuWrite(address & 0x0007, value); // PPU registers are mirrored every 8 bytes
+void Bus::WriteHandler(const uint16_t address, const uint8_t value) {
+    if (address >= 0x2000 && address <= 0x3FFF) {
+        if (cpu_running_) SyncPpu();
+        const uint16_t reg = address & 0x0007; // PPU registers are mirrored every 8 bytes
+        ppu_->CpuWrite(reg, value);
+        if (reg <= 0x0001) ScheduleA12Rise(); // The pattern tables or rendering may have changed
+        if (render_thread_) {
+            render_thread_->Log({ppu_->dot_count_, reg, value, PpuRenderThread::Input::Kind::kRegisterWrite});
+        }
     }
     else if (address == 0x4014) {
         // DMA transfer
         dma_active_ = true;
         dma_page_ = value;
         dma_addr_ = 0x00;
+        if (cpu_running_) {
+            // The CPU halts from its next cycle until the end of the transfer
+            cpu_->EndRun();
+            scheduler_.Schedule(Scheduler::Event::kDmaEnd, DmaEndTick(RunningCpuTick() + 3));
+        }
     }
     else if (address >= 0x4016 && address <= 0x4017) {
         // Controller input handling
         controller_shift_reg[address - 0x4016] = curr_controller_state[address - 0x4016];
     }
     else if (address >= 0x6000 && address <= 0xFFFF && cartridge_) {
+        // Mapper registers can switch the CHR banks or the mirroring the PPU uses, PRG RAM cannot
+        if (cpu_running_ && address >= 0x8000) SyncPpu();
         cartridge_->CpuWrite(address, value);
+        if (cartridge_->PrgWindowVersion() != mapped_prg_version_) MapCartridgePages();
+        UpdateIrqLine();
+        if (address >= 0x8000 && ppu_->GetCartridge()) ppu_->UpdateNametablePages();
+        if (address >= 0x8000 && render_thread_) {
+            render_thread_->Log({ppu_->dot_count_, address, value, PpuRenderThread::Input::Kind::kCartridgeWrite});
+        }
     }
 }
 
@@ -143,50 +375,49 @@ void Bus::GenerateDisassembly() {
         std::string line = Logging::Trim(Logging::CreateDisassemblyLine(*cpu_, addr));
         disassembly_[addr] = line;
         uint8_t opcode = Read(addr);
-        auto entry = CPU::GetOpcodeEntry(opcode);
-        uint8_t size = Logging::GetOperationLength(entry.addr_mode_);
-        if (size == 0) size = 1;
-        uint16_t next_addr = static_cast<uint16_t>(addr + size);
+        const auto& info = OpcodeInfo::Get(opcode);
+        uint16_t next_addr = static_cast<uint16_t>(addr + info.length_);
 
         // Handle control flow
-        std::string opname = entry.name_;
-        if (opname == "JMP") {
-            // Absolute or indirect jump
-            if (entry.addr_mode_ == &CPU::ADR_ABS) {
+        switch (info.flow_) {
+        case OpcodeInfo::Flow::kJump:
+            // Absolute or indirect jump, do not follow next_addr
+            if (info.addr_mode_ == OpcodeInfo::AddrMode::kAbs) {
                 uint16_t target = Read(addr + 1) | (Read(addr + 2) << 8);
                 to_process.push(target);
             }
-            else if (entry.addr_mode_ == &CPU::ADR_IND) {
+            else {
                 uint16_t ptr = Read(addr + 1) | (Read(addr + 2) << 8);
                 uint8_t lo = Read(ptr);
                 uint8_t hi = Read((ptr & 0xFF00) | ((ptr + 1) & 0xFF));
                 uint16_t target = (hi << 8) | lo;
                 to_process.push(target);
             }
-            continue; // Do not follow next_addr
-        }
-        else if (opname == "JSR") {
+            break;
+        case OpcodeInfo::Flow::kCall: {
             // Subroutine call: follow both target and next_addr
             uint16_t target = Read(addr + 1) | (Read(addr + 2) << 8);
             to_process.push(target);
             to_process.push(next_addr);
+            break;
         }
-        else if (entry.addr_mode_ == &CPU::ADR_REL && (
-            opname == "BPL" || opname == "BMI" || opname == "BVC" || opname == "BVS" ||
-            opname == "BCC" || opname == "BCS" || opname == "BNE" || opname == "BEQ")) {
+        case OpcodeInfo::Flow::kBranch: {
             // Branch: follow both branch target and next_addr
             int8_t offset = static_cast<int8_t>(Read(addr + 1));
             uint16_t branch_target = static_cast<uint16_t>(addr + 2 + offset);
             to_process.push(branch_target);
             to_process.push(next_addr);
+            break;
         }
-        else if (opname == "RTS" || opname == "RTI" || opname == "BRK") {
+        case OpcodeInfo::Flow::kReturn:
+        case OpcodeInfo::Flow::kBreak:
+        case OpcodeInfo::Flow::kHalt:
             // End of flow
-            continue;
-        }
-        else {
+            break;
+        case OpcodeInfo::Flow::kNone:
             // Normal instruction: follow next_addr
             to_process.push(next_addr);
+            break;
         }
     }
 }
@@ -4,9 +4,11 @@
 #include <cstdint>
 #include <memory>
 #include "cartridge/cartridge.h"
+#include "scheduler.h"
 
 class CPU;
 class PPU;
+class PpuRenderThread;
 
 class Bus final {
 public:
@@ -14,9 +16,19 @@ public:
 
 	~Bus();
 
-	// Memory operations
-	[[nodiscard]] uint8_t Read(uint16_t address);
-	void Write(uint16_t address, uint8_t value);
+	// Memory operations. Pages backed by memory are read and written through the page table,
+	// the others through the handlers of the I/O registers and of the mapper.
+	[[nodiscard]] uint8_t Read(const uint16_t address) {
+		if (const uint8_t* page = read_pages_[address >> kPageBits]) return page[address & kPageMask];
+		return ReadHandler(address);
+	}
+	void Write(const uint16_t address, const uint8_t value) {
+		if (uint8_t* page = write_pages_[address >> kPageBits]) {
+			page[address & kPageMask] = value;
+			return;
+		}
+		WriteHandler(address, value);
+	}
 
 
 	bool LoadCartridge(const std::string& filename);
@@ -26,12 +38,26 @@ public:
 
 	void Step();
 
+	// Runs until the PPU completes a frame, with the same result as calling Step() in a loop.
+	// The CPU runs whole instructions back to back through CPU::Run() up to the next scheduled
+	// event, and the PPU is only caught up at events and at PPU register and cartridge accesses.
+	void RunFrame();
+
 	void DoDMA(uint8_t page);
 
+	// Draws the frames on another thread from a log of the PPU's inputs, published at the end of
+	// every RunFrame(). The PPU then only keeps the timing, its framebuffer is brought up to date
+	// when the thread is turned off again, which loading a cartridge also does.
+	void EnableRenderThread(bool enable);
+
+	// Routes the reads of the loaded cartridge through virtual mapper calls, see Cartridge::set_virtual_reads()
+	void EnableVirtualMapperReads(bool enable);
+	std::unique_ptr<PpuRenderThread> render_thread_;
+
 	CPU* cpu_;
 	PPU* ppu_;
 	std::shared_ptr<Cartridge> cartridge_;
-	uint32_t total_cycles_ = 0;
+	uint64_t total_cycles_ = 0; // Master ticks (PPU dots) since power on
 	std::array<uint8_t, 2 * 1024> ram_{}; // 2Kb of RAM (8 readable with mirroring)
 	uint8_t curr_controller_state[2] = { 0, 0 };
 
@@ -43,9 +69,45 @@ public:
 	bool dma_active_ = false;
 
 private:
-	uint8_t controller_shift_reg[2];
+	static constexpr int kPageBits = 10; // 1KB pages
+	static constexpr uint16_t kPageMask = (1 << kPageBits) - 1;
+	static constexpr int kPageCount = 0x10000 >> kPageBits;
+
+	// Memory behind each CPU page, nullptr where accesses go through the handlers
+	std::array<const uint8_t*, kPageCount> read_pages_{};
+	std::array<uint8_t*, kPageCount> write_pages_{};
+	uint32_t mapped_prg_version_ = 0; // PRG window version of the cartridge pages in the table
+
+	uint8_t controller_shift_reg[2] = { 0, 0 };
 	uint8_t dma_data_ = 0x00;
 	uint8_t dma_addr_ = 0x00;  // DMA address index (0x00-0xFF inside a page)
 	uint8_t dma_page_ = 0x00; // Current DMA page (0x00-0x7F)
 	bool dma_dummy_ = true; // Dummy variable to synchronize DMA operations
+
+	uint64_t next_cpu_tick_ = 0; // Master tick of the next CPU cycle, every third tick
+
+	// Event-driven execution, see RunFrame()
+	Scheduler scheduler_;
+	bool cpu_running_ = false; // Inside CPU::Run(), the PPU lags behind the CPU
+	uint64_t run_start_tick_ = 0; // Master tick of the first CPU cycle of the run
+	uint64_t run_start_cycles_ = 0; // CPU::TotalCycles() when the run started
+	uint64_t next_a12_dot_ = UINT64_MAX; // PPU::dot_count_ after the next A12 rise, for Step()
+
+	[[nodiscard]] uint8_t ReadHandler(uint16_t address);
+	void WriteHandler(uint16_t address, uint8_t value);
+	void MapRamPages();
+	void MapCartridgePages();
+
+	void CpuTick();
+	void RunCpu(uint64_t last_tick);
+	void RunDma(uint64_t last_tick);
+	void ScheduleEvents();
+	void HandleEvent(Scheduler::Event event);
+	[[nodiscard]] uint64_t DmaEndTick(uint64_t first_tick) const;
+	void ScheduleA12Rise();
+	void HandleA12Rise();
+	void UpdateIrqLine();
+	[[nodiscard]] uint64_t RunningCpuTick() const;
+	void SyncPpu();
+	void CatchUpPpu(uint64_t tick);
 };
@@ -7,8 +7,13 @@
 #include "mappers/mapper_000.h"
 #include "mappers/mapper_001.h"
 #include "mappers/mapper_003.h"
+#include "mappers/mapper_004.h"
 
 Cartridge::Cartridge(const std::string& filename) {
+    // Until the ROM is loaded, a mapper without memory reads 0 everywhere
+    mapper_ = std::make_shared<Mapper000>();
+    AttachMemory();
+
     std::ifstream file(filename, std::ios::binary);
 
     if (!file) {
@@ -22,13 +27,17 @@ Cartridge::Cartridge(const std::string& filename) {
         return;
     }
     switch (mapper_id_) {
-    case 0: mapper_ = std::make_shared<Mapper000>(header_.prg_rom_chunks_, header_.chr_rom_chunks_);
+    case 0: mapper_ = std::make_shared<Mapper000>();
+        break;
+    case 1: mapper_ = std::make_shared<Mapper001>();
         break;
-    case 1: mapper_ = std::make_shared<Mapper001>(header_.prg_rom_chunks_);
+    case 3: mapper_ = std::make_shared<Mapper003>();
         break;
-    case 3: mapper_ = std::make_shared<Mapper003>(header_.prg_rom_chunks_, header_.chr_rom_chunks_);
+    case 4: mapper_ = std::make_shared<Mapper004>();
         break;
-    default: ;
+    default:
+        std::cerr << "Unsupported mapper: " << static_cast<int>(mapper_id_) << std::endl;
+        return;
     }
 
     // Read PRG ROM with mirroring
@@ -43,13 +52,7 @@ Cartridge::Cartridge(const std::string& filename) {
     prg_ram_.resize(prg_ram_bytes);
     chr_ram_.resize(chr_rom_.empty() ? 8 * 1024 : 0); // 8KB default CHR RAM if no CHR ROM
 
-    // Attach memory to mapper
-    if (mapper_) {
-        mapper_->prg_rom_ = &prg_rom_;
-        mapper_->prg_ram_ = &prg_ram_;
-        mapper_->chr_rom_ = &chr_rom_;
-        mapper_->chr_ram_ = &chr_ram_;
-    }
+    AttachMemory();
 
     nmi_vector_ = prg_rom_[prg_rom_.size() - 6] | (prg_rom_[prg_rom_.size() - 5] << 8);
     reset_vector_ = prg_rom_[prg_rom_.size() - 4] | (prg_rom_[prg_rom_.size() - 3] << 8);
@@ -75,11 +78,20 @@ Cartridge::Cartridge() {
     prg_ram_.resize(8 * 1024, 0); // 8KB PRG RAM
     chr_ram_.resize(8 * 1024, 0); // 8KB CHR RAM
 
-    mapper_ = std::make_shared<Mapper000>(1, 1);
-    mapper_->prg_rom_ = &prg_rom_;
-    mapper_->prg_ram_ = &prg_ram_;
-    mapper_->chr_rom_ = &chr_rom_;
-    mapper_->chr_ram_ = &chr_ram_;
+    mapper_ = std::make_shared<Mapper000>();
+    AttachMemory();
+}
+
+std::shared_ptr<Cartridge> Cartridge::Clone() const {
+    auto clone = std::make_shared<Cartridge>(*this);
+    clone->mapper_ = mapper_->Clone();
+    clone->AttachMemory();
+    return clone;
+}
+
+void Cartridge::AttachMemory() {
+    chr_tiles_.Attach(chr_rom_.empty() ? &chr_ram_ : &chr_rom_);
+    mapper_->AttachMemory(&prg_rom_, &prg_ram_, &chr_rom_, &chr_ram_, &chr_tiles_, &mirroring_);
 }
 
 bool Cartridge::ParseHeader(std::ifstream& file) {
@@ -117,23 +129,3 @@ bool Cartridge::ParseHeader(std::ifstream& file) {
 
     return true;
 }
-
-uint8_t Cartridge::CpuRead(const uint16_t address) const {
-    if (!loaded_ || !mapper_) return 0;
-    return mapper_->CpuRead(address);
-}
-
-void Cartridge::CpuWrite(const uint16_t address, const uint8_t data) const {
-    if (!loaded_ || !mapper_) return;
-    mapper_->CpuWrite(address, data);
-}
-
-uint8_t Cartridge::PpuRead(const uint16_t address) const {
-    if (!loaded_ || !mapper_) return 0;
-    return mapper_->PpuRead(address);
-}
-
-void Cartridge::PpuWrite(const uint16_t address, const uint8_t data) const {
-    if (!loaded_ || !mapper_) return;
-    mapper_->PpuWrite(address, data);
-}
@@ -6,6 +6,7 @@
 #include <memory>
 #include <map>
 
+#include "chr_tile_cache.h"
 #include "mappers/mapper_base.h"
 
 
@@ -26,13 +27,7 @@ public:
         uint8_t padding_[5]; // Unused padding
     };
 
-    enum class MirroringType {
-        kHorizontal,
-        kVertical,
-        kFourScreen,
-        kSingleScreenLower,
-        kSingleScreenUpper
-    };
+    using MirroringType = ::MirroringType;
 
     // =====================
     // === Public API ======
@@ -42,13 +37,53 @@ public:
     // Constructor loads a ROM from the specified file path
     explicit Cartridge(const std::string& filename);
     explicit Cartridge();
-    // Bus interface for CPU and PPU
-    [[nodiscard]] uint8_t CpuRead(uint16_t address) const;
-    void CpuWrite(uint16_t address, uint8_t data) const;
-    [[nodiscard]] uint8_t PpuRead(uint16_t address) const;
-    void PpuWrite(uint16_t address, uint8_t data) const;
+
+    // Independent copy of the memory and the mapper state, e.g. for a PPU drawing on another thread
+    [[nodiscard]] std::shared_ptr<Cartridge> Clone() const;
     [[nodiscard]] bool isLoaded() const { return loaded_; }
 
+    // The accessors below are inline and unchecked: there is always a mapper, one without memory
+    // until a ROM is loaded, and reads go through its bank windows without a virtual call. Only
+    // writes to mapper registers reach the concrete mapper.
+
+    // Sends every read through the virtual MapperBase reads instead, with no direct page access,
+    // for benchmark/mapper_benchmark.cpp to compare against. Set through Bus::EnableVirtualMapperReads().
+    void set_virtual_reads(const bool enable) { virtual_reads_ = enable; }
+
+    // Bus interface for CPU and PPU
+    [[nodiscard]] uint8_t CpuRead(const uint16_t address) const {
+        return virtual_reads_ ? mapper_->VirtualCpuRead(address) : mapper_->CpuRead(address);
+    }
+    void CpuWrite(const uint16_t address, const uint8_t data) const { mapper_->CpuWrite(address, data); }
+    [[nodiscard]] uint8_t PpuRead(const uint16_t address) const {
+        return virtual_reads_ ? mapper_->VirtualPpuRead(address) : mapper_->PpuRead(address);
+    }
+    void PpuWrite(const uint16_t address, const uint8_t data) const { mapper_->PpuWrite(address, data); }
+
+    // Memory behind the 1KB CPU page at the address for direct access, nullptr if it goes through
+    // CpuRead()/CpuWrite(). Only valid until the PRG window version changes.
+    [[nodiscard]] const uint8_t* CpuReadPage(const uint16_t address) const {
+        return virtual_reads_ ? nullptr : mapper_->CpuReadPage(address);
+    }
+    [[nodiscard]] uint8_t* CpuWritePage(const uint16_t address) const {
+        return virtual_reads_ ? nullptr : mapper_->CpuWritePage(address);
+    }
+
+    // PRG mapping queries, used by the CPU instruction cache
+    [[nodiscard]] uint32_t MapPrgAddress(const uint16_t address) const { return mapper_->MapPrgAddress(address); }
+    [[nodiscard]] uint32_t PrgWindowVersion() const { return mapper_->prg_window_version_; }
+
+    // Scanline counter and IRQ output, see MapperBase
+    [[nodiscard]] bool CountsA12Rises() const { return mapper_->counts_a12_rises_; }
+    void OnA12Rise() const { mapper_->OnA12Rise(); }
+    [[nodiscard]] bool Irq() const { return mapper_->irq_; }
+
+    // Decoded pattern row at a PPU address ($0000-$1FFF), optionally mirrored horizontally
+    [[nodiscard]] const ChrTileCache::Row& ChrRow(const uint16_t address, const bool flip_h = false) const {
+        return chr_tiles_.GetRow(
+            virtual_reads_ ? mapper_->VirtualMapChrAddress(address) : mapper_->MapChrAddress(address), flip_h);
+    }
+
     std::vector<uint8_t> prg_rom_;
     std::vector<uint8_t> prg_ram_;
 
@@ -56,14 +91,16 @@ public:
     std::vector<uint8_t> chr_rom_;
     std::vector<uint8_t> chr_ram_; // Used if chr_rom is empty
 
-    MirroringType mirroring_ = MirroringType::kHorizontal;
+    MirroringType mirroring_ = MirroringType::kHorizontal; // From the header, mappers may switch it
 private:
     // =====================
     // === Internal State ==
     // =====================
     bool loaded_ = false;
+    bool virtual_reads_ = false;
     uint8_t mapper_id_ = 0;
     std::shared_ptr<MapperBase> mapper_;
+    mutable ChrTileCache chr_tiles_; // Over CHR ROM, or CHR RAM if there is none
 
 
     NesHeader header_{};
@@ -71,6 +108,8 @@ private:
 
     // Parse the iNES header
     bool ParseHeader(std::ifstream& file);
+    // Points the mapper and the tile cache at this cartridge's memory
+    void AttachMemory();
 };
 
 #endif // CARTRIDGE_H
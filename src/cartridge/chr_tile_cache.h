@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pattern table tiles decoded from CHR ROM or RAM. Tiles are indexed by their offset in that memory
+// rather than by PPU address, so bank switches only change which tiles are looked up. A tile is
+// decoded on first use and again after a CHR RAM write to it.
+class ChrTileCache {
+public:
+    // =====================
+    // === Types & Consts ===
+    // =====================
+
+    // One row of a tile: its two bit planes and the pixel indices (0-3) they encode, leftmost first
+    struct Row {
+        uint8_t lsb_;
+        uint8_t msb_;
+        std::array<uint8_t, 8> pixels_;
+    };
+
+    static constexpr Row kBlankRow = {}; // Unmapped CHR reads as 0
+
+    // =====================
+    // === Public API ======
+    // =====================
+    void Attach(const std::vector<uint8_t>* memory) {
+        memory_ = memory;
+        const size_t tiles = memory->size() / kTileBytes;
+        rows_.assign(tiles * kRowsPerTile * 2, Row{});
+        decoded_.assign(tiles, 0);
+    }
+
+    // Row of the tile containing the offset, the offset of either plane gives the same row.
+    // The mirrored row also has its planes mirrored.
+    [[nodiscard]] const Row& GetRow(const uint32_t offset, const bool flip_h) {
+        const uint32_t tile = offset / kTileBytes;
+        if (tile >= decoded_.size()) return kBlankRow;
+        if (!decoded_[tile]) Decode(tile);
+        return rows_[(tile * kRowsPerTile + (offset & 0x07)) * 2 + flip_h];
+    }
+
+    void Invalidate(const uint32_t offset) {
+        const uint32_t tile = offset / kTileBytes;
+        if (tile < decoded_.size()) decoded_[tile] = 0;
+    }
+
+private:
+    // =====================
+    // === Internal State ==
+    // =====================
+    static constexpr uint32_t kTileBytes = 16;
+    static constexpr uint32_t kRowsPerTile = 8;
+
+    const std::vector<uint8_t>* memory_ = nullptr;
+    std::vector<Row> rows_; // Each row followed by its mirrored copy
+    std::vector<uint8_t> decoded_; // One flag per tile
+
+    void Decode(const uint32_t tile) {
+        for (uint32_t y = 0; y < kRowsPerTile; y++) {
+            const uint8_t lsb = (*memory_)[tile * kTileBytes + y];
+            const uint8_t msb = (*memory_)[tile * kTileBytes + y + 8];
+            Row& row = rows_[(tile * kRowsPerTile + y) * 2];
+            Row& flipped = rows_[(tile * kRowsPerTile + y) * 2 + 1];
+            row.lsb_ = lsb;
+            row.msb_ = msb;
+            flipped.lsb_ = 0;
+            flipped.msb_ = 0;
+            for (int x = 0; x < 8; x++) {
+                const uint8_t px = ((msb >> (7 - x) & 1) << 1) | (lsb >> (7 - x) & 1);
+                row.pixels_[x] = px;
+                flipped.pixels_[7 - x] = px;
+                flipped.lsb_ |= (lsb >> (7 - x) & 1) << x;
+                flipped.msb_ |= (msb >> (7 - x) & 1) << x;
+            }
+        }
+        decoded_[tile] = 1;
+    }
+};
@@ -4,13 +4,7 @@
 // NES Mapper 1 (MMC1) implementation
 class Mapper001 final : public MapperBase {
 public:
-    explicit Mapper001(uint8_t prg_chunks);
-    ~Mapper001() override = default;
-
-    [[nodiscard]] uint8_t CpuRead(uint16_t address) const override;
-    void CpuWrite(uint16_t address, uint8_t data) override;
-    [[nodiscard]] uint8_t PpuRead(uint16_t address) const override;
-    void PpuWrite(uint16_t address, uint8_t data) override;
+    [[nodiscard]] std::shared_ptr<MapperBase> Clone() const override { return std::make_shared<Mapper001>(*this); }
 
 private:
     // Internal registers
@@ -20,11 +14,7 @@ private:
     uint8_t chr_bank_0_ = 0;
     uint8_t chr_bank_1_ = 0;
     uint8_t prg_bank_ = 0;
-    uint8_t prg_chunks_;
 
-    // Helper functions
-    void WriteRegister(uint16_t address, uint8_t data);
-    [[nodiscard]] uint32_t MapPrgAddress(uint16_t cpu_addr) const override;
-    [[nodiscard]] uint32_t MapChrAddress(uint16_t ppu_addr) const override;
+    void WriteRegister(uint16_t address, uint8_t data) override;
+    void UpdateWindows() override;
 };
-
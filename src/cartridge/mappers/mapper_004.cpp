@@ -0,0 +1,60 @@
+#include "mapper_004.h"
+
+void Mapper004::WriteRegister(const uint16_t address, const uint8_t data) {
+    // Four register pairs, selected by bits 13-14 and told apart by bit 0
+    const bool odd = address & 0x01;
+    switch ((address >> 13) & 0x03) {
+    case 0:
+        if (odd) banks_[bank_select_ & 0x07] = data;
+        else bank_select_ = data;
+        UpdateWindows();
+        break;
+    case 1:
+        // $A001 protects PRG RAM, which is always enabled here
+        if (!odd) SetMirroring(data & 0x01 ? MirroringType::kHorizontal : MirroringType::kVertical);
+        break;
+    case 2:
+        if (odd) {
+            irq_counter_ = 0;
+            irq_reload_ = true;
+        }
+        else irq_latch_ = data;
+        break;
+    case 3:
+        // $E000 also acknowledges a pending IRQ
+        irq_enabled_ = odd;
+        if (!odd) irq_ = false;
+        break;
+    default: ;
+    }
+}
+
+void Mapper004::UpdateWindows() {
+    // PRG ROM: R6 at $8000 and the second last bank at $C000, swapped in mode 1, R7 at $A000 and
+    // the last bank at $E000
+    const uint32_t second_last = PrgBankCount(8 * 1024) - 2;
+    const bool prg_swapped = bank_select_ & 0x40;
+    SetPrgBank(0x8000, 8 * 1024, prg_swapped ? second_last : banks_[6] & 0x3F);
+    SetPrgBank(0xA000, 8 * 1024, banks_[7] & 0x3F);
+    SetPrgBank(0xC000, 8 * 1024, prg_swapped ? banks_[6] & 0x3F : second_last);
+    SetPrgBank(0xE000, 8 * 1024, second_last + 1);
+
+    // CHR: two 2KB banks (R0, R1) and four 1KB banks (R2-R5), the halves swapped by inversion
+    const uint16_t inversion = bank_select_ & 0x80 ? 0x1000 : 0x0000;
+    SetChrBank(0x0000 ^ inversion, 1024, banks_[0] & 0xFE);
+    SetChrBank(0x0400 ^ inversion, 1024, banks_[0] | 0x01);
+    SetChrBank(0x0800 ^ inversion, 1024, banks_[1] & 0xFE);
+    SetChrBank(0x0C00 ^ inversion, 1024, banks_[1] | 0x01);
+    for (uint16_t bank = 0; bank < 4; bank++) {
+        SetChrBank((0x1000 + bank * 0x400) ^ inversion, 1024, banks_[2 + bank]);
+    }
+}
+
+void Mapper004::OnA12Rise() {
+    if (irq_counter_ == 0 || irq_reload_) {
+        irq_counter_ = irq_latch_;
+        irq_reload_ = false;
+    }
+    else irq_counter_--;
+    if (irq_counter_ == 0 && irq_enabled_) irq_ = true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "mapper_base.h"
+
+// NES Mapper 4 (MMC3) implementation, with the scanline counter clocked by rises of PPU A12
+class Mapper004 final : public MapperBase {
+public:
+    Mapper004() { counts_a12_rises_ = true; }
+    [[nodiscard]] std::shared_ptr<MapperBase> Clone() const override { return std::make_shared<Mapper004>(*this); }
+
+    void OnA12Rise() override;
+
+private:
+    // Internal registers
+    uint8_t bank_select_ = 0;
+    std::array<uint8_t, 8> banks_{}; // R0-R5 CHR, R6-R7 PRG
+    uint8_t irq_latch_ = 0;
+    uint8_t irq_counter_ = 0;
+    bool irq_reload_ = false;
+    bool irq_enabled_ = false;
+
+    void WriteRegister(uint16_t address, uint8_t data) override;
+    void UpdateWindows() override;
+};
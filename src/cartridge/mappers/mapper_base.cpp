@@ -0,0 +1,65 @@
+#include "mapper_base.h"
+
+#include "cartridge/chr_tile_cache.h"
+
+void MapperBase::AttachMemory(std::vector<uint8_t>* prg_rom, std::vector<uint8_t>* prg_ram,
+                              std::vector<uint8_t>* chr_rom, std::vector<uint8_t>* chr_ram,
+                              ChrTileCache* chr_tiles, MirroringType* mirroring) {
+    prg_rom_ = prg_rom;
+    prg_ram_ = prg_ram;
+    chr_writable_ = chr_rom->empty();
+    chr_ = chr_writable_ ? chr_ram : chr_rom;
+    chr_tiles_ = chr_tiles;
+    mirroring_ = mirroring;
+
+    // The windows of a clone still point into the memory of the original
+    prg_windows_.fill(Window{});
+    chr_windows_.fill(Window{});
+    UpdateWindows();
+    prg_window_version_++;
+}
+
+void MapperBase::CpuWrite(const uint16_t address, const uint8_t data) {
+    if (address >= 0x8000) {
+        WriteRegister(address, data);
+    }
+    else if (uint8_t* page = PrgRamPage(address)) {
+        page[address & (kCpuPageSize - 1)] = data;
+    }
+}
+
+void MapperBase::PpuWrite(const uint16_t address, const uint8_t data) {
+    const uint32_t mapped = MapChrAddress(address);
+    if (!chr_writable_ || mapped == kUnmapped) return;
+    (*chr_)[mapped] = data;
+    if (chr_tiles_) chr_tiles_->Invalidate(mapped);
+}
+
+void MapperBase::SetPrgBank(const uint16_t address, const uint32_t size, const uint32_t bank) {
+    const uint32_t banks = PrgBankCount(size);
+    const uint32_t first = ((address - 0x8000) / kPrgWindowSize) & 0x03;
+    for (uint32_t i = 0; i < size / kPrgWindowSize; i++) {
+        Window window;
+        if (banks != 0) {
+            window.offset_ = (bank % banks) * size + i * kPrgWindowSize;
+            window.memory_ = prg_rom_->data() + window.offset_;
+        }
+        Window& current = prg_windows_[(first + i) & 0x03];
+        if (current.memory_ == window.memory_) continue;
+        current = window;
+        prg_window_version_++;
+    }
+}
+
+void MapperBase::SetChrBank(const uint16_t address, const uint32_t size, const uint32_t bank) {
+    const uint32_t banks = ChrBankCount(size);
+    const uint32_t first = (address / kChrWindowSize) & 0x07;
+    for (uint32_t i = 0; i < size / kChrWindowSize; i++) {
+        Window window;
+        if (banks != 0) {
+            window.offset_ = (bank % banks) * size + i * kChrWindowSize;
+            window.memory_ = chr_->data() + window.offset_;
+        }
+        chr_windows_[(first + i) & 0x07] = window;
+    }
+}
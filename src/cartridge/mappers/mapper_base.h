@@ -1,26 +1,156 @@
 #pragma once
+#include <array>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
+class ChrTileCache;
+
+// Arrangement of the nametables, from the header or switched by the mapper
+enum class MirroringType {
+    kHorizontal,
+    kVertical,
+    kFourScreen,
+    kSingleScreenLower,
+    kSingleScreenUpper
+};
+
+// Base of the mappers. The banks visible to the CPU and the PPU are kept in windows, 8KB of PRG
+// ROM at $8000-$FFFF and 1KB of CHR at $0000-$1FFF, which accesses index directly. A mapper only
+// decodes its register writes and fills the windows again in UpdateWindows().
 class MapperBase {
 public:
+    // =====================
+    // === Types & Consts ===
+    // =====================
+    static constexpr uint32_t kPrgWindowSize = 8 * 1024;
+    static constexpr uint32_t kChrWindowSize = 1024;
+    static constexpr uint32_t kCpuPageSize = 1024;
+    static constexpr uint32_t kUnmapped = 0xFFFFFFFF;
+
+    struct Window {
+        uint8_t* memory_ = nullptr; // First byte of the bank, nullptr if there is no memory to map
+        uint32_t offset_ = kUnmapped; // Offset of the bank in PRG ROM or in CHR memory
+    };
+
+    // =====================
+    // === Public API ======
+    // =====================
     MapperBase() = default;
     virtual ~MapperBase() = default;
 
-    // Memory region pointers (set directly by Cartridge)
+    // Copy of the bank registers, the memory is attached again by the cartridge
+    [[nodiscard]] virtual std::shared_ptr<MapperBase> Clone() const = 0;
+
+    // Points the mapper at the cartridge memory and mirroring and fills the windows from the
+    // registers. CHR RAM is used, and writable, when there is no CHR ROM.
+    void AttachMemory(std::vector<uint8_t>* prg_rom, std::vector<uint8_t>* prg_ram, std::vector<uint8_t>* chr_rom,
+                      std::vector<uint8_t>* chr_ram, ChrTileCache* chr_tiles, MirroringType* mirroring);
+
+    // Incremented whenever the PRG banks visible to the CPU change
+    uint32_t prg_window_version_ = 0;
+
+    // Set by mappers that count rises of PPU A12, which the bus then reports from the PPU timing
+    bool counts_a12_rises_ = false;
+    // PPU A12 went from low to high on a rendering line, once per line with the usual pattern tables
+    virtual void OnA12Rise() {}
+    // Level of the cartridge IRQ output, which the bus wires to the CPU IRQ line
+    bool irq_ = false;
+
+    // PRG ROM offset of a CPU address in $8000-$FFFF, or kUnmapped
+    [[nodiscard]] uint32_t MapPrgAddress(const uint16_t cpu_addr) const {
+        if (cpu_addr < 0x8000) return kUnmapped;
+        const Window& window = prg_windows_[(cpu_addr >> 13) & 0x03];
+        return window.memory_ ? window.offset_ + (cpu_addr & (kPrgWindowSize - 1)) : kUnmapped;
+    }
+    // CHR memory offset of a PPU address in $0000-$1FFF, or kUnmapped
+    [[nodiscard]] uint32_t MapChrAddress(const uint16_t ppu_addr) const {
+        if (ppu_addr > 0x1FFF) return kUnmapped;
+        const Window& window = chr_windows_[ppu_addr >> 10];
+        return window.memory_ ? window.offset_ + (ppu_addr & (kChrWindowSize - 1)) : kUnmapped;
+    }
+
+    // Memory behind the 1KB CPU page starting at the address, which the bus reads or writes
+    // directly, or nullptr if accesses must go through CpuRead()/CpuWrite()
+    [[nodiscard]] const uint8_t* CpuReadPage(const uint16_t address) const {
+        if (address < 0x8000) return PrgRamPage(address);
+        uint8_t* memory = prg_windows_[(address >> 13) & 0x03].memory_;
+        return memory ? memory + (address & (kPrgWindowSize - kCpuPageSize)) : nullptr;
+    }
+    [[nodiscard]] uint8_t* CpuWritePage(const uint16_t address) const {
+        return address < 0x8000 ? PrgRamPage(address) : nullptr;
+    }
+
+    // Bus interface
+    [[nodiscard]] uint8_t CpuRead(const uint16_t address) const {
+        if (address >= 0x8000) {
+            const uint8_t* memory = prg_windows_[(address >> 13) & 0x03].memory_;
+            return memory ? memory[address & (kPrgWindowSize - 1)] : 0;
+        }
+        const uint8_t* page = PrgRamPage(address);
+        return page ? page[address & (kCpuPageSize - 1)] : 0;
+    }
+    void CpuWrite(uint16_t address, uint8_t data);
+    [[nodiscard]] uint8_t PpuRead(const uint16_t address) const {
+        if (address > 0x1FFF) return 0;
+        const uint8_t* memory = chr_windows_[address >> 10].memory_;
+        return memory ? memory[address & (kChrWindowSize - 1)] : 0;
+    }
+    void PpuWrite(uint16_t address, uint8_t data);
+
+    // The same reads through a virtual call, as every access was made before the windows. Only
+    // used by cartridges set to virtual reads, to measure what the windows save.
+    [[nodiscard]] virtual uint8_t VirtualCpuRead(const uint16_t address) const { return CpuRead(address); }
+    [[nodiscard]] virtual uint8_t VirtualPpuRead(const uint16_t address) const { return PpuRead(address); }
+    [[nodiscard]] virtual uint32_t VirtualMapChrAddress(const uint16_t ppu_addr) const {
+        return MapChrAddress(ppu_addr);
+    }
+
+protected:
+    // =====================
+    // === Mapper Hooks ====
+    // =====================
+    // Write to $8000-$FFFF. Mappers that change banks call UpdateWindows() from here.
+    virtual void WriteRegister(uint16_t address, uint8_t data) = 0;
+    // Fills every window from the registers
+    virtual void UpdateWindows() = 0;
+
+    // Maps the size bytes of PRG ROM from the CPU address ($8000-$FFFF) to a bank counted in units
+    // of size, a multiple of 8KB. Banks past the end wrap around, like the unconnected address lines.
+    void SetPrgBank(uint16_t address, uint32_t size, uint32_t bank);
+    // Same for CHR at a PPU address ($0000-$1FFF), size being a multiple of 1KB
+    void SetChrBank(uint16_t address, uint32_t size, uint32_t bank);
+
+    // Switches the nametable mirroring, unless the board has four screens of VRAM
+    void SetMirroring(const MirroringType mirroring) const {
+        if (*mirroring_ != MirroringType::kFourScreen) *mirroring_ = mirroring;
+    }
+
+    [[nodiscard]] uint32_t PrgBankCount(const uint32_t size) const {
+        return prg_rom_ ? static_cast<uint32_t>(prg_rom_->size() / size) : 0;
+    }
+    [[nodiscard]] uint32_t ChrBankCount(const uint32_t size) const {
+        return chr_ ? static_cast<uint32_t>(chr_->size() / size) : 0;
+    }
+
+private:
+    // =====================
+    // === Internal State ==
+    // =====================
+    // Set by the cartridge through AttachMemory()
     std::vector<uint8_t>* prg_rom_ = nullptr;
     std::vector<uint8_t>* prg_ram_ = nullptr;
-    std::vector<uint8_t>* chr_rom_ = nullptr;
-    std::vector<uint8_t>* chr_ram_ = nullptr;
+    std::vector<uint8_t>* chr_ = nullptr; // CHR ROM, or CHR RAM if there is none
+    bool chr_writable_ = false;
+    ChrTileCache* chr_tiles_ = nullptr; // Told about CHR RAM writes
+    MirroringType* mirroring_ = nullptr;
 
-    // Map CPU address to PRG ROM offset
-    [[nodiscard]] virtual uint32_t MapPrgAddress(uint16_t cpu_addr) const = 0;
-    // Map PPU address to CHR ROM/RAM offset
-    [[nodiscard]] virtual uint32_t MapChrAddress(uint16_t ppu_addr) const = 0;
+    std::array<Window, 4> prg_windows_{};
+    std::array<Window, 8> chr_windows_{};
 
-    // Bus interface
-    [[nodiscard]] virtual uint8_t CpuRead(uint16_t address) const = 0;
-    virtual void CpuWrite(uint16_t address, uint8_t data) = 0;
-    [[nodiscard]] virtual uint8_t PpuRead(uint16_t address) const = 0;
-    virtual void PpuWrite(uint16_t address, uint8_t data) = 0;
+    // Page of PRG RAM, mirrored over $6000-$7FFF
+    [[nodiscard]] uint8_t* PrgRamPage(const uint16_t address) const {
+        if (address < 0x6000 || !prg_ram_ || prg_ram_->empty() || prg_ram_->size() % kCpuPageSize != 0) return nullptr;
+        return prg_ram_->data() + (address & 0x1C00) % prg_ram_->size();
+    }
 };
@@ -1,5 +1,6 @@
 #include "cpu.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -29,21 +30,223 @@ void CPU::Write(const uint16_t addr, const uint8_t data) const {
 
 void CPU::Step() {
     if (current_cycle_ == 0) {
+        Dispatch();
+    }
+    total_cycles_++;
+    current_cycle_--;
+}
+
+int32_t CPU::Run(const int32_t cycles) {
+    run_cycles_ = cycles;
+    while (run_cycles_ > 0) {
+        // The cycle an instruction starts on is counted like in Step()
+        if (current_cycle_ == 0) {
+            Dispatch();
+        }
+        total_cycles_++;
+        current_cycle_--;
+        run_cycles_--;
+
+        // The rest of the instruction is idle, skip it at once
+        const int32_t idle = std::min<int32_t>(current_cycle_, run_cycles_);
+        total_cycles_ += idle;
+        current_cycle_ -= idle;
+        run_cycles_ -= idle;
+    }
+    return current_cycle_;
+}
+
+void CPU::Dispatch() {
+    // The interrupt sequence takes the place of the next instruction
+    if (irq_line_ && !(p_ & (1 << I))) {
+        IRQ();
+        return;
+    }
+
 #ifdef LOGMODE
-        Logging::create_neslog_line(*this);
+    Logging::create_neslog_line(*this);
 #endif
 
+    if (core_ == Core::kJit && ExecuteJit()) {
+        // A whole block ran as native code
+    }
+    else if ((core_ == Core::kCached || core_ == Core::kJit) && ExecuteCached()) {
+        // Instruction ran from the pre-decoded cache
+    }
+    else if (core_ == Core::kTable) {
         const uint8_t opcode = Read(pc_++);
-
-        current_operation_ = kOpcodeTable[opcode];
-        current_addr_mode_ = kOpcodeTable[opcode].addr_mode_;
+        current_opcode_ = opcode;
         current_cycle_ = kOpcodeTable[opcode].cycles_;
 
         (this->*kOpcodeTable[opcode].addr_mode_)();
         (this->*kOpcodeTable[opcode].op_function_)();
     }
-    total_cycles_++;
-    current_cycle_--;
+    else {
+        ExecuteSwitch(Read(pc_++));
+    }
+}
+
+// Executes a single opcode with its addressing mode and operation known at compile time,
+// so both calls are direct and can be inlined into the switch case
+template <uint8_t kOpcode>
+void CPU::Execute() {
+    constexpr auto kAddrMode = kOpcodeTable[kOpcode].addr_mode_;
+    constexpr auto kOpFunction = kOpcodeTable[kOpcode].op_function_;
+
+    current_opcode_ = kOpcode;
+    current_cycle_ = kOpcodeTable[kOpcode].cycles_;
+
+    (this->*kAddrMode)();
+    (this->*kOpFunction)();
+}
+
+#define CPU_CASE(op) case op: Execute<op>(); break;
+#define CPU_CASE_ROW(hi) \
+    CPU_CASE(hi##0) CPU_CASE(hi##1) CPU_CASE(hi##2) CPU_CASE(hi##3) \
+    CPU_CASE(hi##4) CPU_CASE(hi##5) CPU_CASE(hi##6) CPU_CASE(hi##7) \
+    CPU_CASE(hi##8) CPU_CASE(hi##9) CPU_CASE(hi##A) CPU_CASE(hi##B) \
+    CPU_CASE(hi##C) CPU_CASE(hi##D) CPU_CASE(hi##E) CPU_CASE(hi##F)
+
+void CPU::ExecuteSwitch(const uint8_t opcode) {
+    switch (opcode) {
+        CPU_CASE_ROW(0x0) CPU_CASE_ROW(0x1) CPU_CASE_ROW(0x2) CPU_CASE_ROW(0x3)
+        CPU_CASE_ROW(0x4) CPU_CASE_ROW(0x5) CPU_CASE_ROW(0x6) CPU_CASE_ROW(0x7)
+        CPU_CASE_ROW(0x8) CPU_CASE_ROW(0x9) CPU_CASE_ROW(0xA) CPU_CASE_ROW(0xB)
+        CPU_CASE_ROW(0xC) CPU_CASE_ROW(0xD) CPU_CASE_ROW(0xE) CPU_CASE_ROW(0xF)
+    }
+}
+
+#undef CPU_CASE_ROW
+#undef CPU_CASE
+
+// Executes a pre-decoded instruction. The opcode and operand bytes have already been consumed
+// and pc_ points to the next instruction.
+template <uint8_t kOpcode>
+void CPU::ExecuteDecoded(const InstructionCache::Entry& entry) {
+    constexpr auto kOpFunction = kOpcodeTable[kOpcode].op_function_;
+
+    current_opcode_ = kOpcode;
+    ResolveAddress<OpcodeInfo::Get(kOpcode).addr_mode_>(entry.operand_);
+    (this->*kOpFunction)();
+}
+
+template <size_t... kOpcodes>
+constexpr std::array<InstructionCache::Handler, 256> CPU::MakeDecodedHandlers(std::index_sequence<kOpcodes...>) {
+    return {{&CPU::ExecuteDecoded<kOpcodes>...}};
+}
+
+const std::array<InstructionCache::Handler, 256> CPU::kDecodedHandlers =
+    MakeDecodedHandlers(std::make_index_sequence<256>());
+
+// Runs both instructions of a pair. pc_ already points past the second instruction, which is
+// what its relative branch or immediate operand expects. The first instruction never uses pc_.
+template <size_t kPair>
+void CPU::ExecuteFused(const InstructionCache::Entry& entry) {
+    constexpr uint8_t kFirst = Superinstructions::kPairs[kPair].first_;
+    constexpr uint8_t kSecond = Superinstructions::kPairs[kPair].second_;
+    constexpr auto kFirstMode = OpcodeInfo::Get(kFirst).addr_mode_;
+    static_assert(kFirstMode != OpcodeInfo::AddrMode::kImm && kFirstMode != OpcodeInfo::AddrMode::kRel);
+    static_assert(OpcodeInfo::Get(kFirst).flow_ == OpcodeInfo::Flow::kNone);
+
+    current_opcode_ = kFirst;
+    ResolveAddress<kFirstMode>(entry.operand_);
+    (this->*kOpcodeTable[kFirst].op_function_)();
+
+    current_opcode_ = kSecond;
+    ResolveAddress<OpcodeInfo::Get(kSecond).addr_mode_>(entry.fused_operand_);
+    (this->*kOpcodeTable[kSecond].op_function_)();
+
+    fused_counts_[kPair]++;
+}
+
+template <size_t... kPairs>
+constexpr std::array<InstructionCache::Handler, Superinstructions::kPairs.size()> CPU::MakeFusedHandlers(
+    std::index_sequence<kPairs...>) {
+    return {{&CPU::ExecuteFused<kPairs>...}};
+}
+
+const std::array<InstructionCache::Handler, Superinstructions::kPairs.size()> CPU::kFusedHandlers =
+    MakeFusedHandlers(std::make_index_sequence<Superinstructions::kPairs.size()>());
+
+// Turns a freshly decoded entry into a superinstruction if it starts one of the known pairs.
+// Both instructions must lie in the same window so their bytes stay contiguous in PRG ROM.
+void CPU::Fuse(InstructionCache::Entry& entry) {
+    const uint16_t next = pc_ + entry.length_;
+    if (!InstructionCache::FitsInWindow(pc_, entry.length_ + 1)) return;
+
+    const uint8_t opcode = Read(next);
+    const uint8_t length = OpcodeInfo::Get(opcode).length_;
+    if (!InstructionCache::FitsInWindow(pc_, entry.length_ + length)) return;
+
+    uint16_t operand = 0x0000;
+    if (length > 1) operand |= Read(next + 1);
+    if (length > 2) operand |= Read(next + 2) << 8;
+
+    const size_t pair = Superinstructions::Match(Read(pc_), opcode, operand);
+    if (pair == Superinstructions::kNoPair) return;
+
+    entry.handler_ = kFusedHandlers[pair];
+    entry.fused_operand_ = operand;
+    entry.length_ += length;
+    entry.cycles_ += kOpcodeTable[opcode].cycles_;
+}
+
+bool CPU::ExecuteCached() {
+    if (pc_ < 0x8000) return false; // Only PRG ROM is cached
+
+    InstructionCache::Entry* entry = instruction_cache_.Lookup(pc_);
+    if (entry == nullptr) return false;
+
+    if (entry->handler_ == nullptr) {
+        // First execution at this PRG offset, decode it
+        const uint8_t opcode = Read(pc_);
+        const uint8_t length = OpcodeInfo::Get(opcode).length_;
+
+        // Instructions straddling two windows depend on the bank configuration, never cache them
+        if (!InstructionCache::FitsInWindow(pc_, length)) return false;
+
+        entry->operand_ = 0x0000;
+        if (length > 1) entry->operand_ |= Read(pc_ + 1);
+        if (length > 2) entry->operand_ |= Read(pc_ + 2) << 8;
+        entry->length_ = length;
+        entry->cycles_ = kOpcodeTable[opcode].cycles_;
+        entry->handler_ = kDecodedHandlers[opcode];
+        if (fusion_enabled_) Fuse(*entry);
+    }
+
+    pc_ += entry->length_;
+    current_cycle_ = entry->cycles_;
+    (this->*entry->handler_)(*entry);
+    return true;
+}
+
+bool CPU::ExecuteJit() {
+    if (pc_ < 0x8000) return false; // Only PRG ROM is compiled
+
+    const uint32_t prg_offset = instruction_cache_.MapAddress(pc_);
+    if (prg_offset == InstructionCache::kUnmapped) return false;
+
+    const JitCompiler::BlockFn block = jit_.Lookup(*this, pc_, prg_offset);
+    if (block == nullptr) return false;
+
+    JitCompiler::Context context{a_, x_, y_, sp_, P(), pc_, bus_->ram_.data(), this};
+    const uint32_t cycles = block(&context);
+    if (cycles == 0) return false; // Left through a side exit before its first instruction
+
+    a_ = context.a_;
+    x_ = context.x_;
+    y_ = context.y_;
+    sp_ = context.sp_;
+    set_P(context.p_);
+    pc_ = context.pc_;
+    current_cycle_ = cycles;
+    return true;
+}
+
+void CPU::set_fusion_enabled(const bool enabled) {
+    if (enabled == fusion_enabled_) return;
+    fusion_enabled_ = enabled;
+    instruction_cache_.Clear(); // Entries are decoded differently with and without pairs
 }
 
 void CPU::StepInstruction() {
@@ -65,12 +268,17 @@ void CPU::Reset() {
     if (pc_ == 0x0000 || bus_ == nullptr)
         pc_ = 0x6000;
 
-    p_ = 0x00;
+    set_P(0x00);
     SetFlag(R, true);
     SetFlag(I, true);
     current_cycle_ = 7;
     total_cycles_ = 0; // Reset cycle count
     fetched_address_ = 0x0000;
+
+    // Cached instructions and compiled blocks are dropped if the cartridge changed
+    if (instruction_cache_.Attach(bus_ && bus_->cartridge_ ? bus_->cartridge_.get() : nullptr)) {
+        jit_.Attach(instruction_cache_.Size());
+    }
 }
 
 // Interrupts
@@ -81,11 +289,11 @@ void CPU::IRQ() {
         Write(0x100 + sp_--, (pc_ >> 8) & 0x00FF); // Push high byte
         Write(0x100 + sp_--, pc_ & 0x00FF); // Push low byte
 
-        // Push the processor status to the stack
+        // Push the processor status to the stack, I is set after so that RTI clears it again
         SetFlag(B, false);
         SetFlag(R, true);
+        Write(0x100 + sp_--, P() | 0x20);
         SetFlag(I, true);
-        Write(0x100 + sp_--, p_ | 0x20);
 
         // Jump to the interrupt vector
         pc_ = Read(0xFFFE) | (Read(0xFFFF) << 8);
@@ -98,11 +306,11 @@ void CPU::NMI() {
     Write(0x100 + sp_--, (pc_ >> 8) & 0x00FF); // Push high byte
     Write(0x100 + sp_--, pc_ & 0x00FF); // Push low byte
 
-    // Push the processor status to the stack
+    // Push the processor status to the stack, I is set after so that RTI restores it
     SetFlag(B, false);
     SetFlag(R, true);
+    Write(0x100 + sp_--, P());
     SetFlag(I, true);
-    Write(0x100 + sp_--, p_);
 
     // Jump to the NMI vector
     pc_ = Read(0xFFFA) | (Read(0xFFFB) << 8);
@@ -111,7 +319,7 @@ void CPU::NMI() {
 
 void CPU::RTI() {
     // Pull the processor status from the stack
-    p_ = Read(0x100 + ++sp_); // Ignore bit break bit (4)
+    set_P(Read(0x100 + ++sp_)); // Ignore bit break bit (4)
     SetFlag(B, false);
     SetFlag(R, true);
 
@@ -124,131 +332,162 @@ void CPU::RTI() {
 
 
 // Addressing Modes
+template <OpcodeInfo::AddrMode kMode>
+void CPU::ResolveAddress(const uint16_t operand) {
+    using AddrMode = OpcodeInfo::AddrMode;
+
+    if constexpr (kMode == AddrMode::kImp) {
+        fetched_address_ = 0;
+        // For implicit addressing, Fetch will return A, skip here
+    }
+    else if constexpr (kMode == AddrMode::kImm) {
+        fetched_address_ = pc_ - 1; // The operand byte itself
+    }
+    else if constexpr (kMode == AddrMode::kZp0) {
+        fetched_address_ = operand & 0x00FF;
+    }
+    else if constexpr (kMode == AddrMode::kZpx) {
+        fetched_address_ = (operand + x_) & 0x00FF;
+    }
+    else if constexpr (kMode == AddrMode::kZpy) {
+        fetched_address_ = (operand + y_) & 0x00FF;
+    }
+    else if constexpr (kMode == AddrMode::kAbs) {
+        fetched_address_ = operand;
+    }
+    else if constexpr (kMode == AddrMode::kAbx || kMode == AddrMode::kAby) {
+        fetched_address_ = operand + (kMode == AddrMode::kAbx ? x_ : y_);
+
+        if ((fetched_address_ & 0xFF00) != (operand & 0xFF00) && OpcodeInfo::Get(current_opcode_).page_cross_penalty_) {
+            current_cycle_++; // Only for read ops
+        }
+    }
+    else if constexpr (kMode == AddrMode::kInd) {
+        const uint16_t ptr = operand;
+
+        if ((ptr & 0x00FF) == 0x00FF)
+            fetched_address_ = (Read(ptr & 0xFF00) << 8) | Read(ptr);
+        else
+            fetched_address_ = (Read(ptr + 1) << 8) | Read(ptr);
+    }
+    else if constexpr (kMode == AddrMode::kIzx) {
+        const uint8_t base = operand & 0x00FF;
+        const uint8_t lo = Read((base + x_) & 0x00FF);
+        const uint8_t hi = Read((base + x_ + 1) & 0x00FF);
+        fetched_address_ = (hi << 8) | lo;
+    }
+    else if constexpr (kMode == AddrMode::kIzy) {
+        const uint8_t base = operand & 0x00FF;
+        const uint8_t lo = Read(base & 0x00FF);
+        const uint8_t hi = Read((base + 1) & 0x00FF);
+        fetched_address_ = (hi << 8) | lo;
+        fetched_address_ += y_;
+
+        if ((fetched_address_ & 0xFF00) != (hi << 8) && OpcodeInfo::Get(current_opcode_).page_cross_penalty_) {
+            current_cycle_++; // Only for read ops
+        }
+    }
+    else if constexpr (kMode == AddrMode::kRel) {
+        fetched_address_ = pc_ + static_cast<int8_t>(operand & 0x00FF);
+    }
+}
+
+// The ADR_* functions consume the operand bytes at pc_, then resolve the effective address
 void CPU::ADR_IMP() {
-    fetched_address_ = 0;
-    // For implicit addressing, Fetch will return A, skip here
+    ResolveAddress<OpcodeInfo::AddrMode::kImp>(0);
 }
 
 void CPU::ADR_IMM() {
-    fetched_address_ = pc_++;
+    pc_++;
+    ResolveAddress<OpcodeInfo::AddrMode::kImm>(0);
 }
 
 void CPU::ADR_ZP0() {
-    fetched_address_ = Read(pc_++) & 0x00FF;
+    ResolveAddress<OpcodeInfo::AddrMode::kZp0>(Read(pc_++));
 }
 
 void CPU::ADR_ZPX() {
-    fetched_address_ = (Read(pc_++) + x_) & 0x00FF;
+    ResolveAddress<OpcodeInfo::AddrMode::kZpx>(Read(pc_++));
 }
 
 void CPU::ADR_ZPY() {
-    fetched_address_ = (Read(pc_++) + y_) & 0x00FF;
+    ResolveAddress<OpcodeInfo::AddrMode::kZpy>(Read(pc_++));
 }
 
 void CPU::ADR_ABS() {
     const uint8_t lo = Read(pc_++);
     const uint8_t hi = Read(pc_++);
-    fetched_address_ = (hi << 8) | lo;
+    ResolveAddress<OpcodeInfo::AddrMode::kAbs>((hi << 8) | lo);
 }
 
 void CPU::ADR_ABX() {
     const uint8_t lo = Read(pc_++);
     const uint8_t hi = Read(pc_++);
-    fetched_address_ = ((hi << 8) | lo) + x_;
-
-    if ((fetched_address_ & 0xFF00) != (hi << 8) &&
-        kStoreOps.find(current_operation_.name_) == kStoreOps.end()) {
-        current_cycle_++; // Only for non-store ops
-    }
+    ResolveAddress<OpcodeInfo::AddrMode::kAbx>((hi << 8) | lo);
 }
 
 void CPU::ADR_ABY() {
     const uint8_t lo = Read(pc_++);
     const uint8_t hi = Read(pc_++);
-    fetched_address_ = ((hi << 8) | lo) + y_;
-
-    if ((fetched_address_ & 0xFF00) != (hi << 8) &&
-        kStoreOps.find(current_operation_.name_) == kStoreOps.end()) {
-        current_cycle_++; // Only for non-store ops
-    }
+    ResolveAddress<OpcodeInfo::AddrMode::kAby>((hi << 8) | lo);
 }
 
 void CPU::ADR_IND() {
     const uint8_t ptr_lo = Read(pc_++);
     const uint8_t ptr_hi = Read(pc_++);
-    const uint16_t ptr = (ptr_hi << 8) | ptr_lo;
-
-    if (ptr_lo == 0x00FF)
-        fetched_address_ = (Read(ptr & 0xFF00) << 8) | Read(ptr);
-    else
-        fetched_address_ = (Read(ptr + 1) << 8) | Read(ptr);
+    ResolveAddress<OpcodeInfo::AddrMode::kInd>((ptr_hi << 8) | ptr_lo);
 }
 
 void CPU::ADR_IZX() {
-    const uint8_t base = Read(pc_++);
-    const uint8_t lo = Read((base + x_) & 0x00FF);
-    const uint8_t hi = Read((base + x_ + 1) & 0x00FF);
-    fetched_address_ = (hi << 8) | lo;
+    ResolveAddress<OpcodeInfo::AddrMode::kIzx>(Read(pc_++));
 }
 
 void CPU::ADR_IZY() {
-    const uint8_t base = Read(pc_++);
-    const uint8_t lo = Read(base & 0x00FF);
-    const uint8_t hi = Read((base + 1) & 0x00FF);
-    fetched_address_ = (hi << 8) | lo;
-    fetched_address_ += y_;
-
-    if ((fetched_address_ & 0xFF00) != (hi << 8) &&
-        kStoreOps.find(current_operation_.name_) == kStoreOps.end()) {
-        current_cycle_++; // Only for non-store ops
-    }
+    ResolveAddress<OpcodeInfo::AddrMode::kIzy>(Read(pc_++));
 }
 
 void CPU::ADR_REL() {
-    const auto offset = static_cast<int8_t>(Read(pc_++));
-    fetched_address_ = pc_ + offset;
+    const uint8_t offset = Read(pc_++);
+    ResolveAddress<OpcodeInfo::AddrMode::kRel>(offset);
 }
 
 
 // Operations
 void CPU::OP_ADC() {
     const uint8_t value = Fetch();
-    const uint16_t result = a_ + value + GetFlag(C);
+    const uint16_t result = a_ + value + carry_;
 
 
-    SetFlag(C, result > 0xFF); // Set carry flag if result exceeds 8 bits
-    SetFlag(Z, (result & 0x00FF) == 0x00); // Set zero flag if result is zero
-    SetFlag(V, ~(a_ ^ value) & (a_ ^ result) & 0x80); // Set overflow flag if the addition results in an overflow
-    SetFlag(N, result & 0x80);
+    carry_ = result > 0xFF; // Set carry flag if result exceeds 8 bits
+    overflow_ = ~(a_ ^ value) & (a_ ^ result); // Overflow if both operands differ in sign from the result
+    SetNZ(result & 0x00FF);
 
     a_ = result & 0x00FF;
 }
 
 void CPU::OP_AND() {
     a_ &= Fetch();
-    SetFlag(Z, a_ == 0x00);
-    SetFlag(N, a_ & 0x80); // Set negative flag if A is negative (bit 7 is set)
+    SetNZ(a_);
 }
 
 void CPU::OP_ASL() {
     // Shift A left and set carry flag if bit 7 is set
 
     const uint16_t temp = Fetch() << 1;
-    SetFlag(C, (temp & 0xFF00) > 0);
+    carry_ = (temp & 0xFF00) > 0;
 
-    if (current_addr_mode_ == &CPU::ADR_IMP) {
+    if (IsImpliedMode()) {
         a_ = temp & 0x00FF; // If the addressing mode is implicit, store the result in A
     }
     else {
         Write(fetched_address_, temp & 0x00FF); // Otherwise, write the result back to memory
     }
     // Set zero and negative flags based on the result
-    SetFlag(Z, (temp & 0x00FF) == 0x00);
-    SetFlag(N, temp & 0x80); // Set negative flag if A is negative (bit 7 is set)
+    SetNZ(temp & 0x00FF);
 }
 
 void CPU::OP_BCC() {
-    if (GetFlag(C) == 0) {
+    if (carry_ == 0) {
         current_cycle_++; // Branches taken use an extra cycle
         if ((fetched_address_ & 0xFF00) != (pc_ & 0xFF00))
             current_cycle_++; // Extra cycle if crossing page boundary
@@ -258,7 +497,7 @@ void CPU::OP_BCC() {
 }
 
 void CPU::OP_BCS() {
-    if (GetFlag(C) == 1) {
+    if (carry_ == 1) {
         current_cycle_++; // Branches taken use an extra cycle
         if ((fetched_address_ & 0xFF00) != (pc_ & 0xFF00))
             current_cycle_++; // Extra cycle if crossing page boundary
@@ -279,9 +518,9 @@ void CPU::OP_BEQ() {
 
 void CPU::OP_BIT() {
     const uint8_t value = Fetch();
-    SetFlag(Z, (a_ & value) == 0); // Set zero flag if A AND value is zero
-    SetFlag(N, value & 0x80); // Set negative flag if bit 7 of value is set
-    SetFlag(V, value & 0x40); // Set overflow flag if bit 6 of value is set
+    // Z comes from A AND value, N and V straight from bits 7 and 6 of value
+    nz_result_ = (a_ & value) | (value & 0x80) << 8;
+    overflow_ = value << 1;
 }
 
 void CPU::OP_BMI() {
@@ -323,7 +562,7 @@ void CPU::OP_BRK() {
 
     // Push the processor status to the stack
     SetFlag(B, true);
-    Write(0x100 + sp_--, p_);
+    Write(0x100 + sp_--, P());
     SetFlag(B, false);
 
     // Jump to the interrupt vector
@@ -351,7 +590,7 @@ void CPU::OP_BVS() {
 }
 
 void CPU::OP_CLC() {
-    SetFlag(C, false);
+    carry_ = false;
 }
 
 void CPU::OP_CLD() {
@@ -363,7 +602,7 @@ void CPU::OP_CLI() {
 }
 
 void CPU::OP_CLV() {
-    SetFlag(V, false);
+    overflow_ = 0x00;
 }
 
 void CPU::OP_CMP() {
@@ -371,13 +610,10 @@ void CPU::OP_CMP() {
     const uint8_t result = a_ - value;
 
     // Set carry flag if A >= value
-    SetFlag(C, a_ >= value);
+    carry_ = a_ >= value;
 
-    // Set zero flag if A == value
-    SetFlag(Z, a_ == value);
-
-    // Set negative flag based on the result
-    SetFlag(N, result & 0x80);
+    // Set zero and negative flags based on the difference
+    SetNZ(result);
 }
 
 void CPU::OP_CPX() {
@@ -385,13 +621,10 @@ void CPU::OP_CPX() {
     const uint8_t result = x_ - value;
 
     // Set carry flag if X >= value
-    SetFlag(C, x_ >= value);
-
-    // Set zero flag if X == value
-    SetFlag(Z, x_ == value);
+    carry_ = x_ >= value;
 
-    // Set negative flag based on the result
-    SetFlag(N, result & 0x80);
+    // Set zero and negative flags based on the difference
+    SetNZ(result);
 }
 
 void CPU::OP_CPY() {
@@ -399,13 +632,10 @@ void CPU::OP_CPY() {
     const uint8_t result = y_ - value;
 
     // Set carry flag if Y >= value
-    SetFlag(C, y_ >= value);
-
-    // Set zero flag if Y == value
-    SetFlag(Z, y_ == value);
+    carry_ = y_ >= value;
 
-    // Set negative flag based on the result
-    SetFlag(N, result & 0x80);
+    // Set zero and negative flags based on the difference
+    SetNZ(result);
 }
 
 void CPU::OP_DEC() {
@@ -414,26 +644,22 @@ void CPU::OP_DEC() {
     Write(fetched_address_, value);
 
     // Set zero and negative flags based on the decremented value
-    SetFlag(Z, value == 0);
-    SetFlag(N, value & 0x80);
+    SetNZ(value);
 }
 
 void CPU::OP_DEX() {
     x_--;
-    SetFlag(Z, x_ == 0);
-    SetFlag(N, x_ & 0x80);
+    SetNZ(x_);
 }
 
 void CPU::OP_DEY() {
     y_--;
-    SetFlag(Z, y_ == 0);
-    SetFlag(N, y_ & 0x80);
+    SetNZ(y_);
 }
 
 void CPU::OP_EOR() {
     a_ ^= Fetch();
-    SetFlag(Z, a_ == 0x00);
-    SetFlag(N, a_ & 0x80); // Set negative flag if A is negative (bit 7 is set)
+    SetNZ(a_);
 }
 
 void CPU::OP_INC() {
@@ -442,20 +668,17 @@ void CPU::OP_INC() {
     Write(fetched_address_, value);
 
     // Set zero and negative flags based on the incremented value
-    SetFlag(Z, value == 0);
-    SetFlag(N, value & 0x80);
+    SetNZ(value);
 }
 
 void CPU::OP_INX() {
     x_++;
-    SetFlag(Z, x_ == 0);
-    SetFlag(N, x_ & 0x80);
+    SetNZ(x_);
 }
 
 void CPU::OP_INY() {
     y_++;
-    SetFlag(Z, y_ == 0);
-    SetFlag(N, y_ & 0x80);
+    SetNZ(y_);
 }
 
 void CPU::OP_JMP() {
@@ -476,8 +699,7 @@ void CPU::OP_LDA() {
     a_ = Fetch();
 
     // Set zero and negative flags based on A
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80); // Set negative flag if A is negative (bit 7 is set)
+    SetNZ(a_);
 }
 
 void CPU::OP_LDX() {
@@ -485,8 +707,7 @@ void CPU::OP_LDX() {
     x_ = Fetch();
 
     // Set zero and negative flags based on X
-    SetFlag(Z, x_ == 0);
-    SetFlag(N, x_ & 0x80); // Set negative flag if X is negative (bit 7 is set)
+    SetNZ(x_);
 }
 
 void CPU::OP_LDY() {
@@ -494,25 +715,23 @@ void CPU::OP_LDY() {
     y_ = Fetch();
 
     // Set zero and negative flags based on Y
-    SetFlag(Z, y_ == 0);
-    SetFlag(N, y_ & 0x80); // Set negative flag if Y is negative (bit 7 is set)
+    SetNZ(y_);
 }
 
 void CPU::OP_LSR() {
     // Logical Shift Right
     const uint8_t value = Fetch();
-    SetFlag(C, value & 0x01); // Set carry flag if bit 0 is set
+    carry_ = value & 0x01; // Set carry flag if bit 0 is set
     const uint8_t temp = value >> 1; // Shift A right by 1
 
-    if (current_addr_mode_ == &CPU::ADR_IMP) {
+    if (IsImpliedMode()) {
         a_ = temp; // If the addressing mode is implicit, store the result in A
     }
     else {
         Write(fetched_address_, temp); // Otherwise, write the result back to memory
     }
     // Set zero and negative flags based on A
-    SetFlag(Z, temp == 0);
-    SetFlag(N, temp & 0x80); // Set negative flag if A is negative (bit 7 is set)
+    SetNZ(temp);
 }
 
 void CPU::OP_NOP() {
@@ -521,8 +740,7 @@ void CPU::OP_NOP() {
 
 void CPU::OP_ORA() {
     a_ |= Fetch(); // Bitwise OR with the accumulator
-    SetFlag(Z, a_ == 0x00); // Set zero flag if A is zero
-    SetFlag(N, a_ & 0x80); // Set negative flag if A is negative (bit 7 is set)
+    SetNZ(a_);
 }
 
 void CPU::OP_PHA() {
@@ -533,7 +751,7 @@ void CPU::OP_PHA() {
 void CPU::OP_PHP() {
     // Push the processor status onto the stack
     SetFlag(B, true);
-    Write(0x100 + sp_--, p_);
+    Write(0x100 + sp_--, P());
     SetFlag(B, false);
 }
 
@@ -542,13 +760,12 @@ void CPU::OP_PLA() {
     a_ = Read(0x100 + ++sp_);
 
     // Set zero and negative flags based on A
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80); // Set negative flag if A is negative (bit 7 is set)
+    SetNZ(a_);
 }
 
 void CPU::OP_PLP() {
     // Read new status from stack
-    p_ = Read(0x100 + ++sp_);
+    set_P(Read(0x100 + ++sp_));
     SetFlag(B, false);
     SetFlag(R, true);
 }
@@ -556,37 +773,35 @@ void CPU::OP_PLP() {
 void CPU::OP_ROL() {
     // Rotate Left
     const uint8_t value = Fetch();
-    const bool carry = GetFlag(C);
-    SetFlag(C, value & 0x80); // Set carry flag if bit 7 is set
+    const bool carry = carry_;
+    carry_ = value & 0x80; // Set carry flag if bit 7 is set
     const uint8_t temp = (value << 1) | (carry ? 1 : 0); // Shift A left and set bit 0 to previous carry
 
-    if (current_addr_mode_ == &CPU::ADR_IMP) {
+    if (IsImpliedMode()) {
         a_ = temp; // If the addressing mode is implicit, store the result in A
     }
     else {
         Write(fetched_address_, temp); // Otherwise, write the result back to memory
     }
     // Set zero and negative flags based on A
-    SetFlag(Z, temp == 0);
-    SetFlag(N, temp & 0x80); // Set negative flag if A is negative (bit 7 is set)
+    SetNZ(temp);
 }
 
 void CPU::OP_ROR() {
     // Rotate Right
     const uint8_t value = Fetch();
-    const bool carry = GetFlag(C);
-    SetFlag(C, value & 0x01); // Set carry flag if bit 0 is set
+    const bool carry = carry_;
+    carry_ = value & 0x01; // Set carry flag if bit 0 is set
     const uint8_t temp = value >> 1 | (carry ? 0x80 : 0); // Shift A right and set bit 7 to previous carry
 
-    if (current_addr_mode_ == &CPU::ADR_IMP) {
+    if (IsImpliedMode()) {
         a_ = temp; // If the addressing mode is implicit, store the result in A
     }
     else {
         Write(fetched_address_, temp); // Otherwise, write the result back to memory
     }
     // Set zero and negative flags based on A
-    SetFlag(Z, temp == 0);
-    SetFlag(N, temp & 0x80); // Set negative flag if A is negative (bit 7 is set)
+    SetNZ(temp);
 }
 
 void CPU::OP_RTS() {
@@ -604,18 +819,17 @@ void CPU::OP_SBC() {
 
     // Invert the value and use ADC operation
     // SBC is essentially ADC with the ones complement of the operand
-    const uint16_t result = a_ + (~value & 0xFF) + GetFlag(C);
+    const uint16_t result = a_ + (~value & 0xFF) + carry_;
 
-    SetFlag(C, result > 0xFF); // Set carry flag if result exceeds 8 bits
-    SetFlag(Z, (result & 0x00FF) == 0x00); // Set zero flag if result is zero
-    SetFlag(V, (a_ ^ value) & (a_ ^ result) & 0x80); // Set overflow flag if the addition results in an overflow
-    SetFlag(N, result & 0x80);
+    carry_ = result > 0xFF; // Set carry flag if result exceeds 8 bits
+    overflow_ = (a_ ^ value) & (a_ ^ result); // Overflow if the operands differ in sign and A changed sign
+    SetNZ(result & 0x00FF);
 
     a_ = result & 0x00FF;
 }
 
 void CPU::OP_SEC() {
-    SetFlag(C, true);
+    carry_ = true;
 }
 
 void CPU::OP_SED() {
@@ -646,8 +860,7 @@ void CPU::OP_TAX() {
     x_ = a_;
 
     // Set zero and negative flags based on X
-    SetFlag(Z, x_ == 0);
-    SetFlag(N, x_ & 0x80); // Set negative flag if X is negative (bit 7 is set)
+    SetNZ(x_);
 }
 
 void CPU::OP_TAY() {
@@ -655,8 +868,7 @@ void CPU::OP_TAY() {
     y_ = a_;
 
     // Set zero and negative flags based on Y
-    SetFlag(Z, y_ == 0);
-    SetFlag(N, y_ & 0x80); // Set negative flag if Y is negative (bit 7 is set)
+    SetNZ(y_);
 }
 
 void CPU::OP_TSX() {
@@ -664,8 +876,7 @@ void CPU::OP_TSX() {
     x_ = sp_;
 
     // Set zero and negative flags based on X
-    SetFlag(Z, x_ == 0);
-    SetFlag(N, x_ & 0x80); // Set negative flag if X is negative (bit 7 is set)
+    SetNZ(x_);
 }
 
 void CPU::OP_TXA() {
@@ -673,8 +884,7 @@ void CPU::OP_TXA() {
     a_ = x_;
 
     // Set zero and negative flags based on A
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80); // Set negative flag if A is negative (bit 7 is set)
+    SetNZ(a_);
 }
 
 void CPU::OP_TXS() {
@@ -689,8 +899,7 @@ void CPU::OP_TYA() {
     a_ = y_;
 
     // Set zero and negative flags based on A
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80); // Set negative flag if A is negative (bit 7 is set)
+    SetNZ(a_);
 }
 
 // LAX: Load A and X with memory (unofficial)
@@ -698,8 +907,7 @@ void CPU::OP_LAX() {
     const uint8_t value = Fetch();
     a_ = value;
     x_ = value;
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80);
+    SetNZ(a_);
 }
 
 // SAX: Store A & X (unofficial)
@@ -715,81 +923,74 @@ void CPU::OP_DCP() {
 
     // Compare with accumulator
     const uint8_t result = a_ - value;
-    SetFlag(C, a_ >= value);
-    SetFlag(Z, a_ == value);
-    SetFlag(N, result & 0x80);
+    carry_ = a_ >= value;
+    SetNZ(result);
 }
 
 // SLO: ASL memory, then ORA with accumulator (unofficial)
 void CPU::OP_SLO() {
     // Perform ASL on memory
     uint8_t value = Fetch();
-    SetFlag(C, value & 0x80); // Set carry if bit 7 was set
+    carry_ = value & 0x80; // Set carry if bit 7 was set
     value <<= 1;
     Write(fetched_address_, value);
 
     // ORA with accumulator
     a_ |= value;
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80);
+    SetNZ(a_);
 }
 
 void CPU::OP_ANC() {
     a_ &= Fetch();
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80);
-    SetFlag(C, a_ & 0x80); // Carry = Negative
+    SetNZ(a_);
+    carry_ = a_ & 0x80; // Carry = Negative
 }
 
 void CPU::OP_RLA() {
     // Rotate memory left
     uint8_t value = Fetch();
-    const bool old_carry = GetFlag(C);
-    SetFlag(C, value & 0x80);
+    const bool old_carry = carry_;
+    carry_ = value & 0x80;
     value = (value << 1) | (old_carry ? 1 : 0);
     Write(fetched_address_, value);
 
     // AND with accumulator
     a_ &= value;
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80);
+    SetNZ(a_);
 }
 
 void CPU::OP_SRE() {
     // LSR memory
     uint8_t value = Fetch();
-    SetFlag(C, value & 0x01); // Carry = old bit 0
+    carry_ = value & 0x01; // Carry = old bit 0
     value >>= 1;
     Write(fetched_address_, value);
 
     // EOR with accumulator
     a_ ^= value;
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80);
+    SetNZ(a_);
 }
 
 // RRA: ROR memory, then ADC (unofficial)
 void CPU::OP_RRA() {
     uint8_t value = Fetch();
-    const bool old_carry = GetFlag(C);
-    SetFlag(C, value & 0x01);
+    const bool old_carry = carry_;
+    carry_ = value & 0x01;
     value = (value >> 1) | (old_carry ? 0x80 : 0);
     Write(fetched_address_, value);
 
     // ADC with rotated value
-    const uint16_t result = a_ + value + GetFlag(C);
-    SetFlag(C, result > 0xFF);
-    SetFlag(Z, (result & 0xFF) == 0);
-    SetFlag(V, (~(a_ ^ value) & (a_ ^ result) & 0x80));
-    SetFlag(N, result & 0x80);
+    const uint16_t result = a_ + value + carry_;
+    carry_ = result > 0xFF;
+    overflow_ = ~(a_ ^ value) & (a_ ^ result);
+    SetNZ(result & 0xFF);
     a_ = result & 0xFF;
 }
 
 // XAA: A = X & immediate (unofficial, highly unstable)
 void CPU::OP_XAA() {
     a_ = x_ & Fetch();
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80);
+    SetNZ(a_);
 }
 
 // TAS: (a.k.a. SHS) S = A & X, store (A & X) & (hi+1) at address (unofficial)
@@ -814,25 +1015,22 @@ void CPU::OP_SHX() {
 // LXA: A = X = A & immediate (unofficial, unstable)
 void CPU::OP_LXA() {
     a_ = x_ = (a_ & Fetch());
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80);
+    SetNZ(a_);
 }
 
 // LAS: A, X, S = memory & S (unofficial)
 void CPU::OP_LAS() {
     const uint8_t value = Fetch() & sp_;
     a_ = x_ = sp_ = value;
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80);
+    SetNZ(a_);
 }
 
 // AXS: X = (A & X) - immediate (unofficial)
 void CPU::OP_AXS() {
     const uint8_t orig_value = Fetch();
     const uint8_t value = (a_ & x_) - orig_value;
-    SetFlag(C, (a_ & x_) >= orig_value);
-    SetFlag(Z, value == 0);
-    SetFlag(N, value & 0x80);
+    carry_ = (a_ & x_) >= orig_value;
+    SetNZ(value);
     x_ = value;
 }
 
@@ -842,30 +1040,27 @@ void CPU::OP_ISC() {
     Write(fetched_address_, value);
 
     // SBC with incremented value
-    const uint16_t result = a_ + (~value & 0xFF) + GetFlag(C);
-    SetFlag(C, result > 0xFF);
-    SetFlag(Z, (result & 0xFF) == 0);
-    SetFlag(V, (a_ ^ value) & (a_ ^ result) & 0x80);
-    SetFlag(N, result & 0x80);
+    const uint16_t result = a_ + (~value & 0xFF) + carry_;
+    carry_ = result > 0xFF;
+    overflow_ = (a_ ^ value) & (a_ ^ result);
+    SetNZ(result & 0xFF);
     a_ = result & 0xFF;
 }
 
 void CPU::OP_ARR() {
     a_ &= Fetch();
-    a_ = (a_ >> 1) | (GetFlag(C) ? 0x80 : 0);
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80);
-    SetFlag(C, a_ & 0x40);
-    SetFlag(V, ((a_ & 0x40) >> 6) ^ ((a_ & 0x20) >> 5));
+    a_ = (a_ >> 1) | (carry_ ? 0x80 : 0);
+    SetNZ(a_);
+    carry_ = a_ & 0x40;
+    overflow_ = ((a_ << 1) ^ (a_ << 2)) & 0x80; // Bit 6 XOR bit 5
 }
 
 void CPU::OP_ASR() {
     // ASR: AND with immediate, then LSR A
     a_ &= Fetch();
-    SetFlag(C, a_ & 0x01);
+    carry_ = a_ & 0x01;
     a_ >>= 1;
-    SetFlag(Z, a_ == 0);
-    SetFlag(N, a_ & 0x80);
+    SetNZ(a_);
 }
 
 void CPU::OP_UNF() {
@@ -874,12 +1069,38 @@ void CPU::OP_UNF() {
 }
 
 void CPU::SetFlag(const Flags flag, const bool value) {
-    if (value)
-        p_ |= (1 << flag);
-    else
-        p_ &= ~(1 << flag);
+    switch (flag) {
+        case C:
+            carry_ = value;
+            break;
+        case Z:
+            nz_result_ = (value ? 0x0000 : 0x0001) | (nz_result_ & 0x8080 ? 0x8000 : 0x0000);
+            break;
+        case V:
+            overflow_ = value ? 0x80 : 0x00;
+            break;
+        case N:
+            nz_result_ = (nz_result_ & 0x00FF ? 0x0001 : 0x0000) | (value ? 0x8000 : 0x0000);
+            break;
+        default:
+            if (value)
+                p_ |= (1 << flag);
+            else
+                p_ &= ~(1 << flag);
+    }
 }
 
 bool CPU::GetFlag(const Flags flag) const {
-    return (p_ >> flag) & 1;
+    switch (flag) {
+        case C:
+            return carry_;
+        case Z:
+            return (nz_result_ & 0x00FF) == 0;
+        case V:
+            return overflow_ & 0x80;
+        case N:
+            return nz_result_ & 0x8080;
+        default:
+            return (p_ >> flag) & 1;
+    }
 }
@@ -2,9 +2,13 @@
 
 #include <cstdint>
 #include <array>
-#include <set>
 #include <string>
+#include <utility>
 
+#include "instruction_cache.h"
+#include "jit_compiler.h"
+#include "opcode_info.h"
+#include "superinstructions.h"
 #include "cartridge/cartridge.h"
 
 class Bus; // Forward declaration
@@ -32,6 +36,25 @@ public:
         N = 7 // Negative
     };
 
+    // Flags kept in p_, the others are evaluated lazily
+    static constexpr uint8_t kStoredFlags = (1 << I) | (1 << D) | (1 << B) | (1 << R);
+
+    // Interpreter core used by Step()
+    // kTable:  dispatches through the member function pointers stored in kOpcodeTable
+    // kSwitch: dispatches on the opcode byte through a dense switch, with the addressing mode
+    //          and operation of each opcode resolved at compile time and inlined in its case
+    // kCached: runs PRG ROM code from a cache of pre-decoded instructions, falling back to
+    //          kSwitch for code in RAM or PRG RAM
+    // kJit:    runs hot PRG ROM basic blocks as native x86-64 code, falling back to kCached.
+    //          Blocks run all their instructions at once, so interrupts are only taken at
+    //          block boundaries.
+    enum class Core {
+        kTable,
+        kSwitch,
+        kCached,
+        kJit
+    };
+
     // =====================
     // === Public API ======
     // =====================
@@ -46,11 +69,28 @@ public:
     // Emulation step
     void Step();
     void StepInstruction();
+
+    // Runs whole instructions back to back until the cycle budget is used up, with the same
+    // per-cycle results as calling Step() that many times. Returns the overshoot: the cycles
+    // the last instruction still takes past the budget, which the next Run() or Step() finish.
+    int32_t Run(int32_t cycles);
+
+    // Ends the current Run() once the cycle in progress is done, for events that must not
+    // happen ahead of the rest of the system (OAM DMA)
+    void EndRun() {
+        if (run_cycles_ > 1) run_cycles_ = 1;
+    }
+
     void Reset();
     void IRQ();
     void NMI();
     void RTI();
 
+    // Level of the IRQ line, which cartridge hardware holds asserted until it is acknowledged.
+    // It is sampled before every instruction and taken while the I flag is clear.
+    void SetIrqLine(const bool asserted) { irq_line_ = asserted; }
+    [[nodiscard]] bool IrqLine() const { return irq_line_; }
+
     // Addressing modes
     void ADR_IMP(), ADR_IMM(), ADR_REL(), ADR_ZP0(),
          ADR_ZPX(), ADR_ZPY(), ADR_ABS(), ADR_ABX(),
@@ -62,16 +102,29 @@ private:
     // =====================
     uint8_t a_, x_, y_, sp_;
     uint16_t pc_;
-    uint8_t p_; // Flags register
+    uint8_t p_; // Flags register, only I, D, B and R are kept up to date here
+
+    // Lazily evaluated flags. Instructions store the raw result and P() folds them into the
+    // status byte only when it is observed (PHP, interrupts, the debugger).
+    uint16_t nz_result_; // Z if the low byte is zero, N if bit 7 or bit 15 is set
+    uint8_t overflow_; // V is bit 7
+    bool carry_;
 
     // Cycles
     uint8_t current_cycle_;
-    uint32_t total_cycles_;
+    uint64_t total_cycles_;
+    int32_t run_cycles_ = 0; // Budget left in the current Run()
+    bool irq_line_ = false;
 
     // Addressing fetch variables
     uint16_t fetched_address_;
-    void (CPU::*current_addr_mode_)();
-    Operation current_operation_;
+    uint8_t current_opcode_ = 0x00;
+
+    Core core_ = Core::kCached;
+    InstructionCache instruction_cache_;
+    bool fusion_enabled_ = false;
+    std::array<uint64_t, Superinstructions::kPairs.size()> fused_counts_{}; // Executions per pair
+    JitCompiler jit_;
 
     // Linkto  bus
     Bus* bus_ = nullptr;
@@ -87,11 +140,37 @@ private:
     void OP_ISC(), OP_ARR(), OP_ASR();
     void OP_UNF();
 
-    // Store instructions list, used in page crossing checks
-    const std::set<std::string> kStoreOps = {
-        "STA", "STX", "STY", "SAX", "SHA", "SHX", "SHY", "TAS", "ISC",
-        "SLO", "RLA", "SRE", "RRA", "DCP", "ISB"
-    };
+    // Effective address resolution from the raw operand bytes, shared by all cores
+    template <OpcodeInfo::AddrMode kMode>
+    void ResolveAddress(uint16_t operand);
+
+    // Decodes and executes the instruction at pc_ with the selected core
+    void Dispatch();
+
+    // Switch core dispatch
+    void ExecuteSwitch(uint8_t opcode);
+    template <uint8_t kOpcode>
+    void Execute();
+
+    // Cached core dispatch
+    bool ExecuteCached();
+    template <uint8_t kOpcode>
+    void ExecuteDecoded(const InstructionCache::Entry& entry);
+    template <size_t... kOpcodes>
+    static constexpr std::array<InstructionCache::Handler, 256> MakeDecodedHandlers(std::index_sequence<kOpcodes...>);
+    static const std::array<InstructionCache::Handler, 256> kDecodedHandlers;
+
+    // Superinstructions
+    void Fuse(InstructionCache::Entry& entry);
+    template <size_t kPair>
+    void ExecuteFused(const InstructionCache::Entry& entry);
+    template <size_t... kPairs>
+    static constexpr std::array<InstructionCache::Handler, Superinstructions::kPairs.size()> MakeFusedHandlers(
+        std::index_sequence<kPairs...>);
+    static const std::array<InstructionCache::Handler, Superinstructions::kPairs.size()> kFusedHandlers;
+
+    // JIT core dispatch
+    bool ExecuteJit();
 
     static constexpr std::array<Operation, 256> kOpcodeTable = {
         {
@@ -389,7 +468,7 @@ public:
     // =====================
     // == Getters/Setters ==
     // =====================
-    [[nodiscard]] uint32_t TotalCycles() const {
+    [[nodiscard]] uint64_t TotalCycles() const {
         return total_cycles_;
     }
 
@@ -434,20 +513,55 @@ public:
     }
 
     [[nodiscard]] uint8_t P() const {
-        return p_;
+        return (p_ & kStoredFlags) | carry_ << C | ((nz_result_ & 0x00FF) == 0) << Z |
+               (overflow_ & 0x80) >> (7 - V) | ((nz_result_ & 0x8080) != 0) << N;
     }
 
     void set_P(const uint8_t p) {
-        p_ = p;
+        p_ = p & kStoredFlags;
+        carry_ = p & (1 << C);
+        nz_result_ = (p & (1 << Z) ? 0x0000 : 0x0001) | (p & (1 << N)) << 8;
+        overflow_ = p << (7 - V);
     }
 
-    [[nodiscard]] static Operation GetOpcodeEntry(const uint8_t opcode) {
+    [[nodiscard]] Core GetCore() const {
+        return core_;
+    }
+
+    void set_core(const Core core) {
+        core_ = core;
+    }
+
+    [[nodiscard]] JitCompiler& Jit() {
+        return jit_;
+    }
+
+    // Lets the cached core run the instruction pairs of Superinstructions::kPairs as a single
+    // dispatch. A pair then behaves like one long instruction, so interrupts are only taken
+    // between pairs. Changing the setting drops the decoded instructions.
+    void set_fusion_enabled(bool enabled);
+
+    [[nodiscard]] bool FusionEnabled() const {
+        return fusion_enabled_;
+    }
+
+    // Executions of each pair of Superinstructions::kPairs, every one saved a dispatch
+    [[nodiscard]] const std::array<uint64_t, Superinstructions::kPairs.size()>& FusedCounts() const {
+        return fused_counts_;
+    }
+
+    [[nodiscard]] static const Operation& GetOpcodeEntry(const uint8_t opcode) {
         return kOpcodeTable[opcode];
     }
 
     // Flag manipulation functions
     void SetFlag(Flags flag, bool value);
 
+    // Records the result Z and N are derived from
+    void SetNZ(const uint8_t value) {
+        nz_result_ = value;
+    }
+
     [[nodiscard]] bool GetFlag(Flags flag) const;
 
     // Bus link and reading/writing
@@ -459,8 +573,13 @@ public:
         return current_cycle_ == 0;
     }
 
+    // Implied mode instructions operate on the accumulator
+    [[nodiscard]] bool IsImpliedMode() const {
+        return OpcodeInfo::Get(current_opcode_).addr_mode_ == OpcodeInfo::AddrMode::kImp;
+    }
+
     uint8_t Fetch() {
-        if (current_addr_mode_ == &CPU::ADR_IMP) {
+        if (IsImpliedMode()) {
             return a_;
         }
         return Read(fetched_address_);
@@ -0,0 +1,56 @@
+#include "instruction_cache.h"
+
+#include <algorithm>
+
+#include "cartridge/cartridge.h"
+
+bool InstructionCache::Attach(const Cartridge* cartridge) {
+    // PRG ROM never changes, so a reset on the same cartridge keeps the decoded entries
+    if (cartridge == cartridge_ && cartridge_ && entries_.size() == cartridge_->prg_rom_.size()) {
+        RefreshWindows();
+        return false;
+    }
+
+    cartridge_ = cartridge;
+    entries_.assign(cartridge_ ? cartridge_->prg_rom_.size() : 0, Entry{});
+    RefreshWindows();
+    return true;
+}
+
+void InstructionCache::Clear() {
+    std::fill(entries_.begin(), entries_.end(), Entry{});
+}
+
+InstructionCache::Entry* InstructionCache::Lookup(const uint16_t address) {
+    const uint32_t offset = MapAddress(address);
+    if (offset == kUnmapped) return nullptr;
+    return &entries_[offset];
+}
+
+uint32_t InstructionCache::MapAddress(const uint16_t address) {
+    if (entries_.empty()) return kUnmapped;
+
+    // Bank switches only move the windows, entries stay valid as PRG ROM never changes
+    if (cartridge_->PrgWindowVersion() != window_version_) {
+        RefreshWindows();
+    }
+
+    const uint32_t offset = window_offset_[(address >> 13) & 0x03];
+    if (offset == kUnmapped) return kUnmapped;
+    return offset + (address % kWindowSize);
+}
+
+void InstructionCache::RefreshWindows() {
+    window_version_ = cartridge_ ? cartridge_->PrgWindowVersion() : 0;
+
+    for (uint32_t window = 0; window < window_offset_.size(); window++) {
+        window_offset_[window] = kUnmapped;
+        if (entries_.empty()) continue;
+
+        const uint32_t offset = cartridge_->MapPrgAddress(0x8000 + window * kWindowSize);
+        // Only cache windows that are fully backed by PRG ROM
+        if (offset != kUnmapped && offset % kWindowSize == 0 && offset + kWindowSize <= entries_.size()) {
+            window_offset_[window] = offset;
+        }
+    }
+}
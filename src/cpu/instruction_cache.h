@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class CPU;
+class Cartridge;
+
+// Cache of pre-decoded instructions for code running from PRG ROM ($8000-$FFFF).
+// Entries are keyed by the mapped PRG ROM offset, so they stay valid across bank switches;
+// only the CPU address -> PRG offset windows are recomputed when the mapper reports a change.
+// Code running from RAM or PRG RAM is never cached, so writes there cannot leave stale entries.
+class InstructionCache {
+public:
+    // =====================
+    // === Types & Consts ===
+    // =====================
+    struct Entry;
+    using Handler = void (CPU::*)(const Entry& entry);
+
+    // A single instruction, or a pair of instructions fused into a superinstruction
+    struct Entry {
+        Handler handler_ = nullptr; // nullptr until decoded
+        uint16_t operand_ = 0x0000; // Raw operand bytes (little endian)
+        uint16_t fused_operand_ = 0x0000; // Raw operand bytes of the second instruction of a pair
+        uint8_t length_ = 0; // Length in bytes
+        uint8_t cycles_ = 0; // Base cycles, without page crossing or branch penalties
+    };
+
+    static constexpr uint32_t kWindowSize = 8 * 1024; // Smallest PRG bank size tracked
+    static constexpr uint32_t kUnmapped = 0xFFFFFFFF;
+
+    // =====================
+    // === Public API ======
+    // =====================
+    // Resizes the cache for the cartridge PRG ROM, dropping every entry if the cartridge changed.
+    // Returns true if the entries were dropped.
+    bool Attach(const Cartridge* cartridge);
+
+    // Drops every decoded entry, keeping the windows
+    void Clear();
+
+    // Returns the entry for the instruction at a CPU address in $8000-$FFFF,
+    // or nullptr if that address is not backed by PRG ROM
+    [[nodiscard]] Entry* Lookup(uint16_t address);
+
+    // Returns the PRG ROM offset of a CPU address in $8000-$FFFF, or kUnmapped if that address
+    // is not backed by a cached window
+    [[nodiscard]] uint32_t MapAddress(uint16_t address);
+
+    // Number of PRG ROM offsets covered
+    [[nodiscard]] size_t Size() const {
+        return entries_.size();
+    }
+
+    // Returns true if an instruction of the given length at address fits in its window,
+    // i.e. its bytes are contiguous in PRG ROM whatever the bank configuration
+    [[nodiscard]] static bool FitsInWindow(const uint16_t address, const uint8_t length) {
+        return (address % kWindowSize) + length <= kWindowSize;
+    }
+
+private:
+    // =====================
+    // === Internal State ==
+    // =====================
+    const Cartridge* cartridge_ = nullptr;
+    std::vector<Entry> entries_; // Indexed by PRG ROM offset
+    std::array<uint32_t, 4> window_offset_{}; // PRG ROM offset of each 8KB window at $8000-$FFFF
+    uint32_t window_version_ = 0;
+
+    void RefreshWindows();
+};
@@ -0,0 +1,738 @@
+#include "jit_compiler.h"
+
+#include <array>
+#include <cstring>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "cpu.h"
+#include "instruction_cache.h"
+
+namespace {
+    using Reg = X64Emitter::Reg;
+    using Mnemonic = OpcodeInfo::Mnemonic;
+    using AddrMode = OpcodeInfo::AddrMode;
+    using Access = OpcodeInfo::Access;
+
+    // Registers pinned for the whole block, all callee saved in both the System V and Microsoft ABIs
+    constexpr Reg kContext = Reg::kRbx;
+    constexpr Reg kRam = Reg::kR12;
+    constexpr Reg kNZTable = Reg::kR13;
+    constexpr Reg kCycles = Reg::kR14;
+
+    constexpr int32_t kA = offsetof(JitCompiler::Context, a_);
+    constexpr int32_t kX = offsetof(JitCompiler::Context, x_);
+    constexpr int32_t kY = offsetof(JitCompiler::Context, y_);
+    constexpr int32_t kSP = offsetof(JitCompiler::Context, sp_);
+    constexpr int32_t kP = offsetof(JitCompiler::Context, p_);
+    constexpr int32_t kPC = offsetof(JitCompiler::Context, pc_);
+
+    constexpr uint8_t kFlagC = 1 << CPU::C;
+    constexpr uint8_t kFlagZ = 1 << CPU::Z;
+    constexpr uint8_t kFlagI = 1 << CPU::I;
+    constexpr uint8_t kFlagD = 1 << CPU::D;
+    constexpr uint8_t kFlagB = 1 << CPU::B;
+    constexpr uint8_t kFlagR = 1 << CPU::R;
+    constexpr uint8_t kFlagV = 1 << CPU::V;
+    constexpr uint8_t kFlagN = 1 << CPU::N;
+
+    constexpr std::array<uint8_t, 256> MakeNZFlags() {
+        std::array<uint8_t, 256> table{};
+        for (int value = 0; value < 256; value++) {
+            table[value] = (value == 0 ? kFlagZ : 0) | (value & kFlagN);
+        }
+        return table;
+    }
+
+    constexpr std::array<uint8_t, 256> kNZFlags = MakeNZFlags(); // N and Z flags of every byte value
+
+    // Makes the whole pages covering size bytes at address read/execute or read/write, never both
+    // writable and executable. Returns false if the system refuses.
+    bool ProtectCode(uint8_t* address, const size_t size, const bool executable) {
+#if defined(_WIN32)
+        DWORD previous;
+        return VirtualProtect(address, size, executable ? PAGE_EXECUTE_READ : PAGE_READWRITE, &previous) != 0;
+#else
+        static const auto kPageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const uintptr_t first = reinterpret_cast<uintptr_t>(address) & ~(kPageSize - 1);
+        const uintptr_t end = reinterpret_cast<uintptr_t>(address) + size;
+        return mprotect(reinterpret_cast<void*>(first), end - first,
+                        executable ? PROT_READ | PROT_EXEC : PROT_READ | PROT_WRITE) == 0;
+#endif
+    }
+
+    // Reads outside of RAM go back through the bus, PRG ROM and PRG RAM reads have no side effects
+    uint8_t ReadHelper(CPU* cpu, const uint16_t address) {
+        return cpu->Read(address);
+    }
+
+    // Register the instruction loads or stores, for the register family of an opcode
+    int32_t RegisterOffset(const Mnemonic mnemonic) {
+        switch (mnemonic) {
+        case Mnemonic::LDX: case Mnemonic::STX: case Mnemonic::CPX:
+        case Mnemonic::INX: case Mnemonic::DEX:
+            return kX;
+        case Mnemonic::LDY: case Mnemonic::STY: case Mnemonic::CPY:
+        case Mnemonic::INY: case Mnemonic::DEY:
+            return kY;
+        default:
+            return kA;
+        }
+    }
+}
+
+// =====================
+// === Public API ======
+// =====================
+JitCompiler::~JitCompiler() {
+    if (code_buffer_ == nullptr) return;
+#if defined(_WIN32)
+    VirtualFree(code_buffer_, 0, MEM_RELEASE);
+#else
+    munmap(code_buffer_, kCodeBufferSize);
+#endif
+}
+
+bool JitCompiler::IsSupported() {
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void JitCompiler::Attach(const size_t prg_rom_size) {
+    blocks_.assign(prg_rom_size, Block{});
+    code_used_ = 0;
+    compiled_blocks_ = 0;
+}
+
+JitCompiler::BlockFn JitCompiler::Lookup(CPU& cpu, const uint16_t address, const uint32_t prg_offset) {
+    if (prg_offset >= blocks_.size()) return nullptr;
+
+    Block& block = blocks_[prg_offset];
+    if (block.address_ != address) {
+        // The same PRG bank is now mapped at another CPU address, the compiled addresses are stale
+        block = Block{};
+        block.address_ = address;
+    }
+    if (block.code_ != nullptr || block.failed_) return block.code_;
+
+    if (++block.hits_ < hot_threshold_) return nullptr;
+
+    block.code_ = Compile(cpu, address);
+    block.failed_ = block.code_ == nullptr;
+    return block.code_;
+}
+
+// =====================
+// === Internal ========
+// =====================
+JitCompiler::BlockFn JitCompiler::Compile(CPU& cpu, const uint16_t address) {
+    if (!IsSupported()) return nullptr;
+
+    X64Emitter emitter;
+    EmitPrologue(emitter);
+
+    // Side exits of each instruction, taken before it changes any state
+    std::vector<std::pair<std::vector<X64Emitter::Label>, uint16_t>> side_exits;
+
+    uint16_t pc = address;
+    uint32_t instructions = 0;
+    uint32_t cycles = 0;
+    bool terminated = false;
+    while (!terminated && instructions < kMaxBlockInstructions && cycles < kMaxBlockCycles) {
+        const uint8_t opcode = cpu.Read(pc);
+        const uint8_t length = OpcodeInfo::Get(opcode).length_;
+
+        // Stay inside the window of the first instruction, so the block is contiguous in PRG ROM
+        if ((pc & ~(InstructionCache::kWindowSize - 1)) != (address & ~(InstructionCache::kWindowSize - 1)) ||
+            !InstructionCache::FitsInWindow(pc, length)) {
+            break;
+        }
+
+        uint16_t operand = 0x0000;
+        if (length > 1) operand |= cpu.Read(pc + 1);
+        if (length > 2) operand |= cpu.Read(pc + 2) << 8;
+
+        std::vector<X64Emitter::Label> exits;
+        if (!EmitInstruction(emitter, pc, opcode, operand, exits, terminated)) break;
+        if (!exits.empty()) side_exits.emplace_back(std::move(exits), pc);
+
+        instructions++;
+        cycles += CPU::GetOpcodeEntry(opcode).cycles_;
+        pc += length;
+
+        // A pending IRQ is only sampled between blocks, so one that CLI or PLP unmasks is taken
+        // right after them
+        const Mnemonic mnemonic = OpcodeInfo::Get(opcode).mnemonic_;
+        if (mnemonic == Mnemonic::CLI || mnemonic == Mnemonic::PLP) break;
+    }
+
+    if (instructions == 0) return nullptr;
+
+    if (!terminated) EmitExit(emitter, pc);
+    for (const auto& [labels, exit_pc] : side_exits) {
+        for (const X64Emitter::Label label : labels) {
+            emitter.Bind(label);
+        }
+        EmitExit(emitter, exit_pc);
+    }
+
+    if (code_buffer_ == nullptr) {
+#if defined(_WIN32)
+        code_buffer_ = static_cast<uint8_t*>(
+            VirtualAlloc(nullptr, kCodeBufferSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+#else
+        void* buffer = mmap(nullptr, kCodeBufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        code_buffer_ = buffer == MAP_FAILED ? nullptr : static_cast<uint8_t*>(buffer);
+#endif
+        if (code_buffer_ == nullptr) return nullptr;
+    }
+    if (code_used_ + emitter.Size() > kCodeBufferSize) {
+        Flush();
+    }
+
+    // The pages are only writable while the block is copied in, which may share its first page
+    // with the blocks before it
+    uint8_t* code = code_buffer_ + code_used_;
+    if (!ProtectCode(code, emitter.Size(), false)) return nullptr;
+    std::memcpy(code, emitter.Code().data(), emitter.Size());
+    if (!ProtectCode(code, emitter.Size(), true)) {
+        Flush(); // The blocks sharing the page cannot run either
+        return nullptr;
+    }
+    code_used_ += emitter.Size();
+    compiled_blocks_++;
+    return reinterpret_cast<BlockFn>(code);
+}
+
+// Drops every compiled block once the code buffer is full
+void JitCompiler::Flush() {
+    for (Block& block : blocks_) {
+        block.code_ = nullptr;
+        block.hits_ = 0;
+    }
+    code_used_ = 0;
+}
+
+// =====================
+// === Code Generation =
+// =====================
+bool JitCompiler::EmitInstruction(X64Emitter& emitter, const uint16_t pc, const uint8_t opcode,
+                                  const uint16_t operand, std::vector<X64Emitter::Label>& side_exits,
+                                  bool& terminated) {
+    const OpcodeInfo::Entry& info = OpcodeInfo::Get(opcode);
+    const uint8_t base_cycles = CPU::GetOpcodeEntry(opcode).cycles_;
+
+    // Interrupt related and unofficial instructions are left to the interpreter
+    if (!info.official_ || info.mnemonic_ == Mnemonic::BRK || info.mnemonic_ == Mnemonic::RTI ||
+        info.addr_mode_ == AddrMode::kInd) {
+        return false;
+    }
+
+    Operand target;
+    if (!EmitOperand(emitter, info, operand, target, side_exits)) return false;
+
+    const int32_t reg = RegisterOffset(info.mnemonic_);
+    const uint16_t next_pc = pc + info.length_;
+
+    switch (info.mnemonic_) {
+    case Mnemonic::LDA: case Mnemonic::LDX: case Mnemonic::LDY:
+        EmitRead(emitter, target, Reg::kRcx);
+        emitter.StoreByte(kContext, reg, Reg::kRcx);
+        EmitSetNZ(emitter, Reg::kRcx);
+        break;
+
+    case Mnemonic::STA: case Mnemonic::STX: case Mnemonic::STY:
+        emitter.LoadByte(Reg::kRcx, kContext, reg);
+        EmitWrite(emitter, target, Reg::kRcx);
+        break;
+
+    case Mnemonic::ADC: case Mnemonic::SBC:
+        EmitRead(emitter, target, Reg::kRcx);
+        if (info.mnemonic_ == Mnemonic::SBC) {
+            emitter.AluImm(X64Emitter::kXor, Reg::kRcx, 0xFF); // SBC is ADC of the ones complement
+        }
+        // rdx = A + value + C
+        emitter.LoadByte(Reg::kRax, kContext, kA);
+        emitter.LoadByte(Reg::kRdx, kContext, kP);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRdx, kFlagC);
+        emitter.Alu(X64Emitter::kAdd, Reg::kRdx, Reg::kRax);
+        emitter.Alu(X64Emitter::kAdd, Reg::kRdx, Reg::kRcx);
+        // V = ~(A ^ value) & (A ^ result) & 0x80, moved to bit 6
+        emitter.Alu(X64Emitter::kXor, Reg::kRcx, Reg::kRax);
+        emitter.AluImm(X64Emitter::kXor, Reg::kRcx, 0x80);
+        emitter.Alu(X64Emitter::kXor, Reg::kRax, Reg::kRdx);
+        emitter.Alu(X64Emitter::kAnd, Reg::kRcx, Reg::kRax);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRcx, 0x80);
+        emitter.Shr(Reg::kRcx, 1);
+        // C = result > 0xFF
+        emitter.Mov(Reg::kRax, Reg::kRdx);
+        emitter.Shr(Reg::kRax, 8);
+        emitter.Alu(X64Emitter::kOr, Reg::kRcx, Reg::kRax);
+        emitter.AndByteImm(kContext, kP, ~(kFlagC | kFlagV));
+        emitter.OrByte(kContext, kP, Reg::kRcx);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRdx, 0xFF);
+        emitter.StoreByte(kContext, kA, Reg::kRdx);
+        EmitSetNZ(emitter, Reg::kRdx);
+        break;
+
+    case Mnemonic::AND: case Mnemonic::ORA: case Mnemonic::EOR:
+        EmitRead(emitter, target, Reg::kRcx);
+        emitter.LoadByte(Reg::kRax, kContext, kA);
+        emitter.Alu(info.mnemonic_ == Mnemonic::AND
+                        ? X64Emitter::kAnd
+                        : info.mnemonic_ == Mnemonic::ORA
+                        ? X64Emitter::kOr
+                        : X64Emitter::kXor, Reg::kRax, Reg::kRcx);
+        emitter.StoreByte(kContext, kA, Reg::kRax);
+        EmitSetNZ(emitter, Reg::kRax);
+        break;
+
+    case Mnemonic::CMP: case Mnemonic::CPX: case Mnemonic::CPY: {
+        EmitRead(emitter, target, Reg::kRcx);
+        emitter.LoadByte(Reg::kRax, kContext, reg);
+        emitter.AndByteImm(kContext, kP, ~kFlagC);
+        emitter.Alu(X64Emitter::kCmp, Reg::kRax, Reg::kRcx);
+        const X64Emitter::Label below = emitter.Jcc(X64Emitter::kBelow);
+        emitter.OrByteImm(kContext, kP, kFlagC);
+        emitter.Bind(below);
+        emitter.Alu(X64Emitter::kSub, Reg::kRax, Reg::kRcx);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRax, 0xFF);
+        EmitSetNZ(emitter, Reg::kRax);
+        break;
+    }
+
+    case Mnemonic::BIT: {
+        EmitRead(emitter, target, Reg::kRcx);
+        emitter.LoadByte(Reg::kRax, kContext, kA);
+        emitter.Alu(X64Emitter::kAnd, Reg::kRax, Reg::kRcx);
+        emitter.AndByteImm(kContext, kP, static_cast<uint8_t>(~(kFlagN | kFlagV | kFlagZ)));
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRcx, kFlagN | kFlagV); // N and V come from bits 7 and 6
+        emitter.OrByte(kContext, kP, Reg::kRcx);
+        emitter.TestImm(Reg::kRax, 0xFF);
+        const X64Emitter::Label not_zero = emitter.Jcc(X64Emitter::kNotEqual);
+        emitter.OrByteImm(kContext, kP, kFlagZ);
+        emitter.Bind(not_zero);
+        break;
+    }
+
+    case Mnemonic::INC: case Mnemonic::DEC:
+        EmitRead(emitter, target, Reg::kRcx);
+        emitter.Mov(Reg::kRax, Reg::kRcx);
+        emitter.AluImm(info.mnemonic_ == Mnemonic::INC ? X64Emitter::kAdd : X64Emitter::kSub, Reg::kRax, 1);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRax, 0xFF);
+        EmitWrite(emitter, target, Reg::kRax);
+        EmitSetNZ(emitter, Reg::kRax);
+        break;
+
+    case Mnemonic::INX: case Mnemonic::INY: case Mnemonic::DEX: case Mnemonic::DEY:
+        emitter.LoadByte(Reg::kRax, kContext, reg);
+        emitter.AluImm(info.mnemonic_ == Mnemonic::INX || info.mnemonic_ == Mnemonic::INY
+                           ? X64Emitter::kAdd
+                           : X64Emitter::kSub, Reg::kRax, 1);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRax, 0xFF);
+        emitter.StoreByte(kContext, reg, Reg::kRax);
+        EmitSetNZ(emitter, Reg::kRax);
+        break;
+
+    case Mnemonic::ASL: case Mnemonic::LSR: case Mnemonic::ROL: case Mnemonic::ROR:
+        // Value in rcx, result in rax, new carry in r8
+        EmitRead(emitter, target, Reg::kRcx);
+        if (info.mnemonic_ == Mnemonic::ASL) {
+            emitter.Mov(Reg::kRax, Reg::kRcx);
+            emitter.Shl(Reg::kRax, 1);
+            emitter.Mov(Reg::kR8, Reg::kRax);
+            emitter.Shr(Reg::kR8, 8);
+        }
+        else if (info.mnemonic_ == Mnemonic::LSR) {
+            emitter.Mov(Reg::kRax, Reg::kRcx);
+            emitter.Shr(Reg::kRax, 1);
+            emitter.Mov(Reg::kR8, Reg::kRcx);
+            emitter.AluImm(X64Emitter::kAnd, Reg::kR8, 0x01);
+        }
+        else if (info.mnemonic_ == Mnemonic::ROL) {
+            emitter.LoadByte(Reg::kR8, kContext, kP);
+            emitter.AluImm(X64Emitter::kAnd, Reg::kR8, kFlagC);
+            emitter.Mov(Reg::kRax, Reg::kRcx);
+            emitter.Shl(Reg::kRax, 1);
+            emitter.Alu(X64Emitter::kOr, Reg::kRax, Reg::kR8);
+            emitter.Mov(Reg::kR8, Reg::kRcx);
+            emitter.Shr(Reg::kR8, 7);
+        }
+        else {
+            emitter.LoadByte(Reg::kR8, kContext, kP);
+            emitter.AluImm(X64Emitter::kAnd, Reg::kR8, kFlagC);
+            emitter.Shl(Reg::kR8, 7);
+            emitter.Mov(Reg::kRax, Reg::kRcx);
+            emitter.Shr(Reg::kRax, 1);
+            emitter.Alu(X64Emitter::kOr, Reg::kRax, Reg::kR8);
+            emitter.Mov(Reg::kR8, Reg::kRcx);
+            emitter.AluImm(X64Emitter::kAnd, Reg::kR8, 0x01);
+        }
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRax, 0xFF);
+        emitter.AndByteImm(kContext, kP, ~kFlagC);
+        emitter.OrByte(kContext, kP, Reg::kR8);
+        EmitWrite(emitter, target, Reg::kRax);
+        EmitSetNZ(emitter, Reg::kRax);
+        break;
+
+    case Mnemonic::TAX: case Mnemonic::TAY: case Mnemonic::TXA: case Mnemonic::TYA:
+    case Mnemonic::TSX: case Mnemonic::TXS: {
+        const Mnemonic m = info.mnemonic_;
+        const int32_t from = m == Mnemonic::TAX || m == Mnemonic::TAY ? kA : m == Mnemonic::TSX ? kSP :
+                             m == Mnemonic::TYA ? kY : kX;
+        const int32_t to = m == Mnemonic::TAX || m == Mnemonic::TSX ? kX : m == Mnemonic::TAY ? kY :
+                           m == Mnemonic::TXS ? kSP : kA;
+        emitter.LoadByte(Reg::kRcx, kContext, from);
+        emitter.StoreByte(kContext, to, Reg::kRcx);
+        if (m != Mnemonic::TXS) EmitSetNZ(emitter, Reg::kRcx);
+        break;
+    }
+
+    case Mnemonic::CLC: emitter.AndByteImm(kContext, kP, ~kFlagC);
+        break;
+    case Mnemonic::SEC: emitter.OrByteImm(kContext, kP, kFlagC);
+        break;
+    case Mnemonic::CLI: emitter.AndByteImm(kContext, kP, ~kFlagI);
+        break;
+    case Mnemonic::SEI: emitter.OrByteImm(kContext, kP, kFlagI);
+        break;
+    case Mnemonic::CLD: emitter.AndByteImm(kContext, kP, ~kFlagD);
+        break;
+    case Mnemonic::SED: emitter.OrByteImm(kContext, kP, kFlagD);
+        break;
+    case Mnemonic::CLV: emitter.AndByteImm(kContext, kP, ~kFlagV);
+        break;
+    case Mnemonic::NOP:
+        break;
+
+    case Mnemonic::PHA: case Mnemonic::PHP:
+        emitter.LoadByte(Reg::kRax, kContext, kSP);
+        emitter.LoadByte(Reg::kRcx, kContext, info.mnemonic_ == Mnemonic::PHA ? kA : kP);
+        if (info.mnemonic_ == Mnemonic::PHP) {
+            emitter.AluImm(X64Emitter::kOr, Reg::kRcx, kFlagB); // Pushed with B set
+        }
+        emitter.StoreByte(kRam, Reg::kRax, 0x100, Reg::kRcx);
+        emitter.AluImm(X64Emitter::kSub, Reg::kRax, 1);
+        emitter.StoreByte(kContext, kSP, Reg::kRax);
+        if (info.mnemonic_ == Mnemonic::PHP) {
+            emitter.AndByteImm(kContext, kP, ~kFlagB);
+        }
+        break;
+
+    case Mnemonic::PLA: case Mnemonic::PLP:
+        emitter.LoadByte(Reg::kRax, kContext, kSP);
+        emitter.AluImm(X64Emitter::kAdd, Reg::kRax, 1);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRax, 0xFF);
+        emitter.StoreByte(kContext, kSP, Reg::kRax);
+        emitter.LoadByte(Reg::kRcx, kRam, Reg::kRax, 0x100);
+        if (info.mnemonic_ == Mnemonic::PLA) {
+            emitter.StoreByte(kContext, kA, Reg::kRcx);
+            EmitSetNZ(emitter, Reg::kRcx);
+        }
+        else {
+            emitter.AluImm(X64Emitter::kAnd, Reg::kRcx, static_cast<uint8_t>(~kFlagB));
+            emitter.AluImm(X64Emitter::kOr, Reg::kRcx, kFlagR);
+            emitter.StoreByte(kContext, kP, Reg::kRcx);
+        }
+        break;
+
+    // Block terminators, their base cycles are counted before leaving
+    case Mnemonic::JMP:
+        EmitAddCycles(emitter, base_cycles);
+        EmitExit(emitter, operand);
+        terminated = true;
+        return true;
+
+    case Mnemonic::JSR: {
+        const uint16_t return_address = next_pc - 1;
+        emitter.LoadByte(Reg::kRax, kContext, kSP);
+        emitter.StoreByteImm(kRam, Reg::kRax, 0x100, return_address >> 8);
+        emitter.AluImm(X64Emitter::kSub, Reg::kRax, 1);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRax, 0xFF);
+        emitter.StoreByteImm(kRam, Reg::kRax, 0x100, return_address & 0xFF);
+        emitter.AluImm(X64Emitter::kSub, Reg::kRax, 1);
+        emitter.StoreByte(kContext, kSP, Reg::kRax);
+        EmitAddCycles(emitter, base_cycles);
+        EmitExit(emitter, operand);
+        terminated = true;
+        return true;
+    }
+
+    case Mnemonic::RTS:
+        emitter.LoadByte(Reg::kRax, kContext, kSP);
+        emitter.AluImm(X64Emitter::kAdd, Reg::kRax, 1);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRax, 0xFF);
+        emitter.LoadByte(Reg::kRcx, kRam, Reg::kRax, 0x100);
+        emitter.AluImm(X64Emitter::kAdd, Reg::kRax, 1);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRax, 0xFF);
+        emitter.LoadByte(Reg::kRdx, kRam, Reg::kRax, 0x100);
+        emitter.StoreByte(kContext, kSP, Reg::kRax);
+        emitter.Shl(Reg::kRdx, 8);
+        emitter.Alu(X64Emitter::kOr, Reg::kRdx, Reg::kRcx);
+        emitter.AluImm(X64Emitter::kAdd, Reg::kRdx, 1);
+        emitter.StoreWord(kContext, kPC, Reg::kRdx);
+        EmitAddCycles(emitter, base_cycles);
+        EmitEpilogue(emitter);
+        terminated = true;
+        return true;
+
+    case Mnemonic::BCC: case Mnemonic::BCS: case Mnemonic::BEQ: case Mnemonic::BNE:
+    case Mnemonic::BMI: case Mnemonic::BPL: case Mnemonic::BVC: case Mnemonic::BVS: {
+        const Mnemonic m = info.mnemonic_;
+        const uint8_t flag = m == Mnemonic::BCC || m == Mnemonic::BCS ? kFlagC :
+                             m == Mnemonic::BEQ || m == Mnemonic::BNE ? kFlagZ :
+                             m == Mnemonic::BMI || m == Mnemonic::BPL ? kFlagN : kFlagV;
+        const bool taken_if_set = m == Mnemonic::BCS || m == Mnemonic::BEQ || m == Mnemonic::BMI ||
+                                  m == Mnemonic::BVS;
+        const uint16_t branch_target = next_pc + static_cast<int8_t>(operand & 0xFF);
+        const uint8_t taken_cycles = (branch_target & 0xFF00) != (next_pc & 0xFF00) ? 2 : 1;
+
+        EmitAddCycles(emitter, base_cycles);
+        emitter.LoadByte(Reg::kRax, kContext, kP);
+        emitter.TestImm(Reg::kRax, flag);
+        const X64Emitter::Label not_taken = emitter.Jcc(taken_if_set ? X64Emitter::kEqual : X64Emitter::kNotEqual);
+        EmitAddCycles(emitter, taken_cycles);
+        EmitExit(emitter, branch_target);
+        emitter.Bind(not_taken);
+        EmitExit(emitter, next_pc);
+        terminated = true;
+        return true;
+    }
+
+    default:
+        // Every official mnemonic is handled above, BRK and RTI were rejected
+        break;
+    }
+
+    EmitAddCycles(emitter, base_cycles);
+    return true;
+}
+
+// Resolves where the instruction reads or writes. Static accesses to registers end the block before
+// the instruction, dynamic ones get a run time check that leaves through a side exit.
+bool JitCompiler::EmitOperand(X64Emitter& emitter, const OpcodeInfo::Entry& info, const uint16_t operand,
+                              Operand& result, std::vector<X64Emitter::Label>& side_exits) {
+    const bool writes = info.access_ == Access::kWrite || info.access_ == Access::kReadModifyWrite;
+
+    switch (info.addr_mode_) {
+    case AddrMode::kImp:
+        result = {Operand::Kind::kAccumulator, 0};
+        return true;
+    case AddrMode::kImm:
+    case AddrMode::kRel:
+        result = {Operand::Kind::kImmediate, static_cast<uint16_t>(operand & 0xFF)};
+        return true;
+    case AddrMode::kZp0:
+        result = {Operand::Kind::kRam, static_cast<uint16_t>(operand & 0xFF)};
+        return true;
+    case AddrMode::kAbs:
+        if (info.access_ == Access::kNone) {
+            result = {Operand::Kind::kImmediate, operand}; // JMP and JSR targets
+            return true;
+        }
+        if (operand < 0x2000) {
+            result = {Operand::Kind::kRam, static_cast<uint16_t>(operand & 0x7FF)};
+            return true;
+        }
+        if (operand >= 0x6000 && !writes) {
+            result = {Operand::Kind::kCartridge, operand};
+            return true;
+        }
+        return false; // Registers or cartridge writes
+    default:
+        break;
+    }
+
+    // Dynamic address in rdx, base of the page crossing check in rax
+    switch (info.addr_mode_) {
+    case AddrMode::kZpx:
+    case AddrMode::kZpy:
+        emitter.LoadByte(Reg::kRdx, kContext, info.addr_mode_ == AddrMode::kZpx ? kX : kY);
+        emitter.AluImm(X64Emitter::kAdd, Reg::kRdx, operand & 0xFF);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRdx, 0xFF);
+        result = {Operand::Kind::kRamIndexed, 0};
+        return true; // Always in zero page
+    case AddrMode::kAbx:
+    case AddrMode::kAby:
+        emitter.LoadByte(Reg::kRdx, kContext, info.addr_mode_ == AddrMode::kAbx ? kX : kY);
+        emitter.AluImm(X64Emitter::kAdd, Reg::kRdx, operand);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRdx, 0xFFFF);
+        emitter.MovImm(Reg::kRax, operand);
+        break;
+    case AddrMode::kIzx:
+        emitter.LoadByte(Reg::kRax, kContext, kX);
+        emitter.AluImm(X64Emitter::kAdd, Reg::kRax, operand & 0xFF);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRax, 0xFF);
+        emitter.LoadByte(Reg::kRdx, kRam, Reg::kRax, 0);
+        emitter.AluImm(X64Emitter::kAdd, Reg::kRax, 1);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRax, 0xFF);
+        emitter.LoadByte(Reg::kRcx, kRam, Reg::kRax, 0);
+        emitter.Shl(Reg::kRcx, 8);
+        emitter.Alu(X64Emitter::kOr, Reg::kRdx, Reg::kRcx);
+        emitter.Mov(Reg::kRax, Reg::kRdx); // Never crosses a page
+        break;
+    case AddrMode::kIzy:
+        emitter.LoadByte(Reg::kRax, kRam, operand & 0xFF);
+        emitter.LoadByte(Reg::kRcx, kRam, (operand + 1) & 0xFF);
+        emitter.Shl(Reg::kRcx, 8);
+        emitter.Alu(X64Emitter::kOr, Reg::kRax, Reg::kRcx);
+        emitter.LoadByte(Reg::kRdx, kContext, kY);
+        emitter.Alu(X64Emitter::kAdd, Reg::kRdx, Reg::kRax);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRdx, 0xFFFF);
+        break;
+    default:
+        return false;
+    }
+
+    if (writes) {
+        // Only RAM can be written from a block
+        emitter.AluImm(X64Emitter::kCmp, Reg::kRdx, 0x2000);
+        side_exits.push_back(emitter.Jcc(X64Emitter::kAboveEqual));
+    }
+    else {
+        // Registers in $2000-$5FFF are read by the interpreter
+        emitter.Mov(Reg::kRcx, Reg::kRdx);
+        emitter.AluImm(X64Emitter::kSub, Reg::kRcx, 0x2000);
+        emitter.AluImm(X64Emitter::kCmp, Reg::kRcx, 0x4000);
+        side_exits.push_back(emitter.Jcc(X64Emitter::kBelow));
+    }
+
+    if (info.page_cross_penalty_) {
+        emitter.Alu(X64Emitter::kXor, Reg::kRax, Reg::kRdx);
+        emitter.TestImm(Reg::kRax, 0xFF00);
+        const X64Emitter::Label same_page = emitter.Jcc(X64Emitter::kEqual);
+        EmitAddCycles(emitter, 1);
+        emitter.Bind(same_page);
+    }
+
+    if (writes) {
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRdx, 0x7FF);
+        result = {Operand::Kind::kRamIndexed, 0};
+    }
+    else {
+        result = {Operand::Kind::kAnyIndexed, 0};
+    }
+    return true;
+}
+
+// Loads the operand value into dst, which must not be rdx
+void JitCompiler::EmitRead(X64Emitter& emitter, const Operand& operand, const Reg dst) {
+    switch (operand.kind_) {
+    case Operand::Kind::kImmediate:
+        emitter.MovImm(dst, operand.value_);
+        break;
+    case Operand::Kind::kAccumulator:
+        emitter.LoadByte(dst, kContext, kA);
+        break;
+    case Operand::Kind::kRam:
+        emitter.LoadByte(dst, kRam, operand.value_);
+        break;
+    case Operand::Kind::kCartridge:
+        emitter.MovImm(Reg::kRdx, operand.value_);
+        EmitReadHelperCall(emitter, dst);
+        break;
+    case Operand::Kind::kRamIndexed:
+        emitter.LoadByte(dst, kRam, Reg::kRdx, 0);
+        break;
+    case Operand::Kind::kAnyIndexed: {
+        emitter.AluImm(X64Emitter::kCmp, Reg::kRdx, 0x2000);
+        const X64Emitter::Label not_ram = emitter.Jcc(X64Emitter::kAboveEqual);
+        emitter.AluImm(X64Emitter::kAnd, Reg::kRdx, 0x7FF);
+        emitter.LoadByte(dst, kRam, Reg::kRdx, 0);
+        const X64Emitter::Label done = emitter.Jmp();
+        emitter.Bind(not_ram);
+        EmitReadHelperCall(emitter, dst);
+        emitter.Bind(done);
+        break;
+    }
+    }
+}
+
+// Stores src to a RAM operand or the accumulator
+void JitCompiler::EmitWrite(X64Emitter& emitter, const Operand& operand, const Reg src) {
+    switch (operand.kind_) {
+    case Operand::Kind::kAccumulator:
+        emitter.StoreByte(kContext, kA, src);
+        break;
+    case Operand::Kind::kRam:
+        emitter.StoreByte(kRam, operand.value_, src);
+        break;
+    case Operand::Kind::kRamIndexed:
+        emitter.StoreByte(kRam, Reg::kRdx, 0, src);
+        break;
+    default:
+        // EmitOperand never lets a write reach registers or the cartridge
+        break;
+    }
+}
+
+// Calls ReadHelper for the address in rdx and zero extends the result into dst
+void JitCompiler::EmitReadHelperCall(X64Emitter& emitter, const Reg dst) {
+#if defined(_WIN32)
+    // Microsoft x64 ABI: rcx, rdx, 32 bytes of shadow space reserved by the prologue
+    emitter.Load64(Reg::kRcx, kContext, offsetof(Context, cpu_));
+#else
+    // System V ABI: rdi, rsi
+    emitter.Mov(Reg::kRsi, Reg::kRdx);
+    emitter.Load64(Reg::kRdi, kContext, offsetof(Context, cpu_));
+#endif
+    emitter.MovImm64(Reg::kRax, reinterpret_cast<uint64_t>(&ReadHelper));
+    emitter.Call(Reg::kRax);
+    emitter.MovzxByte(dst, Reg::kRax);
+}
+
+// Sets N and Z from the byte in value, clobbers value
+void JitCompiler::EmitSetNZ(X64Emitter& emitter, const Reg value) {
+    emitter.LoadByte(value, kNZTable, value, 0);
+    emitter.AndByteImm(kContext, kP, static_cast<uint8_t>(~(kFlagN | kFlagZ)));
+    emitter.OrByte(kContext, kP, value);
+}
+
+void JitCompiler::EmitAddCycles(X64Emitter& emitter, const uint32_t cycles) {
+    emitter.AluImm(X64Emitter::kAdd, kCycles, cycles);
+}
+
+void JitCompiler::EmitPrologue(X64Emitter& emitter) {
+    emitter.Push(kContext);
+    emitter.Push(kRam);
+    emitter.Push(kNZTable);
+    emitter.Push(kCycles);
+    // Four pushes plus the return address leave rsp 8 bytes off, 40 realigns it to 16 bytes
+    // and covers the Microsoft ABI shadow space
+    emitter.AluImm64(X64Emitter::kSub, Reg::kRsp, 40);
+#if defined(_WIN32)
+    emitter.Mov64(kContext, Reg::kRcx);
+#else
+    emitter.Mov64(kContext, Reg::kRdi);
+#endif
+    emitter.Load64(kRam, kContext, offsetof(Context, ram_));
+    emitter.MovImm64(kNZTable, reinterpret_cast<uint64_t>(kNZFlags.data()));
+    emitter.MovImm(kCycles, 0);
+}
+
+void JitCompiler::EmitEpilogue(X64Emitter& emitter) {
+    emitter.Mov(Reg::kRax, kCycles);
+    emitter.AluImm64(X64Emitter::kAdd, Reg::kRsp, 40);
+    emitter.Pop(kCycles);
+    emitter.Pop(kNZTable);
+    emitter.Pop(kRam);
+    emitter.Pop(kContext);
+    emitter.Ret();
+}
+
+// Leaves the block with the 6502 program counter at pc
+void JitCompiler::EmitExit(X64Emitter& emitter, const uint16_t pc) {
+    emitter.StoreWordImm(kContext, kPC, pc);
+    EmitEpilogue(emitter);
+}
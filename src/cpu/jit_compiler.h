@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "opcode_info.h"
+#include "x64_emitter.h"
+
+class CPU;
+
+// Translates hot basic blocks of PRG ROM code into native x86-64 code.
+// A block runs every instruction at once on a copy of the CPU registers and returns the cycles
+// it took, which the CPU then counts down like a single long instruction. Blocks end before
+// anything the interpreter must see at the exact cycle: PPU/APU/mapper register accesses,
+// interrupt related instructions (BRK, RTI) and unofficial opcodes. Accesses whose address is
+// only known at run time leave the block through a side exit right before the instruction.
+// Blocks are keyed by PRG ROM offset like the instruction cache, and never span two 8KB
+// windows, so bank switches only change which blocks are reachable. The code buffer is never
+// writable and executable at once: pages are made writable to copy a block in, then executable.
+class JitCompiler {
+public:
+    // =====================
+    // === Types & Consts ===
+    // =====================
+
+    // Registers and memory the generated code works on
+    struct Context {
+        uint8_t a_, x_, y_, sp_, p_;
+        uint16_t pc_;
+        uint8_t* ram_; // CPU internal RAM, 2KB
+        CPU* cpu_; // For reads outside of RAM
+    };
+
+    // Returns the cycles taken, 0 if the block exited before its first instruction
+    using BlockFn = uint32_t (*)(Context* context);
+
+    static constexpr uint16_t kDefaultHotThreshold = 16; // Executions before a block is compiled
+    static constexpr uint32_t kMaxBlockInstructions = 32;
+    static constexpr uint32_t kMaxBlockCycles = 128; // Keeps the total below 256 with penalties
+    static constexpr size_t kCodeBufferSize = 4 * 1024 * 1024;
+
+    // =====================
+    // === Public API ======
+    // =====================
+    JitCompiler() = default;
+    ~JitCompiler();
+
+    JitCompiler(const JitCompiler&) = delete;
+    JitCompiler& operator=(const JitCompiler&) = delete;
+
+    // True if native code can be generated and run on this platform
+    [[nodiscard]] static bool IsSupported();
+
+    // Drops every compiled block and sizes the block table for a PRG ROM
+    void Attach(size_t prg_rom_size);
+
+    // Returns the compiled block starting at a CPU address mapped to a PRG ROM offset,
+    // compiling it once it becomes hot. nullptr while the block is cold or not compilable.
+    [[nodiscard]] BlockFn Lookup(CPU& cpu, uint16_t address, uint32_t prg_offset);
+
+    [[nodiscard]] size_t CompiledBlockCount() const {
+        return compiled_blocks_;
+    }
+
+    // Lower thresholds compile cold code too, 1 compiles every block on its first execution
+    void set_hot_threshold(const uint16_t hot_threshold) {
+        hot_threshold_ = hot_threshold;
+    }
+
+private:
+    // =====================
+    // === Internal State ==
+    // =====================
+    struct Block {
+        BlockFn code_ = nullptr;
+        uint16_t address_ = 0x0000; // CPU address the block was compiled for
+        uint16_t hits_ = 0;
+        bool failed_ = false; // First instruction cannot be compiled
+    };
+
+    std::vector<Block> blocks_; // Indexed by PRG ROM offset
+    uint8_t* code_buffer_ = nullptr; // Read/execute except while a block is copied in
+    size_t code_used_ = 0;
+    size_t compiled_blocks_ = 0;
+    uint16_t hot_threshold_ = kDefaultHotThreshold;
+
+    [[nodiscard]] BlockFn Compile(CPU& cpu, uint16_t address);
+    void Flush();
+
+    // =====================
+    // === Code Generation =
+    // =====================
+    using Reg = X64Emitter::Reg;
+
+    // Where an instruction reads its value from or writes its result to
+    struct Operand {
+        enum class Kind {
+            kImmediate, // value_ holds the byte
+            kAccumulator,
+            kRam, // value_ holds the RAM offset
+            kCartridge, // value_ holds the CPU address, read only
+            kRamIndexed, // rdx holds the RAM offset
+            kAnyIndexed // rdx holds the CPU address outside of $2000-$5FFF, read only
+        };
+
+        Kind kind_ = Kind::kImmediate;
+        uint16_t value_ = 0x0000;
+    };
+
+    // Compiles one instruction at pc. Returns false, without emitting anything, if the block must
+    // end before it. Sets terminated if the instruction ends the block itself.
+    static bool EmitInstruction(X64Emitter& emitter, uint16_t pc, uint8_t opcode, uint16_t operand,
+                                std::vector<X64Emitter::Label>& side_exits, bool& terminated);
+    static bool EmitOperand(X64Emitter& emitter, const OpcodeInfo::Entry& info, uint16_t operand,
+                            Operand& result, std::vector<X64Emitter::Label>& side_exits);
+    static void EmitRead(X64Emitter& emitter, const Operand& operand, Reg dst);
+    static void EmitWrite(X64Emitter& emitter, const Operand& operand, Reg src);
+    static void EmitReadHelperCall(X64Emitter& emitter, Reg dst);
+    static void EmitSetNZ(X64Emitter& emitter, Reg value);
+    static void EmitAddCycles(X64Emitter& emitter, uint32_t cycles);
+    static void EmitPrologue(X64Emitter& emitter);
+    static void EmitEpilogue(X64Emitter& emitter);
+    static void EmitExit(X64Emitter& emitter, uint16_t pc);
+};
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Static per-opcode metadata, shared by the CPU, the logger and the disassembler.
+// Indexed by opcode in the same order as CPU::kOpcodeTable, so no per-instruction
+// path has to compare mnemonic strings.
+class OpcodeInfo {
+public:
+    // =====================
+    // === Types & Consts ===
+    // =====================
+    enum class Mnemonic : uint8_t {
+        // Official
+        ADC, AND, ASL, BCC, BCS, BEQ, BIT, BMI, BNE, BPL,
+        BRK, BVC, BVS, CLC, CLD, CLI, CLV, CMP, CPX, CPY,
+        DEC, DEX, DEY, EOR, INC, INX, INY, JMP, JSR, LDA,
+        LDX, LDY, LSR, NOP, ORA, PHA, PHP, PLA, PLP, ROL,
+        ROR, RTI, RTS, SBC, SEC, SED, SEI, STA, STX, STY,
+        TAX, TAY, TSX, TXA, TXS, TYA,
+        // Unofficial
+        LAX, SAX, DCP, SLO, ANC, RLA, SRE, RRA, XAA, TAS,
+        SHY, SHX, LXA, LAS, AXS, ISC, ARR, ASR, JAM
+    };
+
+    enum class AddrMode : uint8_t {
+        kImp, kImm, kRel, kZp0, kZpx, kZpy, kAbs, kAbx, kAby, kInd, kIzx, kIzy
+    };
+
+    // How the instruction accesses the memory at its effective address
+    enum class Access : uint8_t {
+        kNone,
+        kRead,
+        kWrite,
+        kReadModifyWrite
+    };
+
+    // How the instruction changes the program counter
+    enum class Flow : uint8_t {
+        kNone, // Falls through to the next instruction
+        kBranch, // Conditional relative branch
+        kJump, // JMP absolute or indirect
+        kCall, // JSR
+        kReturn, // RTS, RTI
+        kBreak, // BRK
+        kHalt // JAM, locks up the CPU
+    };
+
+    struct Entry {
+        Mnemonic mnemonic_;
+        AddrMode addr_mode_;
+        uint8_t length_; // Instruction length in bytes, opcode included
+        bool page_cross_penalty_; // Indexed reads take one extra cycle when crossing a page
+        Access access_;
+        Flow flow_;
+        bool official_;
+    };
+
+    [[nodiscard]] static constexpr const Entry& Get(const uint8_t opcode) {
+        return kTable[opcode];
+    }
+
+    static constexpr std::array<Entry, 256> kTable = {
+        {
+            /* 0x0X */
+            /* 0x00 */ {Mnemonic::BRK, AddrMode::kImp, 1, false, Access::kNone, Flow::kBreak, true},
+            /* 0x01 */ {Mnemonic::ORA, AddrMode::kIzx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x02 */ {Mnemonic::JAM, AddrMode::kImp, 1, false, Access::kNone, Flow::kHalt, false},
+            /* 0x03 */ {Mnemonic::SLO, AddrMode::kIzx, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x04 */ {Mnemonic::NOP, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, false},
+            /* 0x05 */ {Mnemonic::ORA, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x06 */ {Mnemonic::ASL, AddrMode::kZp0, 2, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x07 */ {Mnemonic::SLO, AddrMode::kZp0, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x08 */ {Mnemonic::PHP, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x09 */ {Mnemonic::ORA, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, true},
+            /* 0x0A */ {Mnemonic::ASL, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x0B */ {Mnemonic::ANC, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, false},
+            /* 0x0C */ {Mnemonic::NOP, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, false},
+            /* 0x0D */ {Mnemonic::ORA, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, true},
+            /* 0x0E */ {Mnemonic::ASL, AddrMode::kAbs, 3, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x0F */ {Mnemonic::SLO, AddrMode::kAbs, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+
+            /* 0x1X */
+            /* 0x10 */ {Mnemonic::BPL, AddrMode::kRel, 2, false, Access::kNone, Flow::kBranch, true},
+            /* 0x11 */ {Mnemonic::ORA, AddrMode::kIzy, 2, true, Access::kRead, Flow::kNone, true},
+            /* 0x12 */ {Mnemonic::JAM, AddrMode::kImp, 1, false, Access::kNone, Flow::kHalt, false},
+            /* 0x13 */ {Mnemonic::SLO, AddrMode::kIzy, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x14 */ {Mnemonic::NOP, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, false},
+            /* 0x15 */ {Mnemonic::ORA, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x16 */ {Mnemonic::ASL, AddrMode::kZpx, 2, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x17 */ {Mnemonic::SLO, AddrMode::kZpx, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x18 */ {Mnemonic::CLC, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x19 */ {Mnemonic::ORA, AddrMode::kAby, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0x1A */ {Mnemonic::NOP, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, false},
+            /* 0x1B */ {Mnemonic::SLO, AddrMode::kAby, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x1C */ {Mnemonic::NOP, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, false},
+            /* 0x1D */ {Mnemonic::ORA, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0x1E */ {Mnemonic::ASL, AddrMode::kAbx, 3, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x1F */ {Mnemonic::SLO, AddrMode::kAbx, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+
+            /* 0x2X */
+            /* 0x20 */ {Mnemonic::JSR, AddrMode::kAbs, 3, false, Access::kNone, Flow::kCall, true},
+            /* 0x21 */ {Mnemonic::AND, AddrMode::kIzx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x22 */ {Mnemonic::JAM, AddrMode::kImp, 1, false, Access::kNone, Flow::kHalt, false},
+            /* 0x23 */ {Mnemonic::RLA, AddrMode::kIzx, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x24 */ {Mnemonic::BIT, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x25 */ {Mnemonic::AND, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x26 */ {Mnemonic::ROL, AddrMode::kZp0, 2, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x27 */ {Mnemonic::RLA, AddrMode::kZp0, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x28 */ {Mnemonic::PLP, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x29 */ {Mnemonic::AND, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, true},
+            /* 0x2A */ {Mnemonic::ROL, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x2B */ {Mnemonic::ANC, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, false},
+            /* 0x2C */ {Mnemonic::BIT, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, true},
+            /* 0x2D */ {Mnemonic::AND, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, true},
+            /* 0x2E */ {Mnemonic::ROL, AddrMode::kAbs, 3, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x2F */ {Mnemonic::RLA, AddrMode::kAbs, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+
+            /* 0x3X */
+            /* 0x30 */ {Mnemonic::BMI, AddrMode::kRel, 2, false, Access::kNone, Flow::kBranch, true},
+            /* 0x31 */ {Mnemonic::AND, AddrMode::kIzy, 2, true, Access::kRead, Flow::kNone, true},
+            /* 0x32 */ {Mnemonic::JAM, AddrMode::kImp, 1, false, Access::kNone, Flow::kHalt, false},
+            /* 0x33 */ {Mnemonic::RLA, AddrMode::kIzy, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x34 */ {Mnemonic::NOP, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, false},
+            /* 0x35 */ {Mnemonic::AND, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x36 */ {Mnemonic::ROL, AddrMode::kZpx, 2, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x37 */ {Mnemonic::RLA, AddrMode::kZpx, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x38 */ {Mnemonic::SEC, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x39 */ {Mnemonic::AND, AddrMode::kAby, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0x3A */ {Mnemonic::NOP, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, false},
+            /* 0x3B */ {Mnemonic::RLA, AddrMode::kAby, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x3C */ {Mnemonic::NOP, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, false},
+            /* 0x3D */ {Mnemonic::AND, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0x3E */ {Mnemonic::ROL, AddrMode::kAbx, 3, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x3F */ {Mnemonic::RLA, AddrMode::kAbx, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+
+            /* 0x4X */
+            /* 0x40 */ {Mnemonic::RTI, AddrMode::kImp, 1, false, Access::kNone, Flow::kReturn, true},
+            /* 0x41 */ {Mnemonic::EOR, AddrMode::kIzx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x42 */ {Mnemonic::JAM, AddrMode::kImp, 1, false, Access::kNone, Flow::kHalt, false},
+            /* 0x43 */ {Mnemonic::SRE, AddrMode::kIzx, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x44 */ {Mnemonic::NOP, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, false},
+            /* 0x45 */ {Mnemonic::EOR, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x46 */ {Mnemonic::LSR, AddrMode::kZp0, 2, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x47 */ {Mnemonic::SRE, AddrMode::kZp0, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x48 */ {Mnemonic::PHA, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x49 */ {Mnemonic::EOR, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, true},
+            /* 0x4A */ {Mnemonic::LSR, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x4B */ {Mnemonic::ASR, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, false},
+            /* 0x4C */ {Mnemonic::JMP, AddrMode::kAbs, 3, false, Access::kNone, Flow::kJump, true},
+            /* 0x4D */ {Mnemonic::EOR, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, true},
+            /* 0x4E */ {Mnemonic::LSR, AddrMode::kAbs, 3, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x4F */ {Mnemonic::SRE, AddrMode::kAbs, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+
+            /* 0x5X */
+            /* 0x50 */ {Mnemonic::BVC, AddrMode::kRel, 2, false, Access::kNone, Flow::kBranch, true},
+            /* 0x51 */ {Mnemonic::EOR, AddrMode::kIzy, 2, true, Access::kRead, Flow::kNone, true},
+            /* 0x52 */ {Mnemonic::JAM, AddrMode::kImp, 1, false, Access::kNone, Flow::kHalt, false},
+            /* 0x53 */ {Mnemonic::SRE, AddrMode::kIzy, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x54 */ {Mnemonic::NOP, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, false},
+            /* 0x55 */ {Mnemonic::EOR, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x56 */ {Mnemonic::LSR, AddrMode::kZpx, 2, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x57 */ {Mnemonic::SRE, AddrMode::kZpx, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x58 */ {Mnemonic::CLI, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x59 */ {Mnemonic::EOR, AddrMode::kAby, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0x5A */ {Mnemonic::NOP, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, false},
+            /* 0x5B */ {Mnemonic::SRE, AddrMode::kAby, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x5C */ {Mnemonic::NOP, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, false},
+            /* 0x5D */ {Mnemonic::EOR, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0x5E */ {Mnemonic::LSR, AddrMode::kAbx, 3, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x5F */ {Mnemonic::SRE, AddrMode::kAbx, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+
+            /* 0x6X */
+            /* 0x60 */ {Mnemonic::RTS, AddrMode::kImp, 1, false, Access::kNone, Flow::kReturn, true},
+            /* 0x61 */ {Mnemonic::ADC, AddrMode::kIzx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x62 */ {Mnemonic::JAM, AddrMode::kImp, 1, false, Access::kNone, Flow::kHalt, false},
+            /* 0x63 */ {Mnemonic::RRA, AddrMode::kIzx, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x64 */ {Mnemonic::NOP, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, false},
+            /* 0x65 */ {Mnemonic::ADC, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x66 */ {Mnemonic::ROR, AddrMode::kZp0, 2, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x67 */ {Mnemonic::RRA, AddrMode::kZp0, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x68 */ {Mnemonic::PLA, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x69 */ {Mnemonic::ADC, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, true},
+            /* 0x6A */ {Mnemonic::ROR, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x6B */ {Mnemonic::ARR, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, false},
+            /* 0x6C */ {Mnemonic::JMP, AddrMode::kInd, 3, false, Access::kNone, Flow::kJump, true},
+            /* 0x6D */ {Mnemonic::ADC, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, true},
+            /* 0x6E */ {Mnemonic::ROR, AddrMode::kAbs, 3, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x6F */ {Mnemonic::RRA, AddrMode::kAbs, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+
+            /* 0x7X */
+            /* 0x70 */ {Mnemonic::BVS, AddrMode::kRel, 2, false, Access::kNone, Flow::kBranch, true},
+            /* 0x71 */ {Mnemonic::ADC, AddrMode::kIzy, 2, true, Access::kRead, Flow::kNone, true},
+            /* 0x72 */ {Mnemonic::JAM, AddrMode::kImp, 1, false, Access::kNone, Flow::kHalt, false},
+            /* 0x73 */ {Mnemonic::RRA, AddrMode::kIzy, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x74 */ {Mnemonic::NOP, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, false},
+            /* 0x75 */ {Mnemonic::ADC, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0x76 */ {Mnemonic::ROR, AddrMode::kZpx, 2, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x77 */ {Mnemonic::RRA, AddrMode::kZpx, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x78 */ {Mnemonic::SEI, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x79 */ {Mnemonic::ADC, AddrMode::kAby, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0x7A */ {Mnemonic::NOP, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, false},
+            /* 0x7B */ {Mnemonic::RRA, AddrMode::kAby, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0x7C */ {Mnemonic::NOP, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, false},
+            /* 0x7D */ {Mnemonic::ADC, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0x7E */ {Mnemonic::ROR, AddrMode::kAbx, 3, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0x7F */ {Mnemonic::RRA, AddrMode::kAbx, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+
+            /* 0x8X */
+            /* 0x80 */ {Mnemonic::NOP, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, false},
+            /* 0x81 */ {Mnemonic::STA, AddrMode::kIzx, 2, false, Access::kWrite, Flow::kNone, true},
+            /* 0x82 */ {Mnemonic::NOP, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, false},
+            /* 0x83 */ {Mnemonic::SAX, AddrMode::kIzx, 2, false, Access::kWrite, Flow::kNone, false},
+            /* 0x84 */ {Mnemonic::STY, AddrMode::kZp0, 2, false, Access::kWrite, Flow::kNone, true},
+            /* 0x85 */ {Mnemonic::STA, AddrMode::kZp0, 2, false, Access::kWrite, Flow::kNone, true},
+            /* 0x86 */ {Mnemonic::STX, AddrMode::kZp0, 2, false, Access::kWrite, Flow::kNone, true},
+            /* 0x87 */ {Mnemonic::SAX, AddrMode::kZp0, 2, false, Access::kWrite, Flow::kNone, false},
+            /* 0x88 */ {Mnemonic::DEY, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x89 */ {Mnemonic::NOP, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, false},
+            /* 0x8A */ {Mnemonic::TXA, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x8B */ {Mnemonic::XAA, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, false},
+            /* 0x8C */ {Mnemonic::STY, AddrMode::kAbs, 3, false, Access::kWrite, Flow::kNone, true},
+            /* 0x8D */ {Mnemonic::STA, AddrMode::kAbs, 3, false, Access::kWrite, Flow::kNone, true},
+            /* 0x8E */ {Mnemonic::STX, AddrMode::kAbs, 3, false, Access::kWrite, Flow::kNone, true},
+            /* 0x8F */ {Mnemonic::SAX, AddrMode::kAbs, 3, false, Access::kWrite, Flow::kNone, false},
+
+            /* 0x9X */
+            /* 0x90 */ {Mnemonic::BCC, AddrMode::kRel, 2, false, Access::kNone, Flow::kBranch, true},
+            /* 0x91 */ {Mnemonic::STA, AddrMode::kIzy, 2, false, Access::kWrite, Flow::kNone, true},
+            /* 0x92 */ {Mnemonic::JAM, AddrMode::kImp, 1, false, Access::kNone, Flow::kHalt, false},
+            /* 0x93 */ {Mnemonic::SAX, AddrMode::kIzy, 2, false, Access::kWrite, Flow::kNone, false},
+            /* 0x94 */ {Mnemonic::STY, AddrMode::kZpx, 2, false, Access::kWrite, Flow::kNone, true},
+            /* 0x95 */ {Mnemonic::STA, AddrMode::kZpx, 2, false, Access::kWrite, Flow::kNone, true},
+            /* 0x96 */ {Mnemonic::STX, AddrMode::kZpy, 2, false, Access::kWrite, Flow::kNone, true},
+            /* 0x97 */ {Mnemonic::SAX, AddrMode::kZpy, 2, false, Access::kWrite, Flow::kNone, false},
+            /* 0x98 */ {Mnemonic::TYA, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x99 */ {Mnemonic::STA, AddrMode::kAby, 3, false, Access::kWrite, Flow::kNone, true},
+            /* 0x9A */ {Mnemonic::TXS, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0x9B */ {Mnemonic::TAS, AddrMode::kAby, 3, false, Access::kWrite, Flow::kNone, false},
+            /* 0x9C */ {Mnemonic::SHY, AddrMode::kAbx, 3, false, Access::kWrite, Flow::kNone, false},
+            /* 0x9D */ {Mnemonic::STA, AddrMode::kAbx, 3, false, Access::kWrite, Flow::kNone, true},
+            /* 0x9E */ {Mnemonic::SHX, AddrMode::kAby, 3, false, Access::kWrite, Flow::kNone, false},
+            /* 0x9F */ {Mnemonic::SAX, AddrMode::kAby, 3, false, Access::kWrite, Flow::kNone, false},
+
+            /* 0xAX */
+            /* 0xA0 */ {Mnemonic::LDY, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, true},
+            /* 0xA1 */ {Mnemonic::LDA, AddrMode::kIzx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xA2 */ {Mnemonic::LDX, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, true},
+            /* 0xA3 */ {Mnemonic::LAX, AddrMode::kIzx, 2, false, Access::kRead, Flow::kNone, false},
+            /* 0xA4 */ {Mnemonic::LDY, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xA5 */ {Mnemonic::LDA, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xA6 */ {Mnemonic::LDX, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xA7 */ {Mnemonic::LAX, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, false},
+            /* 0xA8 */ {Mnemonic::TAY, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0xA9 */ {Mnemonic::LDA, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, true},
+            /* 0xAA */ {Mnemonic::TAX, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0xAB */ {Mnemonic::LXA, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, false},
+            /* 0xAC */ {Mnemonic::LDY, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, true},
+            /* 0xAD */ {Mnemonic::LDA, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, true},
+            /* 0xAE */ {Mnemonic::LDX, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, true},
+            /* 0xAF */ {Mnemonic::LAX, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, false},
+
+            /* 0xBX */
+            /* 0xB0 */ {Mnemonic::BCS, AddrMode::kRel, 2, false, Access::kNone, Flow::kBranch, true},
+            /* 0xB1 */ {Mnemonic::LDA, AddrMode::kIzy, 2, true, Access::kRead, Flow::kNone, true},
+            /* 0xB2 */ {Mnemonic::JAM, AddrMode::kImp, 1, false, Access::kNone, Flow::kHalt, false},
+            /* 0xB3 */ {Mnemonic::LAX, AddrMode::kIzy, 2, true, Access::kRead, Flow::kNone, false},
+            /* 0xB4 */ {Mnemonic::LDY, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xB5 */ {Mnemonic::LDA, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xB6 */ {Mnemonic::LDX, AddrMode::kZpy, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xB7 */ {Mnemonic::LAX, AddrMode::kZpy, 2, false, Access::kRead, Flow::kNone, false},
+            /* 0xB8 */ {Mnemonic::CLV, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0xB9 */ {Mnemonic::LDA, AddrMode::kAby, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0xBA */ {Mnemonic::TSX, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0xBB */ {Mnemonic::LAS, AddrMode::kAby, 3, true, Access::kRead, Flow::kNone, false},
+            /* 0xBC */ {Mnemonic::LDY, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0xBD */ {Mnemonic::LDA, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0xBE */ {Mnemonic::LDX, AddrMode::kAby, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0xBF */ {Mnemonic::LAX, AddrMode::kAby, 3, true, Access::kRead, Flow::kNone, false},
+
+            /* 0xCX */
+            /* 0xC0 */ {Mnemonic::CPY, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, true},
+            /* 0xC1 */ {Mnemonic::CMP, AddrMode::kIzx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xC2 */ {Mnemonic::NOP, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, false},
+            /* 0xC3 */ {Mnemonic::DCP, AddrMode::kIzx, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0xC4 */ {Mnemonic::CPY, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xC5 */ {Mnemonic::CMP, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xC6 */ {Mnemonic::DEC, AddrMode::kZp0, 2, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0xC7 */ {Mnemonic::DCP, AddrMode::kZp0, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0xC8 */ {Mnemonic::INY, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0xC9 */ {Mnemonic::CMP, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, true},
+            /* 0xCA */ {Mnemonic::DEX, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0xCB */ {Mnemonic::AXS, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, false},
+            /* 0xCC */ {Mnemonic::CPY, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, true},
+            /* 0xCD */ {Mnemonic::CMP, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, true},
+            /* 0xCE */ {Mnemonic::DEC, AddrMode::kAbs, 3, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0xCF */ {Mnemonic::DCP, AddrMode::kAbs, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+
+            /* 0xDX */
+            /* 0xD0 */ {Mnemonic::BNE, AddrMode::kRel, 2, false, Access::kNone, Flow::kBranch, true},
+            /* 0xD1 */ {Mnemonic::CMP, AddrMode::kIzy, 2, true, Access::kRead, Flow::kNone, true},
+            /* 0xD2 */ {Mnemonic::JAM, AddrMode::kImp, 1, false, Access::kNone, Flow::kHalt, false},
+            /* 0xD3 */ {Mnemonic::DCP, AddrMode::kIzy, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0xD4 */ {Mnemonic::NOP, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, false},
+            /* 0xD5 */ {Mnemonic::CMP, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xD6 */ {Mnemonic::DEC, AddrMode::kZpx, 2, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0xD7 */ {Mnemonic::DCP, AddrMode::kZpx, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0xD8 */ {Mnemonic::CLD, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0xD9 */ {Mnemonic::CMP, AddrMode::kAby, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0xDA */ {Mnemonic::NOP, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, false},
+            /* 0xDB */ {Mnemonic::DCP, AddrMode::kAby, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0xDC */ {Mnemonic::NOP, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, false},
+            /* 0xDD */ {Mnemonic::CMP, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0xDE */ {Mnemonic::DEC, AddrMode::kAbx, 3, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0xDF */ {Mnemonic::DCP, AddrMode::kAbx, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+
+            /* 0xEX */
+            /* 0xE0 */ {Mnemonic::CPX, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, true},
+            /* 0xE1 */ {Mnemonic::SBC, AddrMode::kIzx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xE2 */ {Mnemonic::NOP, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, false},
+            /* 0xE3 */ {Mnemonic::ISC, AddrMode::kIzx, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0xE4 */ {Mnemonic::CPX, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xE5 */ {Mnemonic::SBC, AddrMode::kZp0, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xE6 */ {Mnemonic::INC, AddrMode::kZp0, 2, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0xE7 */ {Mnemonic::ISC, AddrMode::kZp0, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0xE8 */ {Mnemonic::INX, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0xE9 */ {Mnemonic::SBC, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, true},
+            /* 0xEA */ {Mnemonic::NOP, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0xEB */ {Mnemonic::SBC, AddrMode::kImm, 2, false, Access::kNone, Flow::kNone, false},
+            /* 0xEC */ {Mnemonic::CPX, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, true},
+            /* 0xED */ {Mnemonic::SBC, AddrMode::kAbs, 3, false, Access::kRead, Flow::kNone, true},
+            /* 0xEE */ {Mnemonic::INC, AddrMode::kAbs, 3, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0xEF */ {Mnemonic::ISC, AddrMode::kAbs, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+
+            /* 0xFX */
+            /* 0xF0 */ {Mnemonic::BEQ, AddrMode::kRel, 2, false, Access::kNone, Flow::kBranch, true},
+            /* 0xF1 */ {Mnemonic::SBC, AddrMode::kIzy, 2, true, Access::kRead, Flow::kNone, true},
+            /* 0xF2 */ {Mnemonic::JAM, AddrMode::kImp, 1, false, Access::kNone, Flow::kHalt, false},
+            /* 0xF3 */ {Mnemonic::ISC, AddrMode::kIzy, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0xF4 */ {Mnemonic::NOP, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, false},
+            /* 0xF5 */ {Mnemonic::SBC, AddrMode::kZpx, 2, false, Access::kRead, Flow::kNone, true},
+            /* 0xF6 */ {Mnemonic::INC, AddrMode::kZpx, 2, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0xF7 */ {Mnemonic::ISC, AddrMode::kZpx, 2, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0xF8 */ {Mnemonic::SED, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, true},
+            /* 0xF9 */ {Mnemonic::SBC, AddrMode::kAby, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0xFA */ {Mnemonic::NOP, AddrMode::kImp, 1, false, Access::kNone, Flow::kNone, false},
+            /* 0xFB */ {Mnemonic::ISC, AddrMode::kAby, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+            /* 0xFC */ {Mnemonic::NOP, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, false},
+            /* 0xFD */ {Mnemonic::SBC, AddrMode::kAbx, 3, true, Access::kRead, Flow::kNone, true},
+            /* 0xFE */ {Mnemonic::INC, AddrMode::kAbx, 3, false, Access::kReadModifyWrite, Flow::kNone, true},
+            /* 0xFF */ {Mnemonic::ISC, AddrMode::kAbx, 3, false, Access::kReadModifyWrite, Flow::kNone, false},
+        }
+    };
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "opcode_info.h"
+
+// Pairs of adjacent instructions that the cached core can run as a single fused handler, saving
+// the dispatch of the second one. Both instructions still make all of their own bus accesses,
+// in order, and the pair takes exactly the cycles of its two halves. The first instruction of
+// every pair falls through to the next one, so the second instruction always runs after it.
+class Superinstructions {
+public:
+    // =====================
+    // === Types & Consts ===
+    // =====================
+    struct Pair {
+        const char* name_;
+        uint8_t first_;
+        uint8_t second_;
+    };
+
+    static constexpr std::array<Pair, 8> kPairs = {{
+        {"LDA abs / BPL", 0xAD, 0x10}, // Vblank wait on $2002, or polling a flag
+        {"LDA abs / BMI", 0xAD, 0x30},
+        {"LDA abs / STA abs", 0xAD, 0x8D}, // Byte copy
+        {"DEX / BNE", 0xCA, 0xD0}, // Counted loops
+        {"DEY / BNE", 0x88, 0xD0},
+        {"CLC / ADC imm", 0x18, 0x69}, // 8-bit addition
+        {"CLC / ADC zp", 0x18, 0x65},
+        {"CLC / ADC abs", 0x18, 0x6D},
+    }};
+
+    static constexpr size_t kNoPair = kPairs.size();
+
+    // =====================
+    // === Public API ======
+    // =====================
+
+    // Returns the index in kPairs of the pair two adjacent instructions form, or kNoPair.
+    // The second instruction runs as many cycles early as the first one takes, so pairs whose
+    // second instruction reaches PPU, APU or mapper registers are never fused.
+    [[nodiscard]] static constexpr size_t Match(const uint8_t first, const uint8_t second,
+                                                const uint16_t second_operand) {
+        for (size_t i = 0; i < kPairs.size(); i++) {
+            if (kPairs[i].first_ == first && kPairs[i].second_ == second) {
+                return IsTimingSafe(second, second_operand) ? i : kNoPair;
+            }
+        }
+        return kNoPair;
+    }
+
+private:
+    // True if the access made by an instruction cannot be observed by anything but the CPU:
+    // RAM, PRG RAM, and PRG ROM reads
+    [[nodiscard]] static constexpr bool IsTimingSafe(const uint8_t opcode, const uint16_t operand) {
+        const OpcodeInfo::Entry& info = OpcodeInfo::Get(opcode);
+        if (info.addr_mode_ != OpcodeInfo::AddrMode::kAbs) return true; // Zero page, immediate or none
+        if (operand < 0x2000) return true;
+        if (info.access_ == OpcodeInfo::Access::kRead) return operand >= 0x6000;
+        return operand >= 0x6000 && operand < 0x8000; // Writes to $8000-$FFFF reach the mapper
+    }
+};
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Minimal x86-64 machine code emitter used by the JIT compiler.
+// Only the handful of encodings the block compiler needs are supported: 32-bit ALU operations
+// between registers, byte loads and stores through [base + disp] or [base + index + disp],
+// and forward jumps patched through labels.
+class X64Emitter {
+public:
+    // =====================
+    // === Types & Consts ===
+    // =====================
+    enum Reg : uint8_t {
+        kRax = 0, kRcx, kRdx, kRbx, kRsp, kRbp, kRsi, kRdi,
+        kR8, kR9, kR10, kR11, kR12, kR13, kR14, kR15
+    };
+
+    enum Cond : uint8_t {
+        kBelow = 0x2, // CF = 1
+        kAboveEqual = 0x3, // CF = 0
+        kEqual = 0x4, // ZF = 1
+        kNotEqual = 0x5, // ZF = 0
+    };
+
+    // ALU operations encoded as "op r/m32, r32" opcodes
+    enum AluOp : uint8_t {
+        kAdd = 0x01,
+        kOr = 0x09,
+        kAnd = 0x21,
+        kSub = 0x29,
+        kXor = 0x31,
+        kCmp = 0x39
+    };
+
+    // Position of an unresolved rel32 jump displacement
+    struct Label {
+        size_t patch_ = 0;
+    };
+
+    // =====================
+    // === Public API ======
+    // =====================
+    [[nodiscard]] const std::vector<uint8_t>& Code() const {
+        return code_;
+    }
+
+    [[nodiscard]] size_t Size() const {
+        return code_.size();
+    }
+
+    // Register moves
+    void MovImm(const Reg dst, const uint32_t imm) {
+        Rex(false, 0, 0, dst);
+        Byte(0xB8 + (dst & 7));
+        Dword(imm);
+    }
+
+    void MovImm64(const Reg dst, const uint64_t imm) {
+        Rex(true, 0, 0, dst);
+        Byte(0xB8 + (dst & 7));
+        Dword(static_cast<uint32_t>(imm));
+        Dword(static_cast<uint32_t>(imm >> 32));
+    }
+
+    void Mov(const Reg dst, const Reg src) {
+        Rex(false, src, 0, dst);
+        Byte(0x89);
+        ModRmReg(src, dst);
+    }
+
+    void Mov64(const Reg dst, const Reg src) {
+        Rex(true, src, 0, dst);
+        Byte(0x89);
+        ModRmReg(src, dst);
+    }
+
+    // movzx dst32, src8
+    void MovzxByte(const Reg dst, const Reg src) {
+        Rex(false, dst, 0, src, src >= kRsp);
+        Byte(0x0F);
+        Byte(0xB6);
+        ModRmReg(dst, src);
+    }
+
+    // Memory loads
+    void Load64(const Reg dst, const Reg base, const int32_t disp) {
+        Rex(true, dst, 0, base);
+        Byte(0x8B);
+        ModRmMem(dst, base, disp);
+    }
+
+    // movzx dst32, byte [base + disp]
+    void LoadByte(const Reg dst, const Reg base, const int32_t disp) {
+        Rex(false, dst, 0, base);
+        Byte(0x0F);
+        Byte(0xB6);
+        ModRmMem(dst, base, disp);
+    }
+
+    // movzx dst32, byte [base + index + disp]
+    void LoadByte(const Reg dst, const Reg base, const Reg index, const int32_t disp) {
+        Rex(false, dst, index, base);
+        Byte(0x0F);
+        Byte(0xB6);
+        ModRmMemIndex(dst, base, index, disp);
+    }
+
+    // Memory stores
+    void StoreByte(const Reg base, const int32_t disp, const Reg src) {
+        Rex(false, src, 0, base, src >= kRsp);
+        Byte(0x88);
+        ModRmMem(src, base, disp);
+    }
+
+    void StoreByte(const Reg base, const Reg index, const int32_t disp, const Reg src) {
+        Rex(false, src, index, base, src >= kRsp);
+        Byte(0x88);
+        ModRmMemIndex(src, base, index, disp);
+    }
+
+    void StoreByteImm(const Reg base, const Reg index, const int32_t disp, const uint8_t imm) {
+        Rex(false, 0, index, base);
+        Byte(0xC6);
+        ModRmMemIndex(0, base, index, disp);
+        Byte(imm);
+    }
+
+    void StoreWord(const Reg base, const int32_t disp, const Reg src) {
+        Byte(0x66);
+        Rex(false, src, 0, base);
+        Byte(0x89);
+        ModRmMem(src, base, disp);
+    }
+
+    void StoreWordImm(const Reg base, const int32_t disp, const uint16_t imm) {
+        Byte(0x66);
+        Rex(false, 0, 0, base);
+        Byte(0xC7);
+        ModRmMem(0, base, disp);
+        Byte(imm & 0xFF);
+        Byte(imm >> 8);
+    }
+
+    // Byte read-modify-write on memory, used for the status register
+    void AndByteImm(const Reg base, const int32_t disp, const uint8_t imm) {
+        Rex(false, 0, 0, base);
+        Byte(0x80);
+        ModRmMem(4, base, disp);
+        Byte(imm);
+    }
+
+    void OrByteImm(const Reg base, const int32_t disp, const uint8_t imm) {
+        Rex(false, 0, 0, base);
+        Byte(0x80);
+        ModRmMem(1, base, disp);
+        Byte(imm);
+    }
+
+    void OrByte(const Reg base, const int32_t disp, const Reg src) {
+        Rex(false, src, 0, base, src >= kRsp);
+        Byte(0x08);
+        ModRmMem(src, base, disp);
+    }
+
+    // 32-bit arithmetic
+    void Alu(const AluOp op, const Reg dst, const Reg src) {
+        Rex(false, src, 0, dst);
+        Byte(op);
+        ModRmReg(src, dst);
+    }
+
+    void AluImm(const AluOp op, const Reg dst, const uint32_t imm) {
+        Rex(false, 0, 0, dst);
+        Byte(0x81);
+        ModRmReg(ImmDigit(op), dst);
+        Dword(imm);
+    }
+
+    void AluImm64(const AluOp op, const Reg dst, const uint32_t imm) {
+        Rex(true, 0, 0, dst);
+        Byte(0x81);
+        ModRmReg(ImmDigit(op), dst);
+        Dword(imm);
+    }
+
+    void TestImm(const Reg dst, const uint32_t imm) {
+        Rex(false, 0, 0, dst);
+        Byte(0xF7);
+        ModRmReg(0, dst);
+        Dword(imm);
+    }
+
+    void Shl(const Reg dst, const uint8_t amount) {
+        Rex(false, 0, 0, dst);
+        Byte(0xC1);
+        ModRmReg(4, dst);
+        Byte(amount);
+    }
+
+    void Shr(const Reg dst, const uint8_t amount) {
+        Rex(false, 0, 0, dst);
+        Byte(0xC1);
+        ModRmReg(5, dst);
+        Byte(amount);
+    }
+
+    // Control flow
+    [[nodiscard]] Label Jcc(const Cond cond) {
+        Byte(0x0F);
+        Byte(0x80 + cond);
+        return Rel32();
+    }
+
+    [[nodiscard]] Label Jmp() {
+        Byte(0xE9);
+        return Rel32();
+    }
+
+    // Points a forward jump at the current position
+    void Bind(const Label label) {
+        const int32_t rel = static_cast<int32_t>(code_.size() - (label.patch_ + 4));
+        std::memcpy(&code_[label.patch_], &rel, sizeof(rel));
+    }
+
+    void Call(const Reg target) {
+        Rex(false, 0, 0, target);
+        Byte(0xFF);
+        ModRmReg(2, target);
+    }
+
+    void Push(const Reg reg) {
+        Rex(false, 0, 0, reg);
+        Byte(0x50 + (reg & 7));
+    }
+
+    void Pop(const Reg reg) {
+        Rex(false, 0, 0, reg);
+        Byte(0x58 + (reg & 7));
+    }
+
+    void Ret() {
+        Byte(0xC3);
+    }
+
+private:
+    // =====================
+    // === Internal State ==
+    // =====================
+    std::vector<uint8_t> code_;
+
+    void Byte(const uint8_t value) {
+        code_.push_back(value);
+    }
+
+    void Dword(const uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            code_.push_back((value >> (i * 8)) & 0xFF);
+        }
+    }
+
+    Label Rel32() {
+        const Label label{code_.size()};
+        Dword(0);
+        return label;
+    }
+
+    // Emits a REX prefix when any register needs it. force is used for byte access to
+    // spl/bpl/sil/dil, which would otherwise encode ah/ch/dh/bh
+    void Rex(const bool wide, const uint8_t reg, const uint8_t index, const uint8_t base, const bool force = false) {
+        const uint8_t rex = 0x40 | (wide << 3) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3);
+        if (rex != 0x40 || force) {
+            Byte(rex);
+        }
+    }
+
+    void ModRmReg(const uint8_t reg, const uint8_t rm) {
+        Byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+    }
+
+    // [base + disp32], rsp and r12 as base need a SIB byte
+    void ModRmMem(const uint8_t reg, const uint8_t base, const int32_t disp) {
+        Byte(0x80 | ((reg & 7) << 3) | (base & 7));
+        if ((base & 7) == kRsp) {
+            Byte(0x24);
+        }
+        Dword(static_cast<uint32_t>(disp));
+    }
+
+    // [base + index + disp32]
+    void ModRmMemIndex(const uint8_t reg, const uint8_t base, const uint8_t index, const int32_t disp) {
+        Byte(0x84 | ((reg & 7) << 3));
+        Byte(((index & 7) << 3) | (base & 7));
+        Dword(static_cast<uint32_t>(disp));
+    }
+
+    // The /digit of the "op r/m32, imm32" (0x81) group for an ALU operation
+    static uint8_t ImmDigit(const AluOp op) {
+        return op >> 3;
+    }
+};
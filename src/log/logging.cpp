@@ -3,31 +3,9 @@
 #include <cstring>
 #include <fstream>
 #include <iomanip>
-#include <unordered_set>
 #include <algorithm>
 #include "cpu.h"
 
-uint8_t Logging::GetOperationLength(void (CPU::*addr_mode)()) {
-    if (addr_mode == &CPU::ADR_IMM ||
-        addr_mode == &CPU::ADR_ZP0 ||
-        addr_mode == &CPU::ADR_ZPX ||
-        addr_mode == &CPU::ADR_ZPY ||
-        addr_mode == &CPU::ADR_REL ||
-        addr_mode == &CPU::ADR_IZX ||
-        addr_mode == &CPU::ADR_IZY) {
-        return 2;
-    }
-
-    if (addr_mode == &CPU::ADR_ABS ||
-        addr_mode == &CPU::ADR_ABX ||
-        addr_mode == &CPU::ADR_ABY ||
-        addr_mode == &CPU::ADR_IND) {
-        return 3;
-    }
-
-    return 1;
-}
-
 std::string Logging::Trim(const std::string& s) {
     auto view = std::string_view(s);
     auto not_space = [](const unsigned char ch) { return !std::isspace(ch); };
@@ -37,34 +15,36 @@ std::string Logging::Trim(const std::string& s) {
     return {start, end};
 }
 
-std::string Logging::GetOperandString(const CPU::Operation& entry, const uint8_t op1, const uint8_t op2,
+std::string Logging::GetOperandString(const OpcodeInfo::Entry& info, const uint8_t op1, const uint8_t op2,
                                       const uint16_t pc) {
+    using Mnemonic = OpcodeInfo::Mnemonic;
     std::ostringstream operand_stream;
-    if (entry.addr_mode_ == &CPU::ADR_IMP &&
-        (entry.name_ == "LSR" || entry.name_ == "ASL" || entry.name_ == "ROL" || entry.name_ == "ROR"))
+    if (info.addr_mode_ == OpcodeInfo::AddrMode::kImp &&
+        (info.mnemonic_ == Mnemonic::LSR || info.mnemonic_ == Mnemonic::ASL ||
+            info.mnemonic_ == Mnemonic::ROL || info.mnemonic_ == Mnemonic::ROR))
         operand_stream << "A";
-    else if (entry.addr_mode_ == &CPU::ADR_IMM)
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kImm)
         operand_stream << "#$" << ToHex(op1);
-    else if (entry.addr_mode_ == &CPU::ADR_ZP0)
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kZp0)
         operand_stream << "$" << ToHex(op1);
-    else if (entry.addr_mode_ == &CPU::ADR_ZPX)
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kZpx)
         operand_stream << "$" << ToHex(op1) << ",X";
-    else if (entry.addr_mode_ == &CPU::ADR_ZPY)
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kZpy)
         operand_stream << "$" << ToHex(op1) << ",Y";
-    else if (entry.addr_mode_ == &CPU::ADR_REL)
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kRel)
         operand_stream << "$" << std::setw(4) << std::setfill('0') << std::hex << std::uppercase
             << static_cast<uint16_t>(pc + 2 + static_cast<int8_t>(op1));
-    else if (entry.addr_mode_ == &CPU::ADR_IZX)
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kIzx)
         operand_stream << "($" << ToHex(op1) << ",X)";
-    else if (entry.addr_mode_ == &CPU::ADR_IZY)
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kIzy)
         operand_stream << "($" << ToHex(op1) << "),Y";
-    else if (entry.addr_mode_ == &CPU::ADR_ABS)
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kAbs)
         operand_stream << "$" << ToHex(op2) << ToHex(op1);
-    else if (entry.addr_mode_ == &CPU::ADR_ABX)
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kAbx)
         operand_stream << "$" << ToHex(op2) << ToHex(op1) << ",X";
-    else if (entry.addr_mode_ == &CPU::ADR_ABY)
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kAby)
         operand_stream << "$" << ToHex(op2) << ToHex(op1) << ",Y";
-    else if (entry.addr_mode_ == &CPU::ADR_IND)
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kInd)
         operand_stream << "($" << ToHex(op2) << ToHex(op1) << ")";
     else
         operand_stream << "";
@@ -72,64 +52,57 @@ std::string Logging::GetOperandString(const CPU::Operation& entry, const uint8_t
     return operand_stream.str();
 }
 
-bool Logging::HasValue(void (CPU::*addr_mode)()) {
+bool Logging::HasValue(const OpcodeInfo::AddrMode addr_mode) {
     if (
-        addr_mode == &CPU::ADR_ZP0 ||
-        addr_mode == &CPU::ADR_ZPX ||
-        addr_mode == &CPU::ADR_ZPY ||
-        addr_mode == &CPU::ADR_IZX ||
-        addr_mode == &CPU::ADR_IZY ||
-        addr_mode == &CPU::ADR_ABS ||
-        addr_mode == &CPU::ADR_ABX ||
-        addr_mode == &CPU::ADR_ABY
+        addr_mode == OpcodeInfo::AddrMode::kZp0 ||
+        addr_mode == OpcodeInfo::AddrMode::kZpx ||
+        addr_mode == OpcodeInfo::AddrMode::kZpy ||
+        addr_mode == OpcodeInfo::AddrMode::kIzx ||
+        addr_mode == OpcodeInfo::AddrMode::kIzy ||
+        addr_mode == OpcodeInfo::AddrMode::kAbs ||
+        addr_mode == OpcodeInfo::AddrMode::kAbx ||
+        addr_mode == OpcodeInfo::AddrMode::kAby
     ) {
         return true;
     }
     return false;
 }
 
-uint16_t Logging::GetEffectiveAddress(const CPU& cpu, void (CPU::*addr_mode)(), const uint8_t op1, const uint8_t op2) {
-    if (addr_mode == &CPU::ADR_ZP0) {
+uint16_t Logging::GetEffectiveAddress(const CPU& cpu, const OpcodeInfo::AddrMode addr_mode, const uint8_t op1,
+                                      const uint8_t op2) {
+    if (addr_mode == OpcodeInfo::AddrMode::kZp0) {
         return op1;
     }
-    if (addr_mode == &CPU::ADR_ZPX) {
+    if (addr_mode == OpcodeInfo::AddrMode::kZpx) {
         return (op1 + cpu.X()) & 0xFF;
     }
-    if (addr_mode == &CPU::ADR_ZPY) {
+    if (addr_mode == OpcodeInfo::AddrMode::kZpy) {
         return (op1 + cpu.Y()) & 0xFF;
     }
-    if (addr_mode == &CPU::ADR_IZX) {
+    if (addr_mode == OpcodeInfo::AddrMode::kIzx) {
         const uint8_t base = (op1 + cpu.X()) & 0xFF;
         return cpu.Read(base) | (cpu.Read((base + 1) & 0xFF) << 8);
     }
-    if (addr_mode == &CPU::ADR_IZY) {
+    if (addr_mode == OpcodeInfo::AddrMode::kIzy) {
         const uint8_t lo = cpu.Read(op1);
         const uint8_t hi = cpu.Read((op1 + 1) & 0xFF);
         return ((hi << 8) | lo) + cpu.Y();
     }
-    if (addr_mode == &CPU::ADR_ABS) {
+    if (addr_mode == OpcodeInfo::AddrMode::kAbs) {
         return (op2 << 8) | op1;
     }
-    if (addr_mode == &CPU::ADR_ABX) {
+    if (addr_mode == OpcodeInfo::AddrMode::kAbx) {
         return ((op2 << 8) | op1) + cpu.X();
     }
-    if (addr_mode == &CPU::ADR_ABY) {
+    if (addr_mode == OpcodeInfo::AddrMode::kAby) {
         return ((op2 << 8) | op1) + cpu.Y();
     }
     return -1;
 }
 
 bool Logging::IsUndocumentedNop(const uint8_t opcode) {
-    static const std::unordered_set<uint8_t> unofficial_nops = {
-        0x04, 0x44, 0x64, 0x0C,
-        0x14, 0x34, 0x54, 0x74, 0xD4, 0xF4,
-        0x1A, 0x3A, 0x5A, 0x7A, 0xDA, 0xFA,
-        0x80,
-        0x82, 0x89, 0xC2, 0xE2,
-        0xCB,
-        0x1C, 0x3C, 0x5C, 0x7C, 0xDC, 0xFC
-    };
-    return unofficial_nops.count(opcode) > 0;
+    const auto& info = OpcodeInfo::Get(opcode);
+    return info.mnemonic_ == OpcodeInfo::Mnemonic::NOP && !info.official_;
 }
 
 // C++
@@ -159,8 +132,8 @@ std::string Logging::CreateDisassemblyLine(const CPU& cpu, uint16_t pc) {
     const uint8_t opcode = cpu.Read(pc);
     const uint8_t op1 = cpu.Read(pc + 1);
     const uint8_t op2 = cpu.Read(pc + 2);
-    const auto& entry = CPU::GetOpcodeEntry(opcode);
-    const uint8_t op_len = GetOperationLength(entry.addr_mode_);
+    const auto& info = OpcodeInfo::Get(opcode);
+    const uint8_t op_len = info.length_;
 
     std::ostringstream opbytes_stream;
     if (op_len == 1)
@@ -175,14 +148,14 @@ std::string Logging::CreateDisassemblyLine(const CPU& cpu, uint16_t pc) {
     std::string value_str;
 
     // Special formatting for ($nn,X) and ($nn),Y
-    if (entry.addr_mode_ == &CPU::ADR_IZX) {
+    if (info.addr_mode_ == OpcodeInfo::AddrMode::kIzx) {
         uint8_t zp_addr = (op1 + cpu.X()) & 0xFF;
         uint16_t eff_addr = cpu.Read(zp_addr) | (cpu.Read((zp_addr + 1) & 0xFF) << 8);
         uint8_t value = cpu.Read(eff_addr);
         operand_str = "($" + ToHex(op1) + ",X) @ " + ToHex(zp_addr) + " = " + ToHex((eff_addr >> 8) & 0xFF) +
             ToHex(eff_addr & 0xFF) + " = " + ToHex(value);
     }
-    else if (entry.addr_mode_ == &CPU::ADR_IZY) {
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kIzy) {
         uint8_t base_lo = cpu.Read(op1);
         uint8_t base_hi = cpu.Read((op1 + 1) & 0xFF);
         uint16_t base_addr = (base_hi << 8) | base_lo;
@@ -194,24 +167,24 @@ std::string Logging::CreateDisassemblyLine(const CPU& cpu, uint16_t pc) {
             ToHex((eff_addr >> 8) & 0xFF) + ToHex(eff_addr & 0xFF) +
             " = " + ToHex(value);
     }
-    else if (entry.name_ == "JMP" && entry.addr_mode_ == &CPU::ADR_IND) {
+    else if (info.mnemonic_ == OpcodeInfo::Mnemonic::JMP && info.addr_mode_ == OpcodeInfo::AddrMode::kInd) {
         uint16_t ptr = (op2 << 8) | op1;
         uint8_t lo = cpu.Read(ptr);
         uint8_t hi = cpu.Read((ptr & 0xFF00) | ((ptr + 1) & 0xFF)); // 6502 bug emulation
         uint16_t target = (hi << 8) | lo;
         operand_str = "($" + ToHex(op2) + ToHex(op1) + ") = " + ToHex((target >> 8) & 0xFF) + ToHex(target & 0xFF);
     }
-    else if (entry.addr_mode_ == &CPU::ADR_ABX || entry.addr_mode_ == &CPU::ADR_ABY) {
-        operand_str = GetOperandString(entry, op1, op2, pc);
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kAbx || info.addr_mode_ == OpcodeInfo::AddrMode::kAby) {
+        operand_str = GetOperandString(info, op1, op2, pc);
         uint16_t base_addr = (op2 << 8) | op1;
-        uint16_t eff_addr = (entry.addr_mode_ == &CPU::ADR_ABX) ? (base_addr + cpu.X()) : (base_addr + cpu.Y());
+        uint16_t eff_addr = (info.addr_mode_ == OpcodeInfo::AddrMode::kAbx) ? (base_addr + cpu.X()) : (base_addr + cpu.Y());
         uint8_t value = cpu.Read(eff_addr);
         operand_str += " @ " + ToHex((eff_addr >> 8) & 0xFF) + ToHex(eff_addr & 0xFF);
         value_str = "= " + ToHex(value);
     }
-    else if (entry.addr_mode_ == &CPU::ADR_ZPX || entry.addr_mode_ == &CPU::ADR_ZPY) {
-        operand_str = GetOperandString(entry, op1, op2, pc);
-        uint16_t eff_addr = (entry.addr_mode_ == &CPU::ADR_ZPX)
+    else if (info.addr_mode_ == OpcodeInfo::AddrMode::kZpx || info.addr_mode_ == OpcodeInfo::AddrMode::kZpy) {
+        operand_str = GetOperandString(info, op1, op2, pc);
+        uint16_t eff_addr = (info.addr_mode_ == OpcodeInfo::AddrMode::kZpx)
                                 ? ((op1 + cpu.X()) & 0xFF)
                                 : ((op1 + cpu.Y()) & 0xFF);
         uint8_t value = cpu.Read(eff_addr);
@@ -219,18 +192,10 @@ std::string Logging::CreateDisassemblyLine(const CPU& cpu, uint16_t pc) {
         value_str = ""; // already included
     }
     else {
-        operand_str = GetOperandString(entry, op1, op2, pc);
-        uint16_t addr = GetEffectiveAddress(cpu, entry.addr_mode_, op1, op2);
-        if (HasValue(entry.addr_mode_) && (
-            entry.name_ == "LDA" || entry.name_ == "STA" ||
-            entry.name_ == "LDX" || entry.name_ == "STX" ||
-            entry.name_ == "LDY" || entry.name_ == "STY" ||
-            entry.name_ == "INC" || entry.name_ == "DEC" ||
-            entry.name_ == "CMP" || entry.name_ == "CPX" || entry.name_ == "CPY" ||
-            entry.name_ == "AND" || entry.name_ == "ORA" || entry.name_ == "EOR" ||
-            entry.name_ == "SBC" || entry.name_ == "ADC" || entry.name_ == "BIT" ||
-            entry.name_ == "LSR" || entry.name_ == "ASL" || entry.name_ == "ROL" || entry.name_ == "ROR"
-        )) {
+        operand_str = GetOperandString(info, op1, op2, pc);
+        uint16_t addr = GetEffectiveAddress(cpu, info.addr_mode_, op1, op2);
+        // Official instructions that access memory show the value at the effective address
+        if (HasValue(info.addr_mode_) && info.official_ && info.access_ != OpcodeInfo::Access::kNone) {
             value_str = "= " + ToHex(cpu.Read(addr));
         }
     }
@@ -240,7 +205,8 @@ std::string Logging::CreateDisassemblyLine(const CPU& cpu, uint16_t pc) {
                                                       ? ToHex(op2) + ToHex(op1) + " = " + ToHex(
                                                           cpu.Read((op2 << 8) | op1))
                                                       : ToHex(op1) + " = " + ToHex(cpu.Read(op1))))
-                                   : (std::string(entry.name_) + " " + operand_str + " " + value_str);
+                                   : (std::string(CPU::GetOpcodeEntry(opcode).name_) + " " + operand_str + " " +
+                                       value_str);
 
     std::ostringstream line_stream;
     line_stream << std::left << std::setfill(' ') << std::setw(6) << ToHex(pc >> 8) + ToHex(pc)
@@ -0,0 +1,31 @@
+#pragma once
+#include "ppu.h"
+
+// Row versions a framebuffer consumer (display, capture, streaming) last saw. Each consumer keeps
+// its own tracker, so one uploading a row does not hide it from the others.
+class DirtyRowTracker {
+public:
+    // Calls on_run(first_row, row_count) for every run of rows that changed since the last call,
+    // then remembers the versions. Everything is dirty on the first call and after Reset().
+    template <typename OnRun>
+    void Collect(const PPU::RowVersions& versions, OnRun&& on_run) {
+        int first = -1;
+        for (int row = 0; row <= PPU::kHeight; row++) {
+            const bool dirty = row < PPU::kHeight && (!valid_ || versions[row] != seen_[row]);
+            if (dirty && first < 0) first = row;
+            if (!dirty && first >= 0) {
+                on_run(first, row - first);
+                first = -1;
+            }
+        }
+        seen_ = versions;
+        valid_ = true;
+    }
+
+    // For consumers that lost their copy, e.g. a recreated texture
+    void Reset() { valid_ = false; }
+
+private:
+    PPU::RowVersions seen_ = {};
+    bool valid_ = false;
+};
@@ -7,6 +7,7 @@
 #include "graphics_debug.h"
 #include "graphics_wrapper.h"
 #include "ppu.h"
+#include "ppu_render_thread.h"
 #include "log/logging.h"
 
 
@@ -41,10 +42,8 @@ void GraphicsDebug::RenderOAMInfo() const {
     ImGui::TableHeadersRow();
 
     // Get pattern table textures once
-    const std::vector<PPU::Pixel> pattern_pixels_0 = ppu_->GetPatternTableSprite(0, 0);
-    const std::vector<PPU::Pixel> pattern_pixels_1 = ppu_->GetPatternTableSprite(1, 0);
-    SDL_Texture* pattern_texture_0 = gfx_.GetPatternTableTexture(pattern_pixels_0, 0);
-    SDL_Texture* pattern_texture_1 = gfx_.GetPatternTableTexture(pattern_pixels_1, 1);
+    SDL_Texture* pattern_texture_0 = gfx_.GetPatternTableTexture(*ppu_, 0, 0);
+    SDL_Texture* pattern_texture_1 = gfx_.GetPatternTableTexture(*ppu_, 1, 0);
 
     // Iterate through all 64 sprites
     for (int i = 0; i < 64; i++) {
@@ -106,7 +105,7 @@ void GraphicsDebug::RenderFlagsView() const {
 }
 
 void GraphicsDebug::RenderRegisterView() const {
-    ImGui::Text("clocks: %u", bus_->total_cycles_);
+    ImGui::Text("clocks: %llu", static_cast<unsigned long long>(bus_->total_cycles_));
     ImGui::Text("PC: %04X", cpu_->PC());
     ImGui::Text("A: %02X (%d)", cpu_->A(), cpu_->A());
     ImGui::SameLine(0.0f, 20.0f);
@@ -222,14 +221,12 @@ void GraphicsDebug::RenderPaletteView() const {
 
 void GraphicsDebug::RenderPatternTableView() const {
     ImGui::Text("Pattern Tables:");
-    const std::vector<PPU::Pixel> pattern_pixels_0 = ppu_->GetPatternTableSprite(0, selected_palette_);
-    SDL_Texture* pattern_texture_0 = gfx_.GetPatternTableTexture(pattern_pixels_0, 0);
+    SDL_Texture* pattern_texture_0 = gfx_.GetPatternTableTexture(*ppu_, 0, selected_palette_);
     ImGui::BeginGroup();
     ImGui::Image(pattern_texture_0, ImVec2(128 * kPatternViewScale, 128 * kPatternViewScale));
     ImGui::EndGroup();
     ImGui::SameLine();
-    const std::vector<PPU::Pixel> pattern_pixels_1 = ppu_->GetPatternTableSprite(1, selected_palette_);
-    SDL_Texture* pattern_texture_1 = gfx_.GetPatternTableTexture(pattern_pixels_1, 1);
+    SDL_Texture* pattern_texture_1 = gfx_.GetPatternTableTexture(*ppu_, 1, selected_palette_);
     ImGui::BeginGroup();
     ImGui::Image(pattern_texture_1, ImVec2(128 * kPatternViewScale, 128 * kPatternViewScale));
     ImGui::EndGroup();
@@ -263,9 +260,11 @@ int main(const int argc, char** argv) {
         if (GraphicsWrapper::getKey(SDL_SCANCODE_SPACE).pressed)
             gb.run_mode_ = !gb.run_mode_;
 
+        // Frames are drawn on another thread while the game runs, stepping draws them here
+        gb.bus_->EnableRenderThread(gb.run_mode_);
+
         if (gb.run_mode_) {
-            do { gb.bus_->Step(); }
-            while (!gb.ppu_->frame_complete_);
+            gb.bus_->RunFrame();
 
             const uint32_t frame_time = SDL_GetTicks() - frame_start;
 
@@ -285,15 +284,21 @@ int main(const int argc, char** argv) {
             }
 
             if (GraphicsWrapper::getKey(SDL_SCANCODE_F).pressed)
-                do { gb.bus_->Step(); }
-                while (!gb.ppu_->frame_complete_);
+                gb.bus_->RunFrame();
 
             if (GraphicsWrapper::getKey(SDL_SCANCODE_P).pressed)
                 gb.selected_palette_ = (gb.selected_palette_ + 1) % 8;
         }
 
 
-        gfx.UpdateFramebuffer(gb.ppu_->GetFrameBuffer());
+        if (gb.bus_->render_thread_) {
+            gb.bus_->render_thread_->AcquireFrame();
+            const PpuRenderThread::Frame& frame = gb.bus_->render_thread_->CurrentFrame();
+            gfx.UpdateFramebuffer(frame.framebuffer_, frame.row_versions_);
+        }
+        else {
+            gfx.UpdateFramebuffer(gb.ppu_->GetFrameBuffer(), gb.ppu_->GetRowVersions());
+        }
 
         gb.RenderDebugInfo();
         GraphicsDebug::RenderFpsCounter();
@@ -49,8 +49,10 @@ bool GraphicsWrapper::Initialize(const std::string& title, const int width, cons
     texture_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, width, height);
     if (!texture_) return false;
     // Create pattern table textures
-    pattern_texture_0_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, 128, 128);
-    pattern_texture_1_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, 128, 128);
+    pattern_texture_0_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING,
+                                           PPU::kPatternTableSize, PPU::kPatternTableSize);
+    pattern_texture_1_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING,
+                                           PPU::kPatternTableSize, PPU::kPatternTableSize);
     if (!pattern_texture_0_ || !pattern_texture_1_) return false;
     // ImGui setup
     IMGUI_CHECKVERSION();
@@ -93,35 +95,39 @@ void GraphicsWrapper::EndFrame() const {
     SDL_RenderPresent(renderer_);
 }
 
-void GraphicsWrapper::UpdateFramebuffer(const std::vector<PPU::Pixel>& framebuffer) const {
-    std::vector<uint32_t> rgba_buffer = ConvertPixelsToRgba(framebuffer);
-    SDL_UpdateTexture(texture_, nullptr, rgba_buffer.data(), PPU::kWidth * sizeof(uint32_t));
+void GraphicsWrapper::UpdateFramebuffer(const std::vector<uint16_t>& framebuffer,
+                                        const PPU::RowVersions& row_versions) {
+    bool failed = false;
+    uploaded_rows_.Collect(row_versions, [&](const int first_row, const int row_count) {
+        // Locked pixels start out undefined, so every row of the rect is written
+        const SDL_Rect rect = {0, first_row, PPU::kWidth, row_count};
+        void* pixels = nullptr;
+        int pitch = 0;
+        if (SDL_LockTexture(texture_, &rect, &pixels, &pitch) != 0) {
+            failed = true;
+            return;
+        }
+        PPU::ConvertRowsToRgba(framebuffer, first_row, row_count, rgba_table_, static_cast<uint32_t*>(pixels),
+                               pitch / static_cast<int>(sizeof(uint32_t)));
+        SDL_UnlockTexture(texture_);
+    });
+    if (failed) uploaded_rows_.Reset(); // Try every row again next frame
 }
 
 bool GraphicsWrapper::ShouldClose() const {
     return !running_;
 }
 
-std::vector<uint32_t> GraphicsWrapper::ConvertPixelsToRgba(const std::vector<PPU::Pixel>& pixels) {
-    if (pixels.empty()) {
-        // Return an empty vector if input is empty
-        return std::vector<uint32_t>();
-    }
-
-    std::vector<uint32_t> rgba;
-    rgba.reserve(pixels.size());
-
-    for (const auto& pixel : pixels) {
-        const uint32_t color = (pixel.r_ << 24) | (pixel.g_ << 16) | (pixel.b_ << 8) | 0xFF;
-        rgba.push_back(color);
-    }
-    return rgba;
-}
-
-SDL_Texture* GraphicsWrapper::GetPatternTableTexture(const std::vector<PPU::Pixel>& pixels, int table_idx) const {
-    const std::vector<uint32_t> pattern_rgba = ConvertPixelsToRgba(pixels);
+SDL_Texture* GraphicsWrapper::GetPatternTableTexture(const PPU& ppu, const int table_idx,
+                                                     const int palette_id) const {
     SDL_Texture* tex = (table_idx == 0) ? pattern_texture_0_ : pattern_texture_1_;
-    SDL_UpdateTexture(tex, nullptr, pattern_rgba.data(), 128 * sizeof(uint32_t));
+    void* pixels = nullptr;
+    int pitch = 0;
+    if (SDL_LockTexture(tex, nullptr, &pixels, &pitch) == 0) {
+        ppu.RenderPatternTable(table_idx, palette_id, rgba_table_, static_cast<uint32_t*>(pixels),
+                               pitch / static_cast<int>(sizeof(uint32_t)));
+        SDL_UnlockTexture(tex);
+    }
     return tex;
 }
 
@@ -5,6 +5,7 @@
 
 #include <SDL.h>
 
+#include "dirty_row_tracker.h"
 #include "ppu.h"
 
 // Forward declarations for SDL types
@@ -35,18 +36,16 @@ public:
     // End the frame (renders everything to the screen)
     void EndFrame() const;
 
-    // Update the NES framebuffer (palette indices)
-    void UpdateFramebuffer(const std::vector<PPU::Pixel>& framebuffer) const;
+    // Update the NES framebuffer (palette indices with emphasis), converted straight into the locked texture.
+    // Only the rows whose version changed since the last update are locked and converted.
+    void UpdateFramebuffer(const std::vector<uint16_t>& framebuffer, const PPU::RowVersions& row_versions);
 
 
     // Check if the window should close
     [[nodiscard]] bool ShouldClose() const;
 
-    // Converts a vector of PPU::Pixel (NES colors) to a vector of 32-bit RGBA values
-    static std::vector<uint32_t> ConvertPixelsToRgba(const std::vector<PPU::Pixel>& pixels);
-
-    // Returns an SDL_Texture* for the given pattern table index (0 or 1), generating and updating it as needed
-    [[nodiscard]] SDL_Texture* GetPatternTableTexture(const std::vector<PPU::Pixel>& pixels, int table_idx) const;
+    // Returns an SDL_Texture* for the given pattern table index (0 or 1), drawn by the PPU with the given palette
+    [[nodiscard]] SDL_Texture* GetPatternTableTexture(const PPU& ppu, int table_idx, int palette_id) const;
 
 private:
     SDL_Window* window_ = nullptr;
@@ -58,4 +57,6 @@ private:
     int window_width_ = 0;
     int window_height_ = 0;
     int scale_ = 2;
+    PPU::RgbaTable rgba_table_ = PPU::BuildRgbaTable();
+    DirtyRowTracker uploaded_rows_;
 };
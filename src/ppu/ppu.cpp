@@ -1,32 +1,19 @@
 #include "ppu.h"
 
+#include <algorithm>
 #include <cstring>
+#include <utility>
 #include <vector>
 
 #include "cartridge/cartridge.h"
+#include "thread_pool.h"
 
 uint8_t PPU::PpuRead(uint16_t address) const {
 	if (address >= 0x2000 && address < 0x3F00) {
-		address &= 0x0FFF;
-		int table = 0;
-		if (cartridge_->mirroring_ == Cartridge::MirroringType::kVertical) {
-			table = (address & 0x400) ? 1 : 0;
-		}
-		else if (cartridge_->mirroring_ == Cartridge::MirroringType::kHorizontal) {
-			table = (address & 0x800) ? 1 : 0;
-		}
-		return name_table_[table][address & 0x3FF];
+		return ReadNametable(address);
 	}
 	else if (address >= 0x3F00 && address <= 0x3FFF) {
-		address &= 0x1F; // Mirror down to 0-31 range
-
-		// Handle mirroring of $3F10/$3F14/$3F18/$3F1C to $3F00/$3F04/$3F08/$3F0C
-		if ((address & 0x13) == 0x10) {
-			address &= ~0x10;
-		}
-
-		uint8_t color = palette_buffer_[address];
-		return color & (mask_.grayscale_ ? 0x30 : 0x3F);
+		return ReadPalette(address);
 	}
 
 	// Delegate to cartridge
@@ -35,15 +22,7 @@ uint8_t PPU::PpuRead(uint16_t address) const {
 
 void PPU::PpuWrite(uint16_t address, const uint8_t value) {
 	if (address >= 0x2000 && address < 0x3F00) {
-		address &= 0x0FFF;
-		int table = 0;
-		if (cartridge_->mirroring_ == Cartridge::MirroringType::kVertical) {
-			table = (address & 0x400) ? 1 : 0;
-		}
-		else if (cartridge_->mirroring_ == Cartridge::MirroringType::kHorizontal) {
-			table = (address & 0x800) ? 1 : 0;
-		}
-		name_table_[table][address & 0x3FF] = value;
+		name_table_[nametable_pages_[(address >> 10) & 0x03]][address & 0x3FF] = value;
 		return;
 	}
 	else if (address >= 0x3F00 && address <= 0x3FFF) {
@@ -67,6 +46,23 @@ void PPU::PpuWrite(uint16_t address, const uint8_t value) {
 	}
 }
 
+void PPU::SetCartridge(std::shared_ptr<Cartridge> cartridge) {
+	cartridge_ = std::move(cartridge);
+	if (cartridge_) UpdateNametablePages();
+}
+
+void PPU::UpdateNametablePages() {
+	// Page behind $2000, $2400, $2800 and $2C00, in MirroringType order
+	static constexpr uint8_t kPages[][4] = {
+		{0, 0, 1, 1}, // Horizontal
+		{0, 1, 0, 1}, // Vertical
+		{0, 1, 2, 3}, // Four-screen
+		{0, 0, 0, 0}, // Single-screen, lower
+		{1, 1, 1, 1}, // Single-screen, upper
+	};
+	std::memcpy(nametable_pages_, kPages[static_cast<int>(cartridge_->mirroring_)], sizeof(nametable_pages_));
+}
+
 uint8_t PPU::CpuRead(uint16_t address) {
 	uint8_t data = 0x00;
 
@@ -115,7 +111,15 @@ void PPU::CpuWrite(uint16_t address, uint8_t value) {
 		oam_address_ = value;
 		break;
 	case 0x0004: // OAM data register (OAMDATA)
-		oam_.bytes[oam_address_] = value;
+		if ((oam_address_ & 0x03) == 0 && oam_index_valid_) {
+			// Y byte, move the sprite to its new lines
+			IndexSprite(oam_address_ >> 2, false);
+			oam_.bytes[oam_address_] = value;
+			IndexSprite(oam_address_ >> 2, true);
+		}
+		else {
+			oam_.bytes[oam_address_] = value;
+		}
 		break;
 	case 0x0005: // PPU scroll register
 		if (!write_toggle_) {
@@ -153,128 +157,226 @@ void PPU::CpuWrite(uint16_t address, uint8_t value) {
 }
 
 
-void PPU::Step() {
-	// Following NESDev timings
-
-	// Functions for readability
-	auto ReverseByte = [](uint8_t b) -> uint8_t {
-		// Mirrors Byte horizontally
-		// Input: 0b00000101 becomes
-		//        0b10100000
-		b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
-		b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
-		b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
-		return b;
-	};
+void PPU::SetOffsetId() {
+	// Last 3 bytes of vram_address_ index the 4 nametables.
+	// Thus they serve as an offset for 0x2000 (Nametable address space start)
+	bg_tile_id_ = ReadNametable(vram_address_.value_);
+}
 
-	auto SetOffsetId = [&]() {
-		// Last 3 bytes of vram_address_ index the 4 nametables.
-		// Thus they serve as an offset for 0x2000 (Nametable address space start)
-		bg_tile_id_ = PpuRead(0x2000 | (vram_address_.value_ & 0x0FFF));
-	};
+void PPU::SetAttByte() {
+	bg_attribute_ = ReadNametable(0x23C0
+		| (vram_address_.nametable_y_ << 11)
+		| (vram_address_.nametable_x_ << 10)
+		| ((vram_address_.coarse_y_ >> 2) << 3)
+		| (vram_address_.coarse_x_ >> 2));
+	if (vram_address_.coarse_y_ & 0x02) bg_attribute_ >>= 4;
+	if (vram_address_.coarse_x_ & 0x02) bg_attribute_ >>= 2;
+	bg_attribute_ &= 0x03;
+}
 
-	auto SetAttByte = [&]() {
-		bg_attribute_ = PpuRead(0x23C0
-			| (vram_address_.nametable_y_ << 11)
-			| (vram_address_.nametable_x_ << 10)
-			| ((vram_address_.coarse_y_ >> 2) << 3)
-			| (vram_address_.coarse_x_ >> 2));
-		if (vram_address_.coarse_y_ & 0x02) bg_attribute_ >>= 4;
-		if (vram_address_.coarse_x_ & 0x02) bg_attribute_ >>= 2;
-		bg_attribute_ &= 0x03;
-	};
+void PPU::SetBgLsb() {
+	// Address: 1. 0x0000 or 0x1000 based on control register
+	//          2. Tile offset (tile ID × 16 bytes per tile)
+	//          3. Fine Y (0-7), specific pixel
+	bg_lsb_ = cartridge_->ChrRow((ctrl_.background_pattern_table_ << 12)
+		+ ((uint16_t)bg_tile_id_ << 4)
+		+ vram_address_.fine_y_).lsb_;
+}
 
-	auto SetBgLsb = [&]() {
-		// Address: 1. 0x0000 or 0x1000 based on control register
-		//          2. Tile offset (tile ID × 16 bytes per tile)
-		//          3. Fine Y (0-7), specific pixel
-		bg_lsb_ = PpuRead((ctrl_.background_pattern_table_ << 12)
-			+ ((uint16_t)bg_tile_id_ << 4)
-			+ (vram_address_.fine_y_ + 0));
-	};
+void PPU::SetBgMsb() {
+	// Other plane of the same row, 8 bytes further in CHR memory
+	bg_msb_ = cartridge_->ChrRow((ctrl_.background_pattern_table_ << 12)
+		+ ((uint16_t)bg_tile_id_ << 4)
+		+ vram_address_.fine_y_).msb_;
+}
 
-	auto SetBgMsb = [&]() {
-		// Same as LSB + 8 bytes
-		bg_msb_ = PpuRead((ctrl_.background_pattern_table_ << 12)
-			+ ((uint16_t)bg_tile_id_ << 4)
-			+ (vram_address_.fine_y_ + 8));
-	};
+void PPU::IncrementX() {
+	if (mask_.show_background_ || mask_.show_sprites_) {
+		if (vram_address_.coarse_x_ == 31) {
+			// Name table is 32x30, so we wrap to the start of next nametable
+			vram_address_.coarse_x_ = 0;
+			vram_address_.nametable_x_ = ~vram_address_.nametable_x_;
+		}
+		else {
+			// Otherwise, increment X
+			vram_address_.coarse_x_++;
+		}
+	}
+}
 
-	auto IncrementX = [&]() {
-		if (mask_.show_background_ || mask_.show_sprites_) {
-			if (vram_address_.coarse_x_ == 31) {
-				// Name table is 32x30, so we wrap to the start of next nametable
-				vram_address_.coarse_x_ = 0;
-				vram_address_.nametable_x_ = ~vram_address_.nametable_x_;
+void PPU::IncrementY() {
+	if (mask_.show_background_ || mask_.show_sprites_) {
+		// If fine_y < 7, just increment it
+		if (vram_address_.fine_y_ < 7) {
+			vram_address_.fine_y_++;
+		}
+		else {
+			// If we're at fine_y = 7, we need to increment coarse Y
+			// and reset fine_y to 0
+			vram_address_.fine_y_ = 0;
+
+			if (vram_address_.coarse_y_ == 29) {
+				// We've hit the bottom of the nametable
+				vram_address_.coarse_y_ = 0;
+				vram_address_.nametable_y_ = ~vram_address_.nametable_y_;
+			}
+			else if (vram_address_.coarse_y_ == 31) {
+				// We've hit the bottom of the attribute table
+				vram_address_.coarse_y_ = 0;
 			}
 			else {
-				// Otherwise, increment X
-				vram_address_.coarse_x_++;
+				vram_address_.coarse_y_++;
 			}
 		}
-	};
+	}
+}
+
+void PPU::UpdateVramX() {
+	// Cycle 257: Copy horizontal scrolling data from temporary VRAM address to the actual VRAM address
+	// This happens every scanline and is how the PPU supports horizontal scrolling
+	// By copying at scanline end, we ensure smooth scrolling even if game updates PPUSCROLL mid-frame
+	// and also allows for parallax by settings different scroll for different lines
+	if (mask_.show_background_ || mask_.show_sprites_) {
+		vram_address_.nametable_x_ = tram_address_.nametable_x_;
+		vram_address_.coarse_x_ = tram_address_.coarse_x_;
+	}
+}
+
+void PPU::UpdateVramY() {
+	// During pre-render scanline (-1), copy vertical scrolling data from temporary VRAM address
+	// This happens between cycles 280 and 304, once per frame
+	// This is how the PPU supports vertical scrolling, updating just before the new frame starts
+	// Multiple cycles are used for this operation as PPU needs time to synchronize counters
+	if (mask_.show_background_ || mask_.show_sprites_) {
+		// Copy all vertical scroll components from temp to vram address
+		vram_address_.fine_y_ = tram_address_.fine_y_;
+		vram_address_.nametable_y_ = tram_address_.nametable_y_;
+		vram_address_.coarse_y_ = tram_address_.coarse_y_;
+	}
+}
+
+void PPU::LoadBackgroundShiftRegisters() {
+	// Pattern data - shift left by 8 and load new tile data
+	bg_lsb_shift_reg = (bg_lsb_shift_reg & 0xFF00) | bg_lsb_;
+	bg_msb_shift_reg = (bg_msb_shift_reg & 0xFF00) | bg_msb_;
 
-	auto IncrementY = [&]() {
-		if (mask_.show_background_ || mask_.show_sprites_) {
-			// If fine_y < 7, just increment it
-			if (vram_address_.fine_y_ < 7) {
-				vram_address_.fine_y_++;
+	// Attribute data - shift left by 8 and expand single bits into full bytes (0x00 or 0xFF)
+	bg_att_lsb_shift_reg = (bg_att_lsb_shift_reg & 0xFF00) | ((bg_attribute_ & 0b01) ? 0xFF : 0x00);
+	bg_att_msb_shift_reg = (bg_att_msb_shift_reg & 0xFF00) | ((bg_attribute_ & 0b10) ? 0xFF : 0x00);
+}
+
+void PPU::EvaluateSprites() {
+	// Initialize sprites as off-screen (Y=0xFF makes sprite invisible)
+	std::memset(curr_scanline_sprites_, 0xFF, 8 * sizeof(Sprite));
+
+	// The index holds every sprite on this line, the first 8 in OAM order are drawn
+	if (!oam_index_valid_ || oam_index_height_ != SpriteHeight()) RebuildOamIndex();
+	uint64_t sprites = oam_index_[scanline_];
+	const int count = __builtin_popcountll(sprites);
+	curr_scanline_sprite_count_ = static_cast<uint8_t>(std::min(count, 8));
+	spriteZeroHitPossible_ = (sprites & 1) != 0;
+	for (int i = 0; i < curr_scanline_sprite_count_; i++) {
+		curr_scanline_sprites_[i] = oam_.sprites[__builtin_ctzll(sprites)];
+		sprites &= sprites - 1;
+	}
+
+	status_.sprite_overflow_ = count > 8;
+}
+
+void PPU::FetchSprites() {
+	// Now we're at the very end of the scanline, I'm going to prepare the 
+	// sprite line with the 8 or less selected sprites.
+	const ChrTileCache::Row* rows[8];
+
+	for (uint8_t i = 0; i < curr_scanline_sprite_count_; i++) {
+		// We need to extract the 8-bit row patterns of the sprite with the
+		// correct vertical offset. The "Sprite Mode" also affects this as
+		// the sprites may be 8 or 16 rows high. Additionally, the sprite
+		// can be flipped both vertically and horizontally. So there's a lot
+		// going on here :P
+
+		uint16_t sprite_pattern_addr_lo;
+
+		// Determine the memory addresses that contain the byte of pattern data. We
+		// only need the lo pattern address, because the hi pattern address is always
+		// offset by 8 from the lo address.
+		if (!ctrl_.sprite_size_) {
+			// 8x8 Sprite Mode - The control register determines the pattern table
+			if (!(curr_scanline_sprites_[i].flip_v_)) {
+				// Sprite is NOT flipped vertically, i.e. normal    
+				sprite_pattern_addr_lo =
+					(ctrl_.sprite_pattern_table_ << 12) // Which Pattern Table? 0KB or 4KB offset
+					| (curr_scanline_sprites_[i].tile_id_ << 4) // Which Cell? Tile ID * 16 (16 bytes per tile)
+					| (scanline_ - curr_scanline_sprites_[i].y_); // Which Row in cell? (0->7)
 			}
 			else {
-				// If we're at fine_y = 7, we need to increment coarse Y
-				// and reset fine_y to 0
-				vram_address_.fine_y_ = 0;
-
-				if (vram_address_.coarse_y_ == 29) {
-					// We've hit the bottom of the nametable
-					vram_address_.coarse_y_ = 0;
-					vram_address_.nametable_y_ = ~vram_address_.nametable_y_;
+				// Sprite is flipped vertically, i.e. upside down
+				sprite_pattern_addr_lo =
+					(ctrl_.sprite_pattern_table_ << 12) // Which Pattern Table? 0KB or 4KB offset
+					| (curr_scanline_sprites_[i].tile_id_ << 4) // Which Cell? Tile ID * 16 (16 bytes per tile)
+					| (7 - (scanline_ - curr_scanline_sprites_[i].y_)); // Which Row in cell? (7->0)
+			}
+		}
+		else {
+			// 8x16 Sprite Mode - The sprite attribute determines the pattern table
+			if (!(curr_scanline_sprites_[i].flip_v_)) {
+				// Sprite is NOT flipped vertically, i.e. normal
+				if (scanline_ - curr_scanline_sprites_[i].y_ < 8) {
+					// Reading Top half Tile
+					sprite_pattern_addr_lo =
+						((curr_scanline_sprites_[i].tile_id_ & 0x01) << 12) // Which Pattern Table? 0KB or 4KB offset
+						| ((curr_scanline_sprites_[i].tile_id_ & 0xFE) << 4) // Which Cell? Tile ID * 16 (16 bytes per tile)
+						| ((scanline_ - curr_scanline_sprites_[i].y_) & 0x07); // Which Row in cell? (0->7)
+				}
+				else {
+					// Reading Bottom Half Tile
+					sprite_pattern_addr_lo =
+						((curr_scanline_sprites_[i].tile_id_ & 0x01) << 12) // Which Pattern Table? 0KB or 4KB offset
+						| (((curr_scanline_sprites_[i].tile_id_ & 0xFE) + 1) << 4)
+						// Which Cell? Tile ID * 16 (16 bytes per tile)
+						| ((scanline_ - curr_scanline_sprites_[i].y_) & 0x07); // Which Row in cell? (0->7)
 				}
-				else if (vram_address_.coarse_y_ == 31) {
-					// We've hit the bottom of the attribute table
-					vram_address_.coarse_y_ = 0;
+			}
+			else {
+				// Sprite is flipped vertically, i.e. upside down
+				if (scanline_ - curr_scanline_sprites_[i].y_ < 8) {
+					// Reading Top half Tile
+					sprite_pattern_addr_lo =
+						((curr_scanline_sprites_[i].tile_id_ & 0x01) << 12) // Which Pattern Table? 0KB or 4KB offset
+						| (((curr_scanline_sprites_[i].tile_id_ & 0xFE) + 1) << 4)
+						// Which Cell? Tile ID * 16 (16 bytes per tile)
+						| (7 - (scanline_ - curr_scanline_sprites_[i].y_) & 0x07); // Which Row in cell? (0->7)
 				}
 				else {
-					vram_address_.coarse_y_++;
+					// Reading Bottom Half Tile
+					sprite_pattern_addr_lo =
+						((curr_scanline_sprites_[i].tile_id_ & 0x01) << 12) // Which Pattern Table? 0KB or 4KB offset
+						| ((curr_scanline_sprites_[i].tile_id_ & 0xFE) << 4) // Which Cell? Tile ID * 16 (16 bytes per tile)
+						| (7 - (scanline_ - curr_scanline_sprites_[i].y_) & 0x07); // Which Row in cell? (0->7)
 				}
 			}
 		}
-	};
 
-	auto UpdateVramX = [&]() {
-		// Cycle 257: Copy horizontal scrolling data from temporary VRAM address to the actual VRAM address
-		// This happens every scanline and is how the PPU supports horizontal scrolling
-		// By copying at scanline end, we ensure smooth scrolling even if game updates PPUSCROLL mid-frame
-		// and also allows for parallax by settings different scroll for different lines
-		if (mask_.show_background_ || mask_.show_sprites_) {
-			vram_address_.nametable_x_ = tram_address_.nametable_x_;
-			vram_address_.coarse_x_ = tram_address_.coarse_x_;
-		}
-	};
+		// Phew... XD I'm absolutely certain you can use some fantastic bit 
+		// manipulation to reduce all of that to a few one liners, but in this
+		// form it's easy to see the processes required for the different
+		// sizes and vertical orientations
 
-	auto UpdateVramY = [&]() {
-		// During pre-render scanline (-1), copy vertical scrolling data from temporary VRAM address
-		// This happens between cycles 280 and 304, once per frame
-		// This is how the PPU supports vertical scrolling, updating just before the new frame starts
-		// Multiple cycles are used for this operation as PPU needs time to synchronize counters
-		if (mask_.show_background_ || mask_.show_sprites_) {
-			// Copy all vertical scroll components from temp to vram address
-			vram_address_.fine_y_ = tram_address_.fine_y_;
-			vram_address_.nametable_y_ = tram_address_.nametable_y_;
-			vram_address_.coarse_y_ = tram_address_.coarse_y_;
-		}
-	};
+		// The tile cache holds the decoded row, already mirrored if the sprite
+		// is flipped horizontally
+		rows[i] = &cartridge_->ChrRow(sprite_pattern_addr_lo, curr_scanline_sprites_[i].flip_h_);
+	}
 
-	auto LoadBackgroundShiftRegisters = [&]() {
-		// Pattern data - shift left by 8 and load new tile data
-		bg_lsb_shift_reg = (bg_lsb_shift_reg & 0xFF00) | bg_lsb_;
-		bg_msb_shift_reg = (bg_msb_shift_reg & 0xFF00) | bg_msb_;
+	// Finally! We can draw the patterns into the line buffer ready for
+	// rendering on the next scanline
+	BuildSpriteLine(rows);
+}
 
-		// Attribute data - shift left by 8 and expand single bits into full bytes (0x00 or 0xFF)
-		bg_att_lsb_shift_reg = (bg_att_lsb_shift_reg & 0xFF00) | ((bg_attribute_ & 0b01) ? 0xFF : 0x00);
-		bg_att_msb_shift_reg = (bg_att_msb_shift_reg & 0xFF00) | ((bg_attribute_ & 0b10) ? 0xFF : 0x00);
-	};
+void PPU::Step() {
+	// Following NESDev timings
+	dot_count_++;
 
+	// Functions for readability
 	auto ShiftRenderingRegisters = [&]() {
 		if (mask_.show_background_) {
 			bg_lsb_shift_reg <<= 1;
@@ -283,17 +385,9 @@ void PPU::Step() {
 			bg_att_msb_shift_reg <<= 1;
 		}
 
-		if (mask_.show_sprites_ && cycle_ >= 1 && cycle_ <= 257) {
-			// Shift sprite shift registers only during visible cycles
-			for (int i = 0; i < curr_scanline_sprite_count_; i++) {
-				if (curr_scanline_sprites_[i].x_ > 0) {
-					curr_scanline_sprites_[i].x_--;
-				}
-				else {
-					sprite_lsb_shift_reg[i] <<= 1;
-					sprite_msb_shift_reg[i] <<= 1;
-				}
-			}
+		if (!mask_.show_sprites_ && cycle_ >= 1 && cycle_ <= 257) {
+			// Sprites do not shift while hidden, which moves the rest of the line right by a dot
+			sprite_line_delay_++;
 		}
 	};
 
@@ -311,10 +405,7 @@ void PPU::Step() {
 			status_.sprite_overflow_ = 0;
 			status_.sprite_0_hit_ = 0;
 
-			for (int i = 0; i < 8; i++) {
-				sprite_lsb_shift_reg[i] = 0;
-				sprite_msb_shift_reg[i] = 0;
-			}
+			std::memset(sprite_line_, 0, sizeof(sprite_line_));
 		}
 
 		// Loading pixel data for visible pixels
@@ -355,7 +446,7 @@ void PPU::Step() {
 
 		// Dummy read
 		if (cycle_ == 338 || cycle_ == 340) {
-			bg_tile_id_ = PpuRead(0x2000 | (vram_address_.value_ & 0x0FFF));
+			bg_tile_id_ = ReadNametable(vram_address_.value_);
 		}
 
 		// Vertical scrolling - only during pre-render scanline
@@ -367,160 +458,12 @@ void PPU::Step() {
 
 		// Sprite Evaluation Phase: Read OAM for possible sprites on this scanline
 		if (cycle_ == 257 && scanline_ >= 0) {
-			// Initialize sprites as off-screen (Y=0xFF makes sprite invisible)
-			std::memset(curr_scanline_sprites_, 0xFF, 8 * sizeof(Sprite));
-			curr_scanline_sprite_count_ = 0; // Clear current scanline sprite count
-
-			for (uint8_t i = 0; i < 8; i++) {
-				sprite_lsb_shift_reg[i] = 0;
-				sprite_msb_shift_reg[i] = 0;
-			}
-
-			uint8_t oamCurrIndex = 0;
-
-			spriteZeroHitPossible_ = false;
-
-			while (oamCurrIndex < 64 && curr_scanline_sprite_count_ < 9) {
-				int16_t diff = ((int16_t)scanline_ - (int16_t)oam_.sprites[oamCurrIndex].y_);
-				// If the difference is positive then the scanline is at least at the
-				// same height as the sprite, so check if it resides in the sprite vertically
-				// depending on the current "sprite height mode"
-				// FLAGGED
-
-				if (diff >= 0 && diff < (ctrl_.sprite_size_ ? 16 : 8) && curr_scanline_sprite_count_ < 8) {
-					// Sprite is visible, so copy the attribute entry over to our
-					// scanline sprite cache. Ive added < 8 here to guard the array
-					// being written to.
-					if (curr_scanline_sprite_count_ < 8) {
-						// Is this sprite sprite zero?
-						if (oamCurrIndex == 0) {
-							// It is, so its possible it may trigger a
-							// sprite zero hit when drawn
-							spriteZeroHitPossible_ = true;
-						}
-
-						curr_scanline_sprites_[curr_scanline_sprite_count_] = oam_.sprites[oamCurrIndex];
-					}
-					curr_scanline_sprite_count_++;
-				}
-				oamCurrIndex++;
-			}
-
-			status_.sprite_overflow_ = curr_scanline_sprite_count_ > 8;
+			EvaluateSprites();
 		}
 
-
-		// Sprite Rendering Phase: Load sprite pattern data into shift registers
+		// Sprite Rendering Phase: Draw the pattern data into the sprite line buffer
 		if (cycle_ == 340) {
-			// Now we're at the very end of the scanline, I'm going to prepare the 
-			// sprite shifters with the 8 or less selected sprites.
-
-			for (uint8_t i = 0; i < curr_scanline_sprite_count_; i++) {
-				// We need to extract the 8-bit row patterns of the sprite with the
-				// correct vertical offset. The "Sprite Mode" also affects this as
-				// the sprites may be 8 or 16 rows high. Additionally, the sprite
-				// can be flipped both vertically and horizontally. So there's a lot
-				// going on here :P
-
-				uint8_t sprite_pattern_bits_lo, sprite_pattern_bits_hi;
-				uint16_t sprite_pattern_addr_lo, sprite_pattern_addr_hi;
-
-				// Determine the memory addresses that contain the byte of pattern data. We
-				// only need the lo pattern address, because the hi pattern address is always
-				// offset by 8 from the lo address.
-				if (!ctrl_.sprite_size_) {
-					// 8x8 Sprite Mode - The control register determines the pattern table
-					if (!(curr_scanline_sprites_[i].flip_v_)) {
-						// Sprite is NOT flipped vertically, i.e. normal    
-						sprite_pattern_addr_lo =
-							(ctrl_.sprite_pattern_table_ << 12) // Which Pattern Table? 0KB or 4KB offset
-							| (curr_scanline_sprites_[i].tile_id_ << 4) // Which Cell? Tile ID * 16 (16 bytes per tile)
-							| (scanline_ - curr_scanline_sprites_[i].y_); // Which Row in cell? (0->7)
-					}
-					else {
-						// Sprite is flipped vertically, i.e. upside down
-						sprite_pattern_addr_lo =
-							(ctrl_.sprite_pattern_table_ << 12) // Which Pattern Table? 0KB or 4KB offset
-							| (curr_scanline_sprites_[i].tile_id_ << 4) // Which Cell? Tile ID * 16 (16 bytes per tile)
-							| (7 - (scanline_ - curr_scanline_sprites_[i].y_)); // Which Row in cell? (7->0)
-					}
-				}
-				else {
-					// 8x16 Sprite Mode - The sprite attribute determines the pattern table
-					if (!(curr_scanline_sprites_[i].flip_v_)) {
-						// Sprite is NOT flipped vertically, i.e. normal
-						if (scanline_ - curr_scanline_sprites_[i].y_ < 8) {
-							// Reading Top half Tile
-							sprite_pattern_addr_lo =
-								((curr_scanline_sprites_[i].tile_id_ & 0x01) << 12) // Which Pattern Table? 0KB or 4KB offset
-								| ((curr_scanline_sprites_[i].tile_id_ & 0xFE) << 4) // Which Cell? Tile ID * 16 (16 bytes per tile)
-								| ((scanline_ - curr_scanline_sprites_[i].y_) & 0x07); // Which Row in cell? (0->7)
-						}
-						else {
-							// Reading Bottom Half Tile
-							sprite_pattern_addr_lo =
-								((curr_scanline_sprites_[i].tile_id_ & 0x01) << 12) // Which Pattern Table? 0KB or 4KB offset
-								| (((curr_scanline_sprites_[i].tile_id_ & 0xFE) + 1) << 4)
-								// Which Cell? Tile ID * 16 (16 bytes per tile)
-								| ((scanline_ - curr_scanline_sprites_[i].y_) & 0x07); // Which Row in cell? (0->7)
-						}
-					}
-					else {
-						// Sprite is flipped vertically, i.e. upside down
-						if (scanline_ - curr_scanline_sprites_[i].y_ < 8) {
-							// Reading Top half Tile
-							sprite_pattern_addr_lo =
-								((curr_scanline_sprites_[i].tile_id_ & 0x01) << 12) // Which Pattern Table? 0KB or 4KB offset
-								| (((curr_scanline_sprites_[i].tile_id_ & 0xFE) + 1) << 4)
-								// Which Cell? Tile ID * 16 (16 bytes per tile)
-								| (7 - (scanline_ - curr_scanline_sprites_[i].y_) & 0x07); // Which Row in cell? (0->7)
-						}
-						else {
-							// Reading Bottom Half Tile
-							sprite_pattern_addr_lo =
-								((curr_scanline_sprites_[i].tile_id_ & 0x01) << 12) // Which Pattern Table? 0KB or 4KB offset
-								| ((curr_scanline_sprites_[i].tile_id_ & 0xFE) << 4) // Which Cell? Tile ID * 16 (16 bytes per tile)
-								| (7 - (scanline_ - curr_scanline_sprites_[i].y_) & 0x07); // Which Row in cell? (0->7)
-						}
-					}
-				}
-
-				// Phew... XD I'm absolutely certain you can use some fantastic bit 
-				// manipulation to reduce all of that to a few one liners, but in this
-				// form it's easy to see the processes required for the different
-				// sizes and vertical orientations
-
-				// Hi bit plane equivalent is always offset by 8 bytes from lo bit plane
-				sprite_pattern_addr_hi = sprite_pattern_addr_lo + 8;
-
-				// Now we have the address of the sprite patterns, we can read them
-				sprite_pattern_bits_lo = PpuRead(sprite_pattern_addr_lo);
-				sprite_pattern_bits_hi = PpuRead(sprite_pattern_addr_hi);
-
-				// If the sprite is flipped horizontally, we need to flip the 
-				// pattern bytes. 
-				if (curr_scanline_sprites_[i].flip_h_) {
-					// This little lambda function "flips" a byte
-					// so 0b11100000 becomes 0b00000111. It's very
-					// clever, and stolen completely from here:
-					// https://stackoverflow.com/a/2602885
-					auto flipbyte = [](uint8_t b) {
-						b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
-						b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
-						b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
-						return b;
-					};
-
-					// Flip Patterns Horizontally
-					sprite_pattern_bits_lo = flipbyte(sprite_pattern_bits_lo);
-					sprite_pattern_bits_hi = flipbyte(sprite_pattern_bits_hi);
-				}
-
-				// Finally! We can load the pattern into our sprite shift registers
-				// ready for rendering on the next scanline
-				sprite_lsb_shift_reg[i] = sprite_pattern_bits_lo;
-				sprite_msb_shift_reg[i] = sprite_pattern_bits_hi;
-			}
+			FetchSprites();
 		}
 	}
 
@@ -554,76 +497,52 @@ void PPU::Step() {
 	uint8_t fg_px_idx = 0x00;
 	uint8_t fg_pal_idx = 0x00;
 	uint8_t fg_prio = 0x00;
-	if (mask_.show_sprites_) {
-		spriteZeroRendered_ = false;
-
-		// Check each sprite for rendering
-		for (int i = 0; i < curr_scanline_sprite_count_; i++) {
-			const auto& sprite = curr_scanline_sprites_[i];
-			if (sprite.x_ == 0) {
-				// Sprite decrement hit 0, time to draw it
-
-				// Extract pattern (pixel) bits
-				uint8_t p0 = (sprite_lsb_shift_reg[i] & 0x80) > 0;
-				uint8_t p1 = (sprite_msb_shift_reg[i] & 0x80) > 0;
-				fg_px_idx = (p1 << 1) | p0;
-
-				if (fg_px_idx == 0) continue; // Transparent pixel, skip
-
-				fg_pal_idx = sprite.palette_ + 4;
-				fg_prio = sprite.priority_;
-
-				if (fg_px_idx != 0) {
-					if (i == 0) {
-						spriteZeroRendered_ = true;
-					}
-
-					break;
-				}
-			}
-		}
+	if (mask_.show_sprites_ && scanline_ < 240 && cycle_ >= 1 && cycle_ < 256) {
+		// Every dot the sprites shifted on moves one entry along the line
+		const uint8_t sprite = sprite_line_[cycle_ - 1 - sprite_line_delay_];
+		fg_px_idx = sprite & 0x03;
+		fg_pal_idx = (sprite & ScanlineCompositor::kIndexMask) >> 2;
+		fg_prio = (sprite & ScanlineCompositor::kBehindBackground) != 0;
+		spriteZeroRendered_ = (sprite & ScanlineCompositor::kSpriteZero) != 0;
 	}
 
 	// Final stage, render the actual pixel
 	if (scanline_ >= 0 && scanline_ < 240 && cycle_ >= 1 && cycle_ < 256) {
+		// A line recorded on an earlier frame is not drawn over this one
+		if (cycle_ == 1) recorded_rows_[scanline_] = false;
+
+		// The mask can hide either layer in the left 8 pixels
+		if (cycle_ <= 8) {
+			if (!mask_.show_background_leftmost_8px_) bg_px_idx = 0;
+			if (!mask_.show_sprites_leftmost_8px_) fg_px_idx = 0;
+		}
+
 		if (fg_px_idx != 0) {
 			// Foreground pixel is not transparent
 			if (bg_px_idx == 0 || !fg_prio) {
 				// Render sprite if:
 				// 1. Background is transparent, OR
 				// 2. Sprite has priority (priority_ = 0 means in front)
-				framebuffer_[scanline_ * kWidth + (cycle_ - 1)] = ResolvePaletteRamColor(fg_pal_idx, fg_px_idx);
+				SetPixel(GetFrameBufferColor(fg_pal_idx, fg_px_idx));
 			}
 			else {
 				// Background is not transparent and won sprite priority
-				framebuffer_[scanline_ * kWidth + (cycle_ - 1)] = ResolvePaletteRamColor(bg_pal_idx, bg_px_idx);
+				SetPixel(GetFrameBufferColor(bg_pal_idx, bg_px_idx));
 			}
 
+			// Both pixels are opaque here, so hidden left pixels cannot hit
 			if (bg_px_idx != 0 && spriteZeroHitPossible_ && spriteZeroRendered_ && mask_.show_background_ && mask_.
 				show_sprites_) {
-				// Check if we're in the valid range for sprite 0 hit
-				if (~(mask_.show_background_leftmost_8px_ | mask_.show_sprites_leftmost_8px_)) {
-					// If neither sprite nor BG rendering is enabled for left 8 pixels,
-					// sprite zero hit cannot occur in that region
-					if (cycle_ >= 9 && cycle_ < 258) {
-						status_.sprite_0_hit_ = 1;
-					}
-				}
-				else {
-					// Both sprite and BG rendering enabled for left pixels
-					if (cycle_ >= 1 && cycle_ < 258) {
-						status_.sprite_0_hit_ = 1;
-					}
-				}
+				status_.sprite_0_hit_ = 1;
 			}
 		}
 		else if (bg_px_idx != 0) {
 			// Background pixel is not transparent and Foreground is transparent
-			framebuffer_[scanline_ * kWidth + (cycle_ - 1)] = ResolvePaletteRamColor(bg_pal_idx, bg_px_idx);
+			SetPixel(GetFrameBufferColor(bg_pal_idx, bg_px_idx));
 		}
 		else {
 			// Both pixels are transparent, use universal background color
-			framebuffer_[scanline_ * kWidth + (cycle_ - 1)] = ResolvePaletteRamColor(0, 0);
+			SetPixel(GetFrameBufferColor(0, 0));
 		}
 	}
 
@@ -639,33 +558,376 @@ void PPU::Step() {
 	}
 }
 
-std::vector<PPU::Pixel> PPU::GetPatternTableSprite(const int table_idx, const int palette_id) {
-	std::vector<Pixel> sprite(128 * 128);
+void PPU::RenderScanline() {
+	const bool show_bg = mask_.show_background_;
+	const bool show_sprites = mask_.show_sprites_;
+
+	// Recorded lines are composed by DrawRecordedScanlines(), and without pixels to draw a line is
+	// not composed at all. Either way it is composed here if sprite 0 can still hit on it.
+	const bool hit_possible = spriteZeroHitPossible_ && show_bg && show_sprites && !status_.sprite_0_hit_;
+	const bool record = render_pixels_ && record_scanlines_;
+	const bool compose = (render_pixels_ && !record) || hit_possible;
+
+	// The sprite line was drawn on dot 340 of the line before, nothing has been delayed yet
+	static constexpr uint8_t kNoSprites[kWidth] = {};
+	const uint8_t* sprite_line = show_sprites ? sprite_line_ : kNoSprites;
+
+	if (record && scanline_records_.empty()) scanline_records_.resize(kHeight);
+	ScanlineRecord local;
+	ScanlineRecord* line = record ? &scanline_records_[scanline_] : compose ? &local : nullptr;
+	FetchScanline(line);
+
+	if (record) {
+		std::memcpy(line->sprites_, sprite_line, kWidth);
+		// Palette RAM cannot change during the line, resolve the 32 entries once
+		for (uint8_t i = 0; i < 32; i++) line->colors_[i] = GetFrameBufferColor(i >> 2, i & 3);
+		recorded_rows_[scanline_] = true;
+	}
+
+	if (compose) {
+		uint8_t background_line[kWidth];
+		BuildBackgroundLine(*line, background_line);
+		uint8_t indices[kWidth];
+		const bool hit = ScanlineCompositor::Compose(compositor_, background_line, sprite_line,
+			mask_.show_background_leftmost_8px_, mask_.show_sprites_leftmost_8px_, indices);
+		if (hit && spriteZeroHitPossible_ && show_bg && show_sprites) status_.sprite_0_hit_ = 1;
+
+		if (render_pixels_ && !record) {
+			uint16_t colors[32];
+			for (uint8_t i = 0; i < 32; i++) colors[i] = GetFrameBufferColor(i >> 2, i & 3);
+			WriteScanline(scanline_, indices, colors);
+		}
+	}
+
+	// State after dot 255: the last tile has been shifted 6 times, hidden sprites were held back
+	// on dots 2 to 255
+	if (show_bg) {
+		bg_lsb_shift_reg <<= 6;
+		bg_msb_shift_reg <<= 6;
+		bg_att_lsb_shift_reg <<= 6;
+		bg_att_msb_shift_reg <<= 6;
+	}
+	if (show_sprites) {
+		spriteZeroRendered_ = (sprite_line[kWidth - 2] & ScanlineCompositor::kSpriteZero) != 0;
+	}
+	else {
+		sprite_line_delay_ += 254;
+	}
+	cycle_ = 256;
+}
+
+// Background, one tile per group of 8 dots. The shift registers are reloaded on the first dot
+// of every group but the first, after which each pixel of the group is one more bit to the left.
+// From the third group on they only hold tiles fetched on this line, which are kept instead.
+void PPU::FetchScanline(ScanlineRecord* line) {
+	const bool show_bg = mask_.show_background_;
+	if (line) {
+		line->fine_x_ = fine_x_;
+		line->show_background_ = show_bg;
+		line->show_background_leftmost_8px_ = mask_.show_background_leftmost_8px_;
+		line->show_sprites_leftmost_8px_ = mask_.show_sprites_leftmost_8px_;
+	}
+
+	for (int tile = 0; tile < 32; tile++) {
+		if (tile > 0) {
+			if (show_bg) {
+				bg_lsb_shift_reg <<= 8;
+				bg_msb_shift_reg <<= 8;
+				bg_att_lsb_shift_reg <<= 8;
+				bg_att_msb_shift_reg <<= 8;
+			}
+			LoadBackgroundShiftRegisters();
+			SetOffsetId();
+		}
+
+		// Dots 8 * tile + 1 to 8 * tile + 8 draw columns 8 * tile to 8 * tile + 7
+		if (line && tile < 2) {
+			for (int j = 0; j < 8; j++) {
+				const int bit = 15 - fine_x_ - j;
+				const uint8_t bg_px = ((bg_msb_shift_reg >> bit & 1) << 1) | (bg_lsb_shift_reg >> bit & 1);
+				line->first_tiles_[tile * 8 + j] = show_bg && bg_px != 0
+					? (((bg_att_msb_shift_reg >> bit & 1) << 1) | (bg_att_lsb_shift_reg >> bit & 1)) * 4 + bg_px
+					: 0;
+			}
+		}
+
+		// Both planes come from one row, the pattern address cannot change during the line
+		SetAttByte();
+		const ChrTileCache::Row& row = cartridge_->ChrRow((ctrl_.background_pattern_table_ << 12)
+			+ ((uint16_t)bg_tile_id_ << 4)
+			+ vram_address_.fine_y_);
+		bg_lsb_ = row.lsb_;
+		bg_msb_ = row.msb_;
+		if (tile < 31) {
+			if (line) {
+				// The palette goes above each opaque pixel, all 8 at once
+				uint64_t pixels;
+				std::memcpy(&pixels, row.pixels_.data(), sizeof(pixels));
+				const uint64_t opaque = (pixels | pixels >> 1) & 0x0101010101010101;
+				pixels |= opaque * (bg_attribute_ << 2);
+				std::memcpy(&line->tile_pixels_[tile * 8], &pixels, sizeof(pixels));
+			}
+			IncrementX(); // The last one is on dot 256
+		}
+	}
+}
+
+void PPU::BuildBackgroundLine(const ScanlineRecord& line, uint8_t* background_line) {
+	std::memcpy(background_line, line.first_tiles_, sizeof(line.first_tiles_));
+	background_line[kWidth - 1] = 0; // Column 255 is not drawn
+	if (line.show_background_) {
+		// Each column after the first two tiles shows the pixel fine_x_ further in the fetched tiles
+		std::memcpy(background_line + 16, line.tile_pixels_ + line.fine_x_, kWidth - 17);
+	}
+	else {
+		std::memset(background_line + 16, 0, kWidth - 17);
+	}
+}
+
+void PPU::WriteScanline(const int row, const uint8_t* indices, const uint16_t* colors) {
+	uint16_t* pixels = &framebuffer_[row * kWidth];
+	bool changed = false;
+	for (int column = 0; column < kWidth - 1; column++) {
+		changed |= pixels[column] != colors[indices[column]];
+		pixels[column] = colors[indices[column]];
+	}
+	if (changed) row_versions_[row]++;
+}
+
+void PPU::DrawRecordedScanlines(ThreadPool& pool, const std::function<void(int row)>& on_row) {
+	// Each row is only touched by the iteration drawing it
+	pool.ParallelFor(kHeight, [&](const int row) {
+		if (recorded_rows_[row]) {
+			recorded_rows_[row] = false;
+			const ScanlineRecord& line = scanline_records_[row];
+			uint8_t background_line[kWidth];
+			BuildBackgroundLine(line, background_line);
+			uint8_t indices[kWidth];
+			ScanlineCompositor::Compose(compositor_, background_line, line.sprites_,
+				line.show_background_leftmost_8px_, line.show_sprites_leftmost_8px_, indices);
+			WriteScanline(row, indices, line.colors_);
+		}
+		if (on_row) on_row(row);
+	});
+}
+
+void PPU::IndexSprite(const int sprite, const bool visible) {
+	const int first = oam_.sprites[sprite].y_;
+	const int last = std::min(first + oam_index_height_, static_cast<int>(kHeight));
+	const uint64_t bit = uint64_t{1} << sprite;
+	for (int line = first; line < last; line++) {
+		if (visible) oam_index_[line] |= bit;
+		else oam_index_[line] &= ~bit;
+	}
+}
+
+void PPU::RebuildOamIndex() {
+	oam_index_.fill(0);
+	oam_index_height_ = SpriteHeight();
+	for (int sprite = 0; sprite < 64; sprite++) IndexSprite(sprite, true);
+	oam_index_valid_ = true;
+}
+
+void PPU::BuildSpriteLine(const ChrTileCache::Row* const* rows) {
+	// A sprite starts to shift once its x_ counter reaches 0, so it covers columns x_ to x_ + 7.
+	// Drawn from the back of the list, so the first opaque sprite in OAM order wins.
+	std::memset(sprite_line_, 0, sizeof(sprite_line_));
+	sprite_line_delay_ = 0;
+	for (int i = curr_scanline_sprite_count_ - 1; i >= 0; i--) {
+		const auto& sprite = curr_scanline_sprites_[i];
+		const uint8_t attributes = (sprite.palette_ + 4) * 4
+			| (sprite.priority_ ? ScanlineCompositor::kBehindBackground : 0)
+			| (i == 0 ? ScanlineCompositor::kSpriteZero : 0);
+		for (int j = 0; j < 8; j++) {
+			const uint8_t px = rows[i]->pixels_[j];
+			if (px != 0) sprite_line_[sprite.x_ + j] = attributes | px;
+		}
+	}
+}
+
+void PPU::BlankScanlines(const uint16_t lines) {
+	const uint16_t color = GetFrameBufferColor(0, 0);
+	for (int line = scanline_; render_pixels_ && line < scanline_ + lines; line++) {
+		recorded_rows_[line] = false;
+		uint16_t* row = &framebuffer_[line * kWidth];
+		if (std::all_of(row, row + kWidth - 1, [color](const uint16_t pixel) { return pixel == color; })) continue;
+		std::fill(row, row + kWidth - 1, color); // Column 255 is not drawn
+		row_versions_[line]++;
+	}
+
+	// Nothing moves the scroll position, so every tile fetch of these lines reads the same tile
+	// and only the sprites of the last line are left for the next one
+	scanline_ += lines - 1;
+	SetOffsetId();
+	SetAttByte();
+	SetBgLsb();
+	SetBgMsb();
+	LoadBackgroundShiftRegisters();
+	EvaluateSprites();
+	FetchSprites();
+	scanline_++;
+	cycle_ = 0;
+}
+
+void PPU::Run(uint32_t dots) {
+	// Step() counts the dots it runs, the ones skipped here are not
+	const uint64_t end_count = dot_count_ + dots;
+	while (dots > 0) {
+		// Visible lines with rendering disabled only show the backdrop, as many as there are dots for
+		if (cycle_ == 0 && scanline_ < 240 && !mask_.show_background_ && !mask_.show_sprites_ && dots >= 341) {
+			const uint32_t lines = std::min<uint32_t>(dots / 341, 240 - scanline_);
+			BlankScanlines(static_cast<uint16_t>(lines));
+			dots -= lines * 341;
+			continue;
+		}
+
+		// Visible part of a line at once, one dot shorter on the first line of an odd frame
+		if (cycle_ == 0 && scanline_ < 240) {
+			const bool skip = scanline_ == 0 && is_odd_frame_ && (mask_.show_background_ || mask_.show_sprites_);
+			const uint32_t span = skip ? 255 : 256;
+			if (dots >= span) {
+				RenderScanline();
+				dots -= span;
+				continue;
+			}
+		}
+
+		// Dots left before the next one Step() has work to do in, 0 if it is the current one
+		uint32_t idle = 0;
+		if (scanline_ < 240) {
+			// Between sprite evaluation (257) and the next line's first tile fetch (321)
+			if (cycle_ >= 258 && cycle_ <= 320) idle = 321 - cycle_;
+		}
+		else if (scanline_ == 0xFFFF) {
+			idle = 341 - cycle_; // The pre-render line is not rendered
+		}
+		else if (scanline_ == 240 || (scanline_ == 241 && cycle_ <= 1)) {
+			idle = (241 - scanline_) * 341 + 1 - cycle_; // Up to vertical blank at (241, 1)
+		}
+		else {
+			idle = (260 - scanline_) * 341 + 340 - cycle_; // Up to the end of the frame at (260, 340)
+		}
+
+		if (idle == 0) {
+			Step();
+			dots--;
+			continue;
+		}
+
+		idle = std::min(idle, dots);
+		const uint32_t position = cycle_ + idle;
+		scanline_ += position / 341; // The pre-render line wraps around to line 0
+		cycle_ = position % 341;
+		dots -= idle;
+	}
+	dot_count_ = end_count;
+}
+
+uint32_t PPU::DotsUntilVblank() const {
+	return DotsUntil(241, 1);
+}
+
+uint32_t PPU::DotsUntilFrameComplete() const {
+	return DotsUntil(260, 340);
+}
+
+uint16_t PPU::A12RiseCycle() const {
+	if (!mask_.show_background_ && !mask_.show_sprites_) return 0;
+	const bool sprites_high = ctrl_.sprite_size_ || ctrl_.sprite_pattern_table_;
+	if (sprites_high == static_cast<bool>(ctrl_.background_pattern_table_)) return 0;
+	return sprites_high ? 260 : 324;
+}
+
+uint32_t PPU::DotsUntilA12Rise() const {
+	const uint16_t cycle = A12RiseCycle();
+	if (cycle == 0) return 0;
+
+	// This line if it renders and has not reached the dot, else the next rendering line
+	uint16_t line = scanline_;
+	const bool renders = line < 240 || line == 0xFFFF;
+	if (!renders || cycle_ > cycle) {
+		line = line < 239 || line == 0xFFFF ? static_cast<uint16_t>(line + 1) : 0xFFFF;
+	}
+	return DotsUntil(line, cycle);
+}
+
+bool PPU::A12RoseOnLastDot() const {
+	const uint16_t cycle = A12RiseCycle();
+	return cycle != 0 && cycle_ == cycle + 1 && (scanline_ < 240 || scanline_ == 0xFFFF);
+}
+
+uint32_t PPU::DotsUntil(const uint16_t scanline, const uint16_t cycle) const {
+	constexpr int32_t kDotsPerLine = 341;
+	constexpr int32_t kDotsPerFrame = 262 * kDotsPerLine;
+	constexpr int32_t kOddFrameDot = kDotsPerLine; // Dot (0, 0)
+
+	// Positions in the frame, counted from the start of the pre-render line
+	const auto position = [](const uint16_t line, const uint16_t dot) {
+		return (line == 0xFFFF ? 0 : line + 1) * kDotsPerLine + dot;
+	};
+	int32_t from = position(scanline_, cycle_);
+	const int32_t to = position(scanline, cycle);
+
+	if (is_odd_frame_ && from <= kOddFrameDot && to > kOddFrameDot) from++;
+	if (to >= from) return static_cast<uint32_t>(to - from + 1);
+
+	// Next frame, which is odd if this one is not
+	const int32_t skipped = !is_odd_frame_ && to > kOddFrameDot ? 1 : 0;
+	return static_cast<uint32_t>(kDotsPerFrame - from + to + 1 - skipped);
+}
+
+PPU::RgbaTable PPU::BuildRgbaTable() {
+	// Each emphasis bit (red, green, blue) darkens the channels it does not select by about a fifth
+	constexpr uint32_t kDimmed = 209; // Out of 256
+
+	RgbaTable table{};
+	for (int entry = 0; entry < kColorCount; entry++) {
+		const Pixel color = kPalette[entry & 0x3F];
+		const uint8_t emphasis = entry >> 6;
+		uint32_t channels[3] = {color.r_, color.g_, color.b_};
+		for (int channel = 0; channel < 3; channel++) {
+			if (emphasis & ~(1 << channel)) channels[channel] = channels[channel] * kDimmed >> 8;
+		}
+		table[entry] = channels[0] << 24 | channels[1] << 16 | channels[2] << 8 | 0xFF;
+	}
+	return table;
+}
+
+void PPU::ConvertToRgba(const std::vector<uint16_t>& framebuffer, const RgbaTable& table, uint32_t* out,
+                        const int pitch) {
+	// One table load per pixel, simple enough for the compiler to vectorize
+	const uint16_t* entries = framebuffer.data();
+	const size_t count = framebuffer.size();
+	for (size_t row = 0; row * kWidth < count; row++, out += pitch) {
+		const size_t start = row * kWidth;
+		const size_t width = std::min<size_t>(kWidth, count - start);
+		for (size_t x = 0; x < width; x++) out[x] = table[entries[start + x] & (kColorCount - 1)];
+	}
+}
+
+void PPU::ConvertRowsToRgba(const std::vector<uint16_t>& framebuffer, const int first_row, const int row_count,
+                            const RgbaTable& table, uint32_t* out, const int pitch) {
+	const uint16_t* entries = &framebuffer[first_row * kWidth];
+	for (int row = 0; row < row_count; row++, entries += kWidth, out += pitch) {
+		for (int x = 0; x < kWidth; x++) out[x] = table[entries[x] & (kColorCount - 1)];
+	}
+}
+
+void PPU::RenderPatternTable(const int table_idx, const int palette_id, const RgbaTable& table, uint32_t* out,
+                             const int pitch) const {
+	uint32_t colors[4];
+	for (int i = 0; i < 4; i++) colors[i] = table[GetPaletteRamColor(palette_id, i)];
+
 	const int base_addr = table_idx * 0x1000; // 4KB per pattern table
 	for (int tile_y = 0; tile_y < 16; ++tile_y) {
-		for (int tile_x = 0; tile_x < 16; ++tile_x) {
-			const int tile_addr = base_addr + tile_y * 256 + tile_x * 16;
-			for (int row = 0; row < 8; ++row) {
-				uint8_t plane0 = PpuRead(tile_addr + row);
-				uint8_t plane1 = PpuRead(tile_addr + row + 8);
-				for (int col = 0; col < 8; ++col) {
-					// Extract the bit for this pixel from each bitplane
-					// Reading rightmost bit first since NES uses little-endian for pattern tiles
-					const uint8_t bit0 = (plane0 >> (7 - col)) & 1;
-					const uint8_t bit1 = (plane1 >> (7 - col)) & 1;
-					// Combine the two bits to get the NES color index (0-3)
-					uint8_t color_idx = (bit1 << 1) | bit0;
-
-					// Look up the RGB value from the NES palette
-					const uint16_t palette_addr = 0x3F00 + palette_id * 4 + color_idx;
-					const uint8_t palette_color_index = PpuRead(palette_addr) & 0x3F;
-					const Pixel px = GetPaletteColor(palette_color_index);
-					const int x = tile_x * 8 + (7 - col); // Flip X position since we read bits from right
-					const int y = tile_y * 8 + row;
-					sprite[y * 128 + x] = px;
-				}
+		for (int row = 0; row < 8; ++row) {
+			uint32_t* line = out + (tile_y * 8 + row) * pitch;
+			for (int tile_x = 0; tile_x < 16; ++tile_x) {
+				const int tile_addr = base_addr + tile_y * 256 + tile_x * 16;
+				// This view draws tiles mirrored
+				const auto& pixels = cartridge_->ChrRow(tile_addr + row, true).pixels_;
+				for (int col = 0; col < 8; ++col) line[tile_x * 8 + col] = colors[pixels[col]];
 			}
 		}
 	}
-	return sprite;
 }
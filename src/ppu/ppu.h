@@ -1,11 +1,17 @@
 #pragma once
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <set>
 #include <vector>
 
+#include "cartridge/chr_tile_cache.h"
+#include "scanline_compositor.h"
 
 class Cartridge;
+class ThreadPool;
 
 class PPU {
 public:
@@ -49,14 +55,23 @@ public:
     static constexpr int kWidth = 256;
     static constexpr int kHeight = 240;
 
+    // Framebuffer entries are a 6-bit palette color with the 3 PPUMASK emphasis bits above it
+    static constexpr int kColorCount = 512;
+    using RgbaTable = std::array<uint32_t, kColorCount>;
+
     static constexpr Pixel GetPaletteColor(const uint8_t idx) { return kPalette[idx]; }
 
-    uint8_t GetPaletteRamColor(const uint8_t pal_idx, const uint8_t px_idx) const {
-        return PpuRead(0x3F00 + pal_idx * 4 + px_idx) & 0x3F;
-    }
+    // RGBA8888 value of every framebuffer entry, emphasis dims the channels it does not select
+    [[nodiscard]] static RgbaTable BuildRgbaTable();
+    // Writes kWidth pixels per row into out, rows are pitch pixels apart (e.g. a locked texture)
+    static void ConvertToRgba(const std::vector<uint16_t>& framebuffer, const RgbaTable& table, uint32_t* out,
+                              int pitch = kWidth);
+    // Same for row_count rows starting at first_row, the first one is written at out
+    static void ConvertRowsToRgba(const std::vector<uint16_t>& framebuffer, int first_row, int row_count,
+                                  const RgbaTable& table, uint32_t* out, int pitch = kWidth);
 
-    Pixel ResolvePaletteRamColor(const uint8_t pal_idx, const uint8_t px_idx) const {
-        return GetPaletteColor(GetPaletteRamColor(pal_idx, px_idx));
+    uint8_t GetPaletteRamColor(const uint8_t pal_idx, const uint8_t px_idx) const {
+        return ReadPalette(pal_idx * 4 + px_idx) & 0x3F;
     }
 
     // =====================
@@ -66,11 +81,13 @@ public:
     ~PPU() = default;
 
     // Cartridge interface
-    std::shared_ptr<Cartridge> cartridge_;
-    bool was_nmi_triggered_;
+    // Connects the cartridge and points the nametable slots at the pages for its mirroring
+    void SetCartridge(std::shared_ptr<Cartridge> cartridge);
+    [[nodiscard]] const std::shared_ptr<Cartridge>& GetCartridge() const { return cartridge_; }
+    bool was_nmi_triggered_ = false;
     bool is_odd_frame_ = false;
-    bool spriteZeroHitPossible_;
-    bool spriteZeroRendered_;
+    bool spriteZeroHitPossible_ = false;
+    bool spriteZeroRendered_ = false;
 
     // PPU memory access
     // Called by the CPU via the Bus to access PPU registers ($2000-$2007)
@@ -81,19 +98,79 @@ public:
     uint8_t PpuRead(uint16_t address) const;
     void PpuWrite(uint16_t address, uint8_t value);
 
+    // Points the nametable slots at the pages for the cartridge's mirroring again. Needed after writes
+    // that can switch the mirroring.
+    void UpdateNametablePages();
+
     // Framebuffer access
-    const std::vector<Pixel>& GetFrameBuffer() const { return framebuffer_; }
+    const std::vector<uint16_t>& GetFrameBuffer() const { return framebuffer_; }
+
+    // Bumped whenever a pixel of the row changes, so consumers can skip rows they already have
+    using RowVersions = std::array<uint32_t, kHeight>;
+    [[nodiscard]] const RowVersions& GetRowVersions() const { return row_versions_; }
     bool frame_complete_ = false;
     uint8_t palette_buffer_[32] = {};
-    OAMMemory oam_; // OAM (Object Attribute Memory) for sprites, 64 entries (256 bytes total)
-    Sprite curr_scanline_sprites_[8]; // Sprites visible on the current scanline (max 8)
+    OAMMemory oam_ = {}; // OAM (Object Attribute Memory) for sprites, 64 entries (256 bytes total)
+    // Needed after writing oam_ directly instead of through OAMDATA, e.g. by the OAM DMA. The
+    // index of sprites by line is then rebuilt in bulk before the next sprite evaluation.
+    void InvalidateOamIndex() { oam_index_valid_ = false; }
+    Sprite curr_scanline_sprites_[8] = {}; // Sprites visible on the current scanline (max 8)
     uint8_t curr_scanline_sprite_count_ = 0; // If sprites exceed 8, the 9th sprite flag is set
 
     // Emulation step
     void Step();
 
+    // Dots run since power on, the timestamps of the inputs logged for a PpuRenderThread
+    uint64_t dot_count_ = 0;
+
+    // Off while a PpuRenderThread draws the frames: only the timing (vertical blank, NMI, sprite 0
+    // hits and status reads) is kept, lines are only composed when sprite 0 can hit
+    bool render_pixels_ = true;
+
+    // Capture mode: lines drawn a whole line at a time are only recorded, with everything they fetched,
+    // and drawn later by DrawRecordedScanlines(). Lines with PPU accesses in their visible part are
+    // still drawn dot by dot as they run, and sprite 0 hits are still found in time.
+    bool record_scanlines_ = false;
+
+    // Draws the recorded lines across the pool, e.g. once the frame is complete. on_row, if given, is
+    // called for every row once its pixels are final, on whichever thread drew it.
+    void DrawRecordedScanlines(ThreadPool& pool, const std::function<void(int row)>& on_row = nullptr);
+
+    // Takes the framebuffer of another PPU that ran in step with this one, e.g. a render thread's
+    void CopyPixelsFrom(const PPU& other) {
+        framebuffer_ = other.framebuffer_;
+        row_versions_ = other.row_versions_;
+    }
+
+    // Kernel merging background and sprites when whole lines are drawn at once
+    ScanlineCompositor::Kernel compositor_ = ScanlineCompositor::Best();
+
+    // Same as calling Step() dots times, skipping at once the dots that only advance the
+    // position: horizontal blank after sprite evaluation and the lines after the picture
+    void Run(uint32_t dots);
+
+    // Calls to Step() up to and including the one that starts vertical blank, raising the NMI,
+    // or completes the frame. Never more than the actual count, the odd frame dot is counted as
+    // skipped even with rendering disabled.
+    [[nodiscard]] uint32_t DotsUntilVblank() const;
+    [[nodiscard]] uint32_t DotsUntilFrameComplete() const;
+
+    // Rises of A12 on the PPU address bus, which MMC3 counts scanlines with. A12 goes high once a
+    // rendering line, when the fetches move from the pattern table at $0000 to the one at $1000:
+    // at dot 260 with the sprites at $1000 (8x16 sprites counted there), at dot 324 with the
+    // background there, and never when both use the same table or rendering is off.
+    [[nodiscard]] uint16_t A12RiseCycle() const;
+    // Calls to Step() up to and including the next rise, 0 if there is none. Never more than the
+    // actual count, like DotsUntilVblank().
+    [[nodiscard]] uint32_t DotsUntilA12Rise() const;
+    [[nodiscard]] bool A12RoseOnLastDot() const;
+
     // Debugging
-    std::vector<Pixel> GetPatternTableSprite(int table_idx, int palette_id);
+    static constexpr int kPatternTableSize = 128; // 16x16 tiles of 8x8 pixels
+
+    // Draws a pattern table with the given palette straight into out, rows are pitch pixels apart
+    void RenderPatternTable(int table_idx, int palette_id, const RgbaTable& table, uint32_t* out,
+                            int pitch = kPatternTableSize) const;
 
     // =====================
     // === NES Registers ===
@@ -130,8 +207,10 @@ public:
     uint16_t bg_msb_shift_reg = 0x0000;
 
 
-    uint8_t sprite_lsb_shift_reg[8]; // Shift registers for 8 sprites
-    uint8_t sprite_msb_shift_reg[8]; // Shift registers for 8 sprites
+    // Sprite pixels of the next line by column, drawn when the sprites are fetched on dot 340, in the
+    // compositor's format. Dots with sprites hidden do not shift them, which delays the rest of the line.
+    uint8_t sprite_line_[kWidth + 8] = {};
+    uint16_t sprite_line_delay_ = 0;
 
     //  PPU REGISTER STRUCTURES
     // PPUCTRL (the "control" or "controller" register) contains a mix of settings related to rendering
@@ -151,7 +230,7 @@ public:
         };
 
         uint8_t value_;
-    } ctrl_;
+    } ctrl_ = {};
 
     // PPUMASK (the "mask" register) controls the rendering of sprites and backgrounds, as well as color effects.
     // After power/reset, writes to this register are ignored until the first pre-render scanline.
@@ -170,7 +249,7 @@ public:
         };
 
         uint8_t value_;
-    } mask_;
+    } mask_ = {};
 
     // PPUSTATUS (the "status" register) reflects the state of rendering-related events and is primarily used for timing.
     // The three flags in this register are automatically cleared on dot 1 of the prerender scanline;
@@ -185,7 +264,7 @@ public:
         };
 
         uint8_t value_;
-    } status_;
+    } status_ = {};
 
 private:
     static constexpr Pixel kPalette[64] = {
@@ -207,13 +286,100 @@ private:
         [0x3C] = {160, 214, 228}, [0x3D] = {160, 162, 160}, [0x3E] = {0, 0, 0}, [0x3F] = {0, 0, 0}
     };
 
-    uint8_t name_table_[2][32 * 32] = {}; // 2 name tables, each 1024 (32*32) bytes
-    std::vector<Pixel> framebuffer_ = std::vector<Pixel>(kWidth * kHeight, {0, 0, 0});
+    std::shared_ptr<Cartridge> cartridge_;
+    uint8_t name_table_[4][32 * 32] = {}; // 4 name tables, each 1024 (32*32) bytes, 2 unless four-screen
+    uint8_t nametable_pages_[4] = {0, 0, 1, 1}; // Name table behind each 1KB slot from $2000
+    std::vector<uint16_t> framebuffer_ = std::vector<uint16_t>(kWidth * kHeight, 0x0F); // Black
+    RowVersions row_versions_ = {};
+
+    // What a visible line drawn by RenderScanline() shows, taken while its tiles are fetched
+    struct ScanlineRecord {
+        // Background palette RAM indices, 0 where transparent: the first two tiles come from the shift
+        // registers, the tiles fetched on the line are shown from the third one, fine_x_ pixels in
+        uint8_t first_tiles_[16];
+        uint8_t tile_pixels_[31 * 8];
+        uint8_t fine_x_;
+        bool show_background_;
+        bool show_background_leftmost_8px_;
+        bool show_sprites_leftmost_8px_;
+        uint8_t sprites_[kWidth]; // Copy of the sprite line, only for recorded lines
+        uint16_t colors_[32]; // Palette RAM with the emphasis, only for recorded lines
+    };
+
+    std::vector<ScanlineRecord> scanline_records_; // One per row, allocated when first recording
+    std::array<bool, kHeight> recorded_rows_ = {}; // Rows waiting for DrawRecordedScanlines()
+
+    // Bit n of a line is set if sprite n covers it, so evaluation does not scan OAM
+    std::array<uint64_t, kHeight> oam_index_ = {};
+    bool oam_index_valid_ = false;
+    int oam_index_height_ = 0; // Sprite height the index was built for
     uint16_t scanline_ = 0; // Current scanline (horizontal, 262 total)
     uint16_t cycle_ = 0; // Current cycle (vertical, 341 cycles per scanline)
     bool write_toggle_ = false;
     uint8_t data_buffer_ = 0x00;
     uint16_t oam_address_ = 0x0000;
-    uint8_t palette_written_to[32];
+    uint8_t palette_written_to[32] = {};
+
+    [[nodiscard]] uint32_t DotsUntil(uint16_t scanline, uint16_t cycle) const;
+
+    // Direct fetches for the rendering path, which knows the region of its addresses
+    [[nodiscard]] uint8_t ReadNametable(const uint16_t address) const {
+        return name_table_[nametable_pages_[(address >> 10) & 0x03]][address & 0x3FF];
+    }
+    [[nodiscard]] uint8_t ReadPalette(uint16_t address) const {
+        address &= 0x1F; // Mirror down to 0-31 range
+
+        // Handle mirroring of $3F10/$3F14/$3F18/$3F1C to $3F00/$3F04/$3F08/$3F0C
+        if ((address & 0x13) == 0x10) address &= ~0x10;
+        return palette_buffer_[address] & (mask_.grayscale_ ? 0x30 : 0x3F);
+    }
+
+    // Framebuffer entry of a palette RAM color with the current emphasis
+    [[nodiscard]] uint16_t GetFrameBufferColor(uint8_t pal_idx, uint8_t px_idx) const {
+        return GetPaletteRamColor(pal_idx, px_idx) | (mask_.value_ & 0xE0) << 1;
+    }
+
+    // Writes the pixel of the current dot, bumping the row version if it changed
+    void SetPixel(const uint16_t color) {
+        if (!render_pixels_) return;
+        uint16_t& pixel = framebuffer_[scanline_ * kWidth + (cycle_ - 1)];
+        if (pixel == color) return;
+        pixel = color;
+        row_versions_[scanline_]++;
+    }
 
+    // Background fetches and scroll counter updates done by Step() on their dots
+    void SetOffsetId();
+    void SetAttByte();
+    void SetBgLsb();
+    void SetBgMsb();
+    void IncrementX();
+    void IncrementY();
+    void UpdateVramX();
+    void UpdateVramY();
+    void LoadBackgroundShiftRegisters();
+
+    [[nodiscard]] int SpriteHeight() const { return ctrl_.sprite_size_ ? 16 : 8; }
+    // Adds or removes a sprite from the index lines it covers at its current Y
+    void IndexSprite(int sprite, bool visible);
+    void RebuildOamIndex();
+
+    // Sprite evaluation on dot 257 and the sprite fetches ending on dot 340
+    void EvaluateSprites();
+    void FetchSprites();
+
+    // Draws the fetched row of each selected sprite into sprite_line_
+    void BuildSpriteLine(const ChrTileCache::Row* const* rows);
+
+    // Dots 0 to 255 of a visible line at once, same result as 256 calls to Step()
+    void RenderScanline();
+    // The tile fetches of RenderScanline(), which fill the line's record if one is given
+    void FetchScanline(ScanlineRecord* line);
+    // Background palette RAM indices of a line, 0 where transparent
+    static void BuildBackgroundLine(const ScanlineRecord& line, uint8_t* background_line);
+    // Writes the composed line to a row, bumping its version if it changed
+    void WriteScanline(int row, const uint8_t* indices, const uint16_t* colors);
+    // Whole visible lines from the current one with rendering disabled, same result as 341 calls
+    // to Step() per line
+    void BlankScanlines(uint16_t lines);
 };
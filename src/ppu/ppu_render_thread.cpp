@@ -0,0 +1,129 @@
+#include "ppu_render_thread.h"
+
+#include "cartridge/cartridge.h"
+
+PpuRenderThread::PpuRenderThread(const PPU& ppu) : replica_(ppu) {
+    // Bank switches reach the copy through the log, at the dot they were made on
+    replica_.SetCartridge(ppu.GetCartridge()->Clone());
+    replica_.render_pixels_ = true;
+    replica_.record_scanlines_ = false;
+
+    for (Frame& frame : frames_) {
+        frame.framebuffer_ = ppu.GetFrameBuffer();
+        frame.row_versions_ = ppu.GetRowVersions();
+    }
+    thread_ = std::thread(&PpuRenderThread::Run, this);
+}
+
+PpuRenderThread::~PpuRenderThread() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        flush_count_++;
+    }
+    flushed_.notify_one();
+    thread_.join();
+}
+
+void PpuRenderThread::Log(const Input& input) {
+    while (!queue_.Push(input)) {
+        Flush(); // The renderer may be waiting for the end of the frame
+        std::this_thread::yield();
+    }
+}
+
+void PpuRenderThread::Publish(const uint64_t dot) {
+    Log({dot, 0, 0, Input::Kind::kPublish});
+    Flush();
+}
+
+void PpuRenderThread::Stop(const uint64_t dot, PPU& ppu) {
+    Log({dot, 0, 0, Input::Kind::kPublish});
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        flush_count_++;
+    }
+    flushed_.notify_one();
+    thread_.join();
+    ppu.CopyPixelsFrom(replica_);
+}
+
+bool PpuRenderThread::AcquireFrame() {
+    if (!(ready_.load(std::memory_order_relaxed) & kFresh)) return false;
+    front_ = ready_.exchange(front_, std::memory_order_acq_rel) & kSlotMask;
+    return true;
+}
+
+void PpuRenderThread::WaitForFrame(const uint64_t number) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        published_.wait(lock, [&] { return publish_count_ >= number; });
+    }
+    AcquireFrame();
+}
+
+// Inputs are only announced to the renderer in batches, so logging one costs no lock
+void PpuRenderThread::Flush() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flush_count_++;
+    }
+    flushed_.notify_one();
+}
+
+void PpuRenderThread::Run() {
+    uint64_t flushes_seen = 0;
+    Input input;
+    while (true) {
+        while (queue_.Pop(input)) Apply(input);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        flushed_.wait(lock, [&] { return flush_count_ != flushes_seen; });
+        flushes_seen = flush_count_;
+        if (stopping_) {
+            lock.unlock();
+            while (queue_.Pop(input)) Apply(input);
+            return;
+        }
+    }
+}
+
+void PpuRenderThread::Apply(const Input& input) {
+    replica_.Run(static_cast<uint32_t>(input.dot_ - replica_.dot_count_));
+
+    switch (input.kind_) {
+    case Input::Kind::kRegisterWrite:
+        replica_.CpuWrite(input.address_, input.value_);
+        break;
+    case Input::Kind::kRegisterRead:
+        (void)replica_.CpuRead(input.address_);
+        break;
+    case Input::Kind::kOamWrite:
+        replica_.oam_.bytes[input.address_] = input.value_;
+        replica_.InvalidateOamIndex();
+        break;
+    case Input::Kind::kCartridgeWrite:
+        replica_.GetCartridge()->CpuWrite(input.address_, input.value_);
+        replica_.UpdateNametablePages();
+        break;
+    case Input::Kind::kPublish:
+        PublishFrame();
+        break;
+    }
+}
+
+void PpuRenderThread::PublishFrame() {
+    Frame& frame = frames_[back_];
+    frame.framebuffer_ = replica_.GetFrameBuffer();
+    frame.row_versions_ = replica_.GetRowVersions();
+    frame.number_ = ++frames_rendered_;
+    back_ = ready_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kSlotMask;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        publish_count_ = frames_rendered_;
+    }
+    published_.notify_all();
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ppu.h"
+#include "spsc_queue.h"
+
+// Draws the frames of a PPU on another thread. The emulated PPU only keeps the timing and logs every
+// input that can change the picture with the dot it arrived on; a copy of it, with its own clone of
+// the cartridge, replays the log and publishes the framebuffer at each frame end. Frames are handed
+// to the display through three buffers, so neither side ever waits for the other.
+class PpuRenderThread {
+public:
+    // =====================
+    // === Types & Consts ===
+    // =====================
+    struct Input {
+        enum class Kind : uint8_t {
+            kRegisterWrite, // $2000-$2007, address_ is the register
+            kRegisterRead, // $2002 and $2007 reads move the write toggle, the read buffer and v
+            kOamWrite, // OAM DMA byte, address_ is the OAM offset
+            kCartridgeWrite, // Mapper registers, which switch CHR banks and mirroring
+            kPublish, // Frame end, the framebuffer up to dot_ is handed to the display
+        };
+
+        uint64_t dot_; // PPU::dot_count_ of the emulated PPU when it arrived
+        uint16_t address_;
+        uint8_t value_;
+        Kind kind_;
+    };
+
+    struct Frame {
+        std::vector<uint16_t> framebuffer_;
+        PPU::RowVersions row_versions_;
+        uint64_t number_ = 0; // Frames published up to this one, 0 before the first
+    };
+
+    static constexpr size_t kQueueSize = 1 << 16; // A few frames of $2002 polling
+
+    // =====================
+    // === Public API ======
+    // =====================
+    // Starts from a copy of the PPU, whose inputs must all be logged from here on
+    explicit PpuRenderThread(const PPU& ppu);
+    ~PpuRenderThread();
+
+    PpuRenderThread(const PpuRenderThread&) = delete;
+    PpuRenderThread& operator=(const PpuRenderThread&) = delete;
+
+    // Emulation thread: queues an input, waiting for room if the renderer is that far behind
+    void Log(const Input& input);
+    // Queues the end of a frame at the dot and wakes the renderer
+    void Publish(uint64_t dot);
+    // Renders everything up to the dot, stops the thread and hands the pixels back to the PPU
+    void Stop(uint64_t dot, PPU& ppu);
+
+    // Display thread: takes the newest published frame if it has not been taken yet
+    bool AcquireFrame();
+    // Waits until the frame with the number has been published, then takes the newest one
+    void WaitForFrame(uint64_t number);
+    // The frame last taken, or the picture of the PPU when the thread started
+    [[nodiscard]] const Frame& CurrentFrame() const { return frames_[front_]; }
+
+private:
+    // =====================
+    // === Internal State ==
+    // =====================
+    static constexpr uint8_t kSlotMask = 0x03;
+    static constexpr uint8_t kFresh = 0x04; // Set on the ready slot until the display takes it
+
+    PPU replica_; // Only touched by the thread, like the count
+    uint64_t frames_rendered_ = 0;
+    SpscQueue<Input, kQueueSize> queue_;
+
+    // Wakes the renderer when the emulation flushes the log, and the display when a frame is published
+    std::mutex mutex_;
+    std::condition_variable flushed_;
+    std::condition_variable published_;
+    uint64_t flush_count_ = 0;
+    uint64_t publish_count_ = 0;
+    bool stopping_ = false;
+
+    Frame frames_[3];
+    uint8_t front_ = 0; // Read by the display
+    uint8_t back_ = 1; // Written by the renderer
+    std::atomic<uint8_t> ready_{2}; // Exchanged by both, with kFresh
+
+    std::thread thread_;
+
+    void Flush();
+    void Run();
+    void Apply(const Input& input);
+    void PublishFrame();
+};
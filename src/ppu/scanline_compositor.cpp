@@ -0,0 +1,140 @@
+#include "scanline_compositor.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define SCANLINE_COMPOSITOR_X64 1
+#endif
+
+namespace {
+    // Palette index of one pixel, true in hit if sprite 0 is over the background
+    uint8_t ComposePixel(const uint8_t background, const uint8_t sprite, bool& hit) {
+        const uint8_t index = sprite & ScanlineCompositor::kIndexMask;
+        if (index == 0) return background;
+        if (background == 0) return index;
+
+        if (sprite & ScanlineCompositor::kSpriteZero) hit = true;
+        return sprite & ScanlineCompositor::kBehindBackground ? background : index;
+    }
+
+    bool ComposeScalar(const uint8_t* background, const uint8_t* sprites, const bool show_background_left,
+                       const bool show_sprites_left, uint8_t* out) {
+        bool hit = false;
+        for (int x = 0; x < ScanlineCompositor::kWidth; x++) {
+            const bool left = x < 8;
+            const uint8_t bg = left && !show_background_left ? 0 : background[x];
+            const uint8_t fg = left && !show_sprites_left ? 0 : sprites[x];
+            out[x] = ComposePixel(bg, fg, hit);
+        }
+        return hit;
+    }
+
+#ifdef SCANLINE_COMPOSITOR_X64
+    // Opaque bytes are turned into 0xFF masks, the sprite 0 flag is the sign bit so hits are
+    // collected with a movemask at the end
+    bool ComposeSse2(const uint8_t* background, const uint8_t* sprites, const bool show_background_left,
+                     const bool show_sprites_left, uint8_t* out) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ones = _mm_set1_epi8(-1);
+        const __m128i index_bits = _mm_set1_epi8(ScanlineCompositor::kIndexMask);
+        const __m128i behind_bit = _mm_set1_epi8(ScanlineCompositor::kBehindBackground);
+        const __m128i left_bg = show_background_left ? ones : _mm_set_epi64x(-1, 0);
+        const __m128i left_fg = show_sprites_left ? ones : _mm_set_epi64x(-1, 0);
+
+        __m128i hits = zero;
+        for (int x = 0; x < ScanlineCompositor::kWidth; x += 16) {
+            __m128i bg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(background + x));
+            __m128i fg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sprites + x));
+            if (x == 0) {
+                bg = _mm_and_si128(bg, left_bg);
+                fg = _mm_and_si128(fg, left_fg);
+            }
+
+            const __m128i index = _mm_and_si128(fg, index_bits);
+            const __m128i fg_opaque = _mm_andnot_si128(_mm_cmpeq_epi8(index, zero), ones);
+            const __m128i bg_opaque = _mm_andnot_si128(_mm_cmpeq_epi8(bg, zero), ones);
+            const __m128i behind = _mm_cmpeq_epi8(_mm_and_si128(fg, behind_bit), behind_bit);
+
+            const __m128i use_fg = _mm_andnot_si128(_mm_and_si128(bg_opaque, behind), fg_opaque);
+            hits = _mm_or_si128(hits, _mm_and_si128(_mm_and_si128(fg_opaque, bg_opaque), fg));
+            const __m128i pixels = _mm_or_si128(_mm_and_si128(use_fg, index), _mm_andnot_si128(use_fg, bg));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), pixels);
+        }
+        return _mm_movemask_epi8(hits) != 0;
+    }
+
+#if defined(__GNUC__)
+#define SCANLINE_COMPOSITOR_AVX2 1
+
+    // Same as ComposeSse2, 32 pixels at a time
+    __attribute__((target("avx2")))
+    bool ComposeAvx2(const uint8_t* background, const uint8_t* sprites, const bool show_background_left,
+                     const bool show_sprites_left, uint8_t* out) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i ones = _mm256_set1_epi8(-1);
+        const __m256i index_bits = _mm256_set1_epi8(ScanlineCompositor::kIndexMask);
+        const __m256i behind_bit = _mm256_set1_epi8(ScanlineCompositor::kBehindBackground);
+        const __m256i left_bg = show_background_left ? ones : _mm256_set_epi64x(-1, -1, -1, 0);
+        const __m256i left_fg = show_sprites_left ? ones : _mm256_set_epi64x(-1, -1, -1, 0);
+
+        __m256i hits = zero;
+        for (int x = 0; x < ScanlineCompositor::kWidth; x += 32) {
+            __m256i bg = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(background + x));
+            __m256i fg = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sprites + x));
+            if (x == 0) {
+                bg = _mm256_and_si256(bg, left_bg);
+                fg = _mm256_and_si256(fg, left_fg);
+            }
+
+            const __m256i index = _mm256_and_si256(fg, index_bits);
+            const __m256i fg_opaque = _mm256_andnot_si256(_mm256_cmpeq_epi8(index, zero), ones);
+            const __m256i bg_opaque = _mm256_andnot_si256(_mm256_cmpeq_epi8(bg, zero), ones);
+            const __m256i behind = _mm256_cmpeq_epi8(_mm256_and_si256(fg, behind_bit), behind_bit);
+
+            const __m256i use_fg = _mm256_andnot_si256(_mm256_and_si256(bg_opaque, behind), fg_opaque);
+            hits = _mm256_or_si256(hits, _mm256_and_si256(_mm256_and_si256(fg_opaque, bg_opaque), fg));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_blendv_epi8(bg, index, use_fg));
+        }
+        return _mm256_movemask_epi8(hits) != 0;
+    }
+#endif
+#endif
+}
+
+bool ScanlineCompositor::IsSupported(const Kernel kernel) {
+    switch (kernel) {
+    case Kernel::kScalar:
+        return true;
+#ifdef SCANLINE_COMPOSITOR_X64
+    case Kernel::kSse2:
+        return true; // Part of x86-64
+#endif
+#ifdef SCANLINE_COMPOSITOR_AVX2
+    case Kernel::kAvx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+ScanlineCompositor::Kernel ScanlineCompositor::Best() {
+    if (IsSupported(Kernel::kAvx2)) return Kernel::kAvx2;
+    if (IsSupported(Kernel::kSse2)) return Kernel::kSse2;
+    return Kernel::kScalar;
+}
+
+bool ScanlineCompositor::Compose(const Kernel kernel, const uint8_t* background, const uint8_t* sprites,
+                                 const bool show_background_left, const bool show_sprites_left, uint8_t* out) {
+    switch (kernel) {
+#ifdef SCANLINE_COMPOSITOR_X64
+    case Kernel::kSse2:
+        return ComposeSse2(background, sprites, show_background_left, show_sprites_left, out);
+#endif
+#ifdef SCANLINE_COMPOSITOR_AVX2
+    case Kernel::kAvx2:
+        return ComposeAvx2(background, sprites, show_background_left, show_sprites_left, out);
+#endif
+    default:
+        return ComposeScalar(background, sprites, show_background_left, show_sprites_left, out);
+    }
+}
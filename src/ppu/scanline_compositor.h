@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+// Merges the background and sprite pixels of a whole scanline into palette RAM indices: sprite
+// priority, transparency, the left 8 pixel mask bits and sprite 0 hit detection. The same work is
+// done by the SIMD kernels 16 or 32 pixels at a time, the fastest one the CPU supports is used.
+class ScanlineCompositor {
+public:
+    // =====================
+    // === Types & Consts ===
+    // =====================
+    enum class Kernel : uint8_t {
+        kScalar,
+        kSse2,
+        kAvx2
+    };
+
+    static constexpr int kWidth = 256;
+
+    // Sprite line bytes hold the palette RAM index (16-31, 0 when transparent) and these flags
+    static constexpr uint8_t kIndexMask = 0x1F;
+    static constexpr uint8_t kBehindBackground = 0x40;
+    static constexpr uint8_t kSpriteZero = 0x80;
+
+    // =====================
+    // === Public API ======
+    // =====================
+    [[nodiscard]] static bool IsSupported(Kernel kernel);
+    [[nodiscard]] static Kernel Best();
+
+    // Background bytes are palette RAM indices (0-15, 0 when transparent). Writes the index of
+    // every pixel to out and returns whether an opaque pixel of sprite 0 was over an opaque
+    // background pixel. Hiding the left 8 pixels of a layer makes them transparent.
+    static bool Compose(Kernel kernel, const uint8_t* background, const uint8_t* sprites, bool show_background_left,
+                        bool show_sprites_left, uint8_t* out);
+};
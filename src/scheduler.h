@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Upcoming events that need the CPU and the PPU to be in sync, ordered by master timestamp.
+// Timestamps count master ticks since power on (one PPU dot, a third of a CPU cycle) and are
+// 64-bit so they never wrap. Each kind of event is pending at most once, which keeps the queue
+// a few entries long, so it is kept sorted in a fixed array.
+class Scheduler {
+public:
+    // =====================
+    // === Types & Consts ===
+    // =====================
+    enum class Event : uint8_t {
+        kNmi, // The PPU enters vertical blank and may raise an NMI
+        kFrameEnd, // The PPU completes a frame
+        kDmaEnd, // Last cycle of an OAM DMA, the CPU runs again after it
+        kA12Rise, // PPU A12 rises, which clocks the MMC3 scanline counter
+        kCount
+    };
+
+    static constexpr size_t kEventCount = static_cast<size_t>(Event::kCount);
+
+    // =====================
+    // === Public API ======
+    // =====================
+
+    // Replaces the pending occurrence of the event, if any
+    void Schedule(const Event event, const uint64_t timestamp) {
+        Cancel(event);
+
+        // Earliest event last, events due on the same tick run in the order they were scheduled
+        size_t i = size_;
+        while (i > 0 && queue_[i - 1].timestamp_ <= timestamp) {
+            queue_[i] = queue_[i - 1];
+            i--;
+        }
+        queue_[i] = {timestamp, event};
+        size_++;
+    }
+
+    void Cancel(const Event event) {
+        for (size_t i = 0; i < size_; i++) {
+            if (queue_[i].event_ == event) {
+                for (size_t j = i + 1; j < size_; j++) queue_[j - 1] = queue_[j];
+                size_--;
+                return;
+            }
+        }
+    }
+
+    [[nodiscard]] bool IsScheduled(const Event event) const {
+        for (size_t i = 0; i < size_; i++) {
+            if (queue_[i].event_ == event) return true;
+        }
+        return false;
+    }
+
+    [[nodiscard]] bool IsEmpty() const {
+        return size_ == 0;
+    }
+
+    // Timestamp of the earliest event, the queue must not be empty
+    [[nodiscard]] uint64_t NextTimestamp() const {
+        return queue_[size_ - 1].timestamp_;
+    }
+
+    // Removes and returns the earliest event, the queue must not be empty
+    Event Pop() {
+        size_--;
+        return queue_[size_].event_;
+    }
+
+private:
+    // =====================
+    // === Internal State ==
+    // =====================
+    struct Entry {
+        uint64_t timestamp_;
+        Event event_;
+    };
+
+    std::array<Entry, kEventCount> queue_{}; // Sorted by descending timestamp
+    size_t size_ = 0;
+};
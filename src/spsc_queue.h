@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Fixed-size ring buffer between one producer thread and one consumer thread. Each side only
+// stores its own index and caches the other one, so neither Push() nor Pop() takes a lock and the
+// shared indices are only read again when the cached one says the queue is full or empty.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side, false if the queue is full
+    bool Push(const T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == Capacity) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == Capacity) return false;
+        }
+        items_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, false if the queue is empty
+    bool Pop(T& item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) return false;
+        }
+        item = items_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // The indices only grow, each on its own cache line with the copy of the other kept by its side
+    static constexpr size_t kCacheLine = 64;
+
+    alignas(kCacheLine) std::atomic<size_t> head_{0}; // Next item to pop, written by the consumer
+    size_t tail_cache_ = 0;
+    alignas(kCacheLine) std::atomic<size_t> tail_{0}; // Next free slot, written by the producer
+    size_t head_cache_ = 0;
+    alignas(kCacheLine) std::array<T, Capacity> items_{};
+};
@@ -0,0 +1,59 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(const unsigned threads) {
+    for (unsigned i = 1; i < threads; i++) {
+        workers_.emplace_back(&ThreadPool::Work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    start_.notify_all();
+    for (std::thread& worker : workers_) worker.join();
+}
+
+void ThreadPool::ParallelFor(const int count, const std::function<void(int)>& body) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        body_ = &body;
+        count_ = count;
+        next_.store(0, std::memory_order_relaxed);
+        busy_workers_ = static_cast<unsigned>(workers_.size());
+        loop_count_++;
+    }
+    start_.notify_all();
+
+    RunIterations();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&] { return busy_workers_ == 0; });
+    body_ = nullptr;
+}
+
+void ThreadPool::Work() {
+    uint64_t loops_seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [&] { return stopping_ || loop_count_ != loops_seen; });
+            if (stopping_) return;
+            loops_seen = loop_count_;
+        }
+
+        RunIterations();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--busy_workers_ == 0) done_.notify_one();
+    }
+}
+
+// Each thread takes the next iteration until there are none left
+void ThreadPool::RunIterations() {
+    for (int i = next_.fetch_add(1, std::memory_order_relaxed); i < count_;
+         i = next_.fetch_add(1, std::memory_order_relaxed)) {
+        (*body_)(i);
+    }
+}
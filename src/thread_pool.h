@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run the iterations of a loop together with the calling thread
+class ThreadPool {
+public:
+    // Threads taking part in a loop, the caller included. With one, loops run on the caller alone.
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Calls body(i) for every i in [0, count) across the threads, in no particular order, and returns
+    // once all calls are done
+    void ParallelFor(int count, const std::function<void(int)>& body);
+
+    [[nodiscard]] unsigned ThreadCount() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+private:
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    uint64_t loop_count_ = 0; // Bumped for every loop, the workers wait for a new one
+    unsigned busy_workers_ = 0;
+    bool stopping_ = false;
+
+    // The loop in progress, set before loop_count_ is bumped
+    const std::function<void(int)>* body_ = nullptr;
+    int count_ = 0;
+    std::atomic<int> next_{0};
+
+    void Work();
+    void RunIterations();
+};
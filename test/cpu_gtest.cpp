@@ -1035,3 +1035,62 @@ TEST_F(CPUTest, DECZeroPage) {
     EXPECT_EQ(cpu->Read(0x10), 0x00);
     EXPECT_TRUE(cpu->GetFlag(CPU::Z));
 }
+
+// Page crossing timing
+TEST_F(CPUTest, LDAAbsoluteXPageCross) {
+    cpu->set_x(0x20);
+    cpu->Write(cpu->PC(), 0xBD); // LDA absolute,X
+    cpu->Write(cpu->PC() + 1, 0xF0);
+    cpu->Write(cpu->PC() + 2, 0x01); // $01F0 + $20 crosses into page $02
+
+    const uint64_t start_cycles = cpu->TotalCycles();
+    cpu->StepInstruction();
+    EXPECT_EQ(cpu->TotalCycles() - start_cycles, 5u); // Reads take an extra cycle
+}
+
+TEST_F(CPUTest, STAAbsoluteXPageCross) {
+    cpu->set_x(0x20);
+    cpu->Write(cpu->PC(), 0x9D); // STA absolute,X
+    cpu->Write(cpu->PC() + 1, 0xF0);
+    cpu->Write(cpu->PC() + 2, 0x01);
+
+    const uint64_t start_cycles = cpu->TotalCycles();
+    cpu->StepInstruction();
+    EXPECT_EQ(cpu->TotalCycles() - start_cycles, 5u); // Stores always take 5 cycles
+}
+
+TEST_F(CPUTest, ASLAbsoluteXPageCross) {
+    cpu->set_x(0x20);
+    cpu->Write(cpu->PC(), 0x1E); // ASL absolute,X
+    cpu->Write(cpu->PC() + 1, 0xF0);
+    cpu->Write(cpu->PC() + 2, 0x01);
+
+    const uint64_t start_cycles = cpu->TotalCycles();
+    cpu->StepInstruction();
+    EXPECT_EQ(cpu->TotalCycles() - start_cycles, 7u); // Read-modify-write always takes 7 cycles
+}
+
+TEST_F(CPUTest, StatusRegisterRoundTrip) {
+    // Every combination must survive the split into lazily evaluated flags
+    for (int p = 0; p < 0x100; p++) {
+        cpu->set_P(p);
+        EXPECT_EQ(cpu->P(), p);
+    }
+}
+
+TEST_F(CPUTest, BITSetsZeroAndNegativeIndependently) {
+    cpu->set_a(0x01);
+    cpu->set_P(0x24);
+    cpu->Write(0x0010, 0xC0);
+    cpu->Write(cpu->PC(), 0x24); // BIT zero page
+    cpu->Write(cpu->PC() + 1, 0x10);
+
+    cpu->StepInstruction();
+    EXPECT_TRUE(cpu->GetFlag(CPU::Z));
+    EXPECT_TRUE(cpu->GetFlag(CPU::N));
+    EXPECT_TRUE(cpu->GetFlag(CPU::V));
+
+    cpu->Write(cpu->PC(), 0x08); // PHP
+    cpu->StepInstruction();
+    EXPECT_EQ(cpu->Read(0x100 + cpu->SP() + 1), 0xF6); // N, V, R, B, I and Z pushed
+}
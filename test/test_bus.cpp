@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "bus.h"
+#include "cpu.h"
+#include "ppu.h"
+#include "test_rom.h"
+
+namespace {
+    // Builds a 128KB MMC1 ROM whose every byte of PRG ROM holds its 16KB bank number plus its
+    // offset in the bank, so any bank switch changes what each page reads
+    TestRom WriteMmc1Rom() {
+        std::vector<uint8_t> prg(8 * 0x4000);
+        for (uint32_t i = 0; i < prg.size(); i++) prg[i] = static_cast<uint8_t>((i >> 14) * 0x20 + (i >> 10) + i);
+        return {1, prg};
+    }
+
+    // Serial write of the five low bits of value to the MMC1 register at address
+    void WriteMmc1(Bus& bus, const uint16_t address, uint8_t value) {
+        for (int bit = 0; bit < 5; bit++, value >>= 1) bus.Write(address, value & 1);
+    }
+}
+
+// Reads through the page table must see what the RAM and the mapper hold, whatever the banks
+TEST(BusTest, PageTableFollowsBankSwitches) {
+    const TestRom rom = WriteMmc1Rom();
+    CPU cpu;
+    PPU ppu;
+    Bus bus(&cpu, &ppu);
+    ASSERT_TRUE(bus.LoadCartridge(rom.Path()));
+
+    for (uint16_t address = 0; address < 0x2000; address++) bus.Write(address, static_cast<uint8_t>(address >> 3));
+    for (uint32_t address = 0; address < 0x2000; address++) {
+        ASSERT_EQ(bus.Read(address), static_cast<uint8_t>((address & 0x7FF) >> 3)) << std::hex << address;
+    }
+
+    for (const uint8_t control : {0x0C, 0x08, 0x00}) { // Last bank fixed, first bank fixed, 32KB
+        WriteMmc1(bus, 0x8000, control);
+        for (uint8_t bank = 0; bank < 8; bank++) {
+            WriteMmc1(bus, 0xE000, bank);
+            bus.Write(0x6000 + bank * 0x401, bank);
+            for (uint32_t address = 0x6000; address <= 0xFFFF; address++) {
+                ASSERT_EQ(bus.Read(address), bus.cartridge_->CpuRead(address))
+                    << std::hex << address << " control " << +control << " bank " << +bank;
+            }
+        }
+    }
+    EXPECT_EQ(bus.cartridge_->CpuRead(0x6000 + 7 * 0x401), 7); // PRG RAM writes reach the cartridge
+}
+
+// A ROM that fails to load leaves no page pointing into the cartridge it replaced
+TEST(BusTest, FailedLoadUnmapsTheCartridge) {
+    const TestRom rom = WriteMmc1Rom();
+    CPU cpu;
+    PPU ppu;
+    Bus bus(&cpu, &ppu);
+    ASSERT_TRUE(bus.LoadCartridge(rom.Path()));
+    ASSERT_NE(bus.Read(0xC001), 0);
+
+    EXPECT_FALSE(bus.LoadCartridge(rom.Path() + ".missing"));
+    EXPECT_EQ(bus.Read(0xC001), 0);
+    EXPECT_EQ(bus.Read(0x6000), 0);
+}
+
+// An MMC3 holding the IRQ line asserted releases it with its cartridge, whatever replaces it
+TEST(BusTest, ReplacedCartridgeReleasesTheIrqLine) {
+    const TestRom rom(4, std::vector<uint8_t>(0x8000, 0xEA), std::vector<uint8_t>(0x2000));
+    for (const bool load_fails : {true, false}) {
+        CPU cpu;
+        PPU ppu;
+        Bus bus(&cpu, &ppu);
+        ASSERT_TRUE(bus.LoadCartridge(rom.Path()));
+
+        bus.Write(0x2000, 0x08); // Sprites at $1000, A12 rises every line
+        bus.Write(0x2001, 0x1E);
+        bus.Write(0xC000, 0); // IRQ on every rise
+        bus.Write(0xC001, 0);
+        bus.Write(0xE001, 0);
+        for (int dot = 0; dot < 2 * 341 && !cpu.IrqLine(); dot++) bus.Step();
+        ASSERT_TRUE(cpu.IrqLine());
+
+        if (load_fails) {
+            EXPECT_FALSE(bus.LoadCartridge(rom.Path() + ".missing"));
+        }
+        else {
+            ASSERT_TRUE(bus.InitEmptyCartridge());
+        }
+        EXPECT_FALSE(cpu.IrqLine()) << "load fails " << load_fails;
+        for (int dot = 0; dot < 2 * 341; dot++) bus.Step();
+        EXPECT_FALSE(cpu.IrqLine()) << "load fails " << load_fails;
+    }
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "cartridge/cartridge.h"
+#include "cartridge/chr_tile_cache.h"
+#include "test_rom.h"
+
+namespace {
+    // Writes a 16KB PRG ROM with the given mapper and CHR ROM, no CHR ROM gives 8KB of CHR RAM
+    TestRom WriteRom(const uint8_t mapper, const std::vector<uint8_t>& chr) {
+        return {mapper, std::vector<uint8_t>(0x4000, 0xEA), chr};
+    }
+}
+
+TEST(ChrTileCacheTest, DecodesRowsAndMirroredRows) {
+    std::vector<uint8_t> chr(32, 0x00);
+    chr[16 + 3] = 0b11000001; // Tile 1, row 3, low plane
+    chr[16 + 8 + 3] = 0b10000011; // High plane
+
+    ChrTileCache cache;
+    cache.Attach(&chr);
+
+    const auto& row = cache.GetRow(16 + 3, false);
+    EXPECT_EQ(row.lsb_, 0b11000001);
+    EXPECT_EQ(row.msb_, 0b10000011);
+    EXPECT_EQ(row.pixels_, (std::array<uint8_t, 8>{3, 1, 0, 0, 0, 0, 2, 3}));
+    EXPECT_EQ(&cache.GetRow(16 + 8 + 3, false), &row); // Either plane selects the row
+
+    const auto& flipped = cache.GetRow(16 + 3, true);
+    EXPECT_EQ(flipped.lsb_, 0b10000011);
+    EXPECT_EQ(flipped.msb_, 0b11000001);
+    EXPECT_EQ(flipped.pixels_, (std::array<uint8_t, 8>{3, 2, 0, 0, 0, 0, 1, 3}));
+
+    EXPECT_EQ(&cache.GetRow(0xFFFFFFFF, false), &ChrTileCache::kBlankRow);
+}
+
+TEST(ChrTileCacheTest, ChrRamWritesInvalidateTheTile) {
+    const TestRom rom = WriteRom(1, {});
+    const Cartridge cartridge(rom.Path());
+    ASSERT_TRUE(cartridge.isLoaded());
+
+    EXPECT_EQ(cartridge.ChrRow(0x1012).lsb_, 0x00);
+    cartridge.PpuWrite(0x1012, 0x80);
+    cartridge.PpuWrite(0x101A, 0x80);
+    EXPECT_EQ(cartridge.ChrRow(0x1012).pixels_[0], 3);
+    EXPECT_EQ(cartridge.ChrRow(0x1012, true).pixels_[7], 3);
+    EXPECT_EQ(cartridge.ChrRow(0x1013).lsb_, 0x00);
+}
+
+TEST(ChrTileCacheTest, BankSwitchesNeedNoInvalidation) {
+    std::vector<uint8_t> chr(4 * 0x2000, 0x00);
+    for (int bank = 0; bank < 4; bank++) chr[bank * 0x2000] = static_cast<uint8_t>(bank + 1);
+    const TestRom rom = WriteRom(3, chr);
+    const Cartridge cartridge(rom.Path());
+    ASSERT_TRUE(cartridge.isLoaded());
+
+    for (const uint8_t bank : {2, 0, 3, 2}) {
+        cartridge.CpuWrite(0x8000, bank);
+        EXPECT_EQ(cartridge.ChrRow(0x0000).lsb_, bank + 1);
+    }
+}
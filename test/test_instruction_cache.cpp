@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "bus.h"
+#include "cpu.h"
+#include "ppu.h"
+#include "test_rom.h"
+
+namespace {
+    constexpr uint16_t kHaltAddress = 0xC034;
+
+    // Builds a 64KB MMC1 ROM. Each of the three switchable banks holds a routine of a different
+    // length at $8000, so a stale cache entry would produce a wrong count at $00.
+    TestRom WriteBankSwitchRom() {
+        std::vector<uint8_t> prg(4 * 0x4000, 0xEA);
+
+        for (uint8_t bank = 0; bank < 3; bank++) {
+            // INC $00 repeated bank + 1 times, then RTS
+            const uint32_t start = bank * 0x4000;
+            for (uint8_t i = 0; i <= bank; i++) {
+                prg[start + i * 2] = 0xE6;
+                prg[start + i * 2 + 1] = 0x00;
+            }
+            prg[start + (bank + 1) * 2] = 0x60;
+        }
+
+        // Fixed bank at $C000
+        const uint32_t fixed = 3 * 0x4000;
+        std::vector<uint8_t> main = {0xA9, 0x00, 0x85, 0x00}; // LDA #0, STA $00
+        for (const uint8_t bank : {0, 1, 2, 0, 1, 2}) {
+            main.insert(main.end(), {0xA9, bank, 0x20, 0x00, 0xC1, 0x20, 0x00, 0x80}); // Select bank, JSR $8000
+        }
+        main.insert(main.end(), {0x4C, kHaltAddress & 0xFF, kHaltAddress >> 8}); // JMP to itself
+        std::copy(main.begin(), main.end(), prg.begin() + fixed);
+
+        // Serial write of A to the MMC1 PRG bank register
+        const std::vector<uint8_t> select_bank = {
+            0x8D, 0x00, 0xE0, 0x4A, 0x8D, 0x00, 0xE0, 0x4A, 0x8D, 0x00, 0xE0, 0x4A,
+            0x8D, 0x00, 0xE0, 0x4A, 0x8D, 0x00, 0xE0, 0x60
+        };
+        std::copy(select_bank.begin(), select_bank.end(), prg.begin() + fixed + 0x100);
+
+        prg[fixed + 0x3FFC] = 0x00; // Reset vector $C000
+        prg[fixed + 0x3FFD] = 0xC0;
+        return {1, prg};
+    }
+}
+
+// The cached core must follow the switch core instruction by instruction across bank switches
+TEST(InstructionCacheTest, MatchesSwitchCoreAcrossBankSwitches) {
+    const TestRom rom = WriteBankSwitchRom();
+
+    CPU reference_cpu, cached_cpu;
+    PPU reference_ppu, cached_ppu;
+    Bus reference_bus(&reference_cpu, &reference_ppu);
+    Bus cached_bus(&cached_cpu, &cached_ppu);
+    ASSERT_TRUE(reference_bus.LoadCartridge(rom.Path()));
+    ASSERT_TRUE(cached_bus.LoadCartridge(rom.Path()));
+    reference_cpu.set_core(CPU::Core::kSwitch);
+    cached_cpu.set_core(CPU::Core::kCached);
+
+    for (int i = 0; i < 1000 && reference_cpu.PC() != kHaltAddress; i++) {
+        reference_cpu.StepInstruction();
+        cached_cpu.StepInstruction();
+
+        ASSERT_EQ(cached_cpu.PC(), reference_cpu.PC()) << "instruction " << i;
+        ASSERT_EQ(cached_cpu.A(), reference_cpu.A()) << "instruction " << i;
+        ASSERT_EQ(cached_cpu.P(), reference_cpu.P()) << "instruction " << i;
+        ASSERT_EQ(cached_cpu.SP(), reference_cpu.SP()) << "instruction " << i;
+        ASSERT_EQ(cached_cpu.TotalCycles(), reference_cpu.TotalCycles()) << "instruction " << i;
+    }
+
+    EXPECT_EQ(reference_cpu.PC(), kHaltAddress);
+    EXPECT_EQ(cached_cpu.Read(0x00), 12); // 2 * (1 + 2 + 3)
+}
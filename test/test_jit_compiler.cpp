@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "bus.h"
+#include "cpu.h"
+#include "ppu.h"
+#include "test_rom.h"
+
+namespace {
+    constexpr uint16_t kHaltAddress = 0xC052;
+
+    // Builds a 64KB MMC1 ROM calling a routine at $8000 twenty times in each of the three
+    // switchable banks. The routines differ per bank, so a block compiled for the wrong bank
+    // produces a wrong count at $00.
+    TestRom WriteBankSwitchLoopRom() {
+        std::vector<uint8_t> prg(4 * 0x4000, 0xEA);
+
+        for (uint8_t bank = 0; bank < 3; bank++) {
+            // INC $00 repeated bank + 1 times, then RTS
+            const uint32_t start = bank * 0x4000;
+            for (uint8_t i = 0; i <= bank; i++) {
+                prg[start + i * 2] = 0xE6;
+                prg[start + i * 2 + 1] = 0x00;
+            }
+            prg[start + (bank + 1) * 2] = 0x60;
+        }
+
+        // Fixed bank at $C000
+        const uint32_t fixed = 3 * 0x4000;
+        std::vector<uint8_t> main = {0xA9, 0x00, 0x85, 0x00}; // LDA #0, STA $00
+        for (const uint8_t bank : {0, 1, 2, 0, 1, 2}) {
+            main.insert(main.end(), {
+                            0xA9, bank, 0x20, 0x00, 0xC1, // Select bank
+                            0xA0, 0x14, // LDY #20
+                            0x20, 0x00, 0x80, 0x88, 0xD0, 0xFA // JSR $8000, DEY, BNE to JSR
+                        });
+        }
+        main.insert(main.end(), {0x4C, kHaltAddress & 0xFF, kHaltAddress >> 8}); // JMP to itself
+        std::copy(main.begin(), main.end(), prg.begin() + fixed);
+
+        // Serial write of A to the MMC1 PRG bank register
+        const std::vector<uint8_t> select_bank = {
+            0x8D, 0x00, 0xE0, 0x4A, 0x8D, 0x00, 0xE0, 0x4A, 0x8D, 0x00, 0xE0, 0x4A,
+            0x8D, 0x00, 0xE0, 0x4A, 0x8D, 0x00, 0xE0, 0x60
+        };
+        std::copy(select_bank.begin(), select_bank.end(), prg.begin() + fixed + 0x100);
+
+        prg[fixed + 0x3FFC] = 0x00; // Reset vector $C000
+        prg[fixed + 0x3FFD] = 0xC0;
+        return {1, prg};
+    }
+
+    // Builds an NROM ROM that unmasks IRQs with CLI in a loop of INX, its IRQ handler stopping at
+    // kHaltAddress with IRQs masked
+    TestRom WriteCliLoopRom() {
+        std::vector<uint8_t> prg(0x4000, 0xEA);
+
+        const std::vector<uint8_t> main = {0x58, 0xE8, 0xE8, 0xE8, 0x4C, 0x00, 0xC0}; // CLI, INX x3, JMP $C000
+        std::copy(main.begin(), main.end(), prg.begin());
+        prg[kHaltAddress - 0xC000] = 0x4C; // JMP to itself
+        prg[kHaltAddress - 0xC000 + 1] = kHaltAddress & 0xFF;
+        prg[kHaltAddress - 0xC000 + 2] = kHaltAddress >> 8;
+
+        prg[0x3FFC] = 0x00; // Reset vector $C000
+        prg[0x3FFD] = 0xC0;
+        prg[0x3FFE] = kHaltAddress & 0xFF; // IRQ vector
+        prg[0x3FFF] = kHaltAddress >> 8;
+        return {0, prg};
+    }
+
+    // Runs the JIT core one block at a time and the switch core until it reaches the same cycle,
+    // then checks that both CPUs agree on every register and on RAM
+    void RunLockstep(CPU& reference_cpu, const Bus& reference_bus, CPU& jit_cpu, const Bus& jit_bus,
+                     const std::function<bool()>& done, const int max_blocks) {
+        for (int block = 0; block < max_blocks && !done(); block++) {
+            jit_cpu.StepInstruction();
+            while (reference_cpu.TotalCycles() < jit_cpu.TotalCycles()) {
+                reference_cpu.StepInstruction();
+            }
+
+            ASSERT_EQ(reference_cpu.TotalCycles(), jit_cpu.TotalCycles()) << "block " << block;
+            ASSERT_EQ(reference_cpu.PC(), jit_cpu.PC()) << "block " << block;
+            ASSERT_EQ(reference_cpu.A(), jit_cpu.A()) << "block " << block;
+            ASSERT_EQ(reference_cpu.X(), jit_cpu.X()) << "block " << block;
+            ASSERT_EQ(reference_cpu.Y(), jit_cpu.Y()) << "block " << block;
+            ASSERT_EQ(reference_cpu.P(), jit_cpu.P()) << "block " << block;
+            ASSERT_EQ(reference_cpu.SP(), jit_cpu.SP()) << "block " << block;
+            ASSERT_EQ(reference_bus.ram_, jit_bus.ram_) << "block " << block;
+        }
+        EXPECT_TRUE(done());
+    }
+}
+
+TEST(JitCompilerTest, MatchesSwitchCoreOnNestest) {
+    if (!JitCompiler::IsSupported()) GTEST_SKIP() << "JIT not supported on this platform";
+
+    const std::string rom_path = "roms/nes-testroms/other/nestest.nes";
+
+    CPU reference_cpu, jit_cpu;
+    PPU reference_ppu, jit_ppu;
+    Bus reference_bus(&reference_cpu, &reference_ppu);
+    Bus jit_bus(&jit_cpu, &jit_ppu);
+    ASSERT_TRUE(reference_bus.LoadCartridge(rom_path));
+    ASSERT_TRUE(jit_bus.LoadCartridge(rom_path));
+    reference_cpu.set_core(CPU::Core::kSwitch);
+    jit_cpu.set_core(CPU::Core::kJit);
+    jit_cpu.Jit().set_hot_threshold(1); // nestest runs most of its code once, compile all of it
+    reference_cpu.set_PC(0xC000); // Automatic test PC
+    jit_cpu.set_PC(0xC000);
+
+    RunLockstep(reference_cpu, reference_bus, jit_cpu, jit_bus, [&] { return jit_cpu.SP() == 0xFF; }, 20000);
+
+    EXPECT_GT(jit_cpu.Jit().CompiledBlockCount(), 0u);
+    EXPECT_EQ(jit_cpu.Read(0x02), reference_cpu.Read(0x02));
+    EXPECT_EQ(jit_cpu.Read(0x03), reference_cpu.Read(0x03));
+}
+
+// Blocks compiled for one bank must not run once another bank is mapped at the same address
+TEST(JitCompilerTest, MatchesSwitchCoreAcrossBankSwitches) {
+    if (!JitCompiler::IsSupported()) GTEST_SKIP() << "JIT not supported on this platform";
+
+    const TestRom rom = WriteBankSwitchLoopRom();
+
+    CPU reference_cpu, jit_cpu;
+    PPU reference_ppu, jit_ppu;
+    Bus reference_bus(&reference_cpu, &reference_ppu);
+    Bus jit_bus(&jit_cpu, &jit_ppu);
+    ASSERT_TRUE(reference_bus.LoadCartridge(rom.Path()));
+    ASSERT_TRUE(jit_bus.LoadCartridge(rom.Path()));
+    reference_cpu.set_core(CPU::Core::kSwitch);
+    jit_cpu.set_core(CPU::Core::kJit);
+
+    RunLockstep(reference_cpu, reference_bus, jit_cpu, jit_bus, [&] { return jit_cpu.PC() == kHaltAddress; }, 5000);
+
+    EXPECT_GT(jit_cpu.Jit().CompiledBlockCount(), 0u);
+    EXPECT_EQ(jit_cpu.Read(0x00), 240); // 2 * 20 * (1 + 2 + 3)
+}
+
+// An IRQ pending while masked is taken right after the CLI unmasking it, not at the end of the block
+TEST(JitCompilerTest, MatchesSwitchCoreOnPendingIrq) {
+    if (!JitCompiler::IsSupported()) GTEST_SKIP() << "JIT not supported on this platform";
+
+    const TestRom rom = WriteCliLoopRom();
+
+    CPU reference_cpu, jit_cpu;
+    PPU reference_ppu, jit_ppu;
+    Bus reference_bus(&reference_cpu, &reference_ppu);
+    Bus jit_bus(&jit_cpu, &jit_ppu);
+    ASSERT_TRUE(reference_bus.LoadCartridge(rom.Path()));
+    ASSERT_TRUE(jit_bus.LoadCartridge(rom.Path()));
+    reference_cpu.set_core(CPU::Core::kSwitch);
+    jit_cpu.set_core(CPU::Core::kJit);
+    jit_cpu.Jit().set_hot_threshold(1);
+    reference_cpu.SetIrqLine(true);
+    jit_cpu.SetIrqLine(true);
+
+    RunLockstep(reference_cpu, reference_bus, jit_cpu, jit_bus, [&] { return jit_cpu.PC() == kHaltAddress; }, 100);
+
+    EXPECT_GT(jit_cpu.Jit().CompiledBlockCount(), 0u);
+    EXPECT_EQ(jit_cpu.X(), 0);
+}
+
+#if defined(__linux__)
+// Compiled blocks are executable but no longer writable
+TEST(JitCompilerTest, CodeBufferIsNeverWritableAndExecutable) {
+    if (!JitCompiler::IsSupported()) GTEST_SKIP() << "JIT not supported on this platform";
+
+    const TestRom rom = WriteBankSwitchLoopRom();
+
+    CPU cpu;
+    PPU ppu;
+    Bus bus(&cpu, &ppu);
+    ASSERT_TRUE(bus.LoadCartridge(rom.Path()));
+    cpu.set_core(CPU::Core::kJit);
+    cpu.Jit().set_hot_threshold(1);
+    for (int block = 0; block < 5000 && cpu.PC() != kHaltAddress; block++) {
+        cpu.StepInstruction();
+    }
+    ASSERT_GT(cpu.Jit().CompiledBlockCount(), 0u);
+
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+        EXPECT_EQ(line.find("rwx"), std::string::npos) << line;
+    }
+}
+#endif
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "cartridge/cartridge.h"
+#include "test_rom.h"
+
+namespace {
+    // Writes a ROM with the given mapper whose PRG ROM and CHR ROM bytes hold the number of the 1KB
+    // page they are in, no CHR ROM gives 8KB of CHR RAM
+    TestRom WriteRom(const uint8_t mapper, const uint8_t prg_chunks, const uint8_t chr_chunks) {
+        std::vector<uint8_t> prg(prg_chunks * 0x4000u), chr(chr_chunks * 0x2000u);
+        for (uint32_t i = 0; i < prg.size(); i++) prg[i] = static_cast<uint8_t>(i >> 10);
+        for (uint32_t i = 0; i < chr.size(); i++) chr[i] = static_cast<uint8_t>(i >> 10);
+        return {mapper, prg, chr};
+    }
+
+    void WriteMmc1(const Cartridge& cartridge, const uint16_t address, uint8_t value) {
+        for (int bit = 0; bit < 5; bit++, value >>= 1) cartridge.CpuWrite(address, value & 1);
+    }
+}
+
+// The MMC1 windows must map every PRG and CHR mode like the bank registers describe
+TEST(MapperTest, Mmc1WindowsFollowTheModes) {
+    const TestRom rom = WriteRom(1, 8, 16); // 128KB of each
+    const Cartridge cartridge(rom.Path());
+    ASSERT_TRUE(cartridge.isLoaded());
+
+    for (uint8_t control = 0; control < 0x20; control += 0x04) {
+        WriteMmc1(cartridge, 0x8000, control);
+        const uint8_t prg_mode = (control >> 2) & 0x03;
+        for (uint8_t bank = 0; bank < 8; bank++) {
+            WriteMmc1(cartridge, 0xE000, bank);
+            WriteMmc1(cartridge, 0xA000, bank * 3);
+            WriteMmc1(cartridge, 0xC000, bank * 3 + 1);
+
+            uint32_t low = bank, high = 7; // 16KB banks at $8000 and $C000
+            if (prg_mode <= 1) {
+                low = bank & ~1u;
+                high = bank | 1u;
+            }
+            else if (prg_mode == 2) {
+                low = 0;
+                high = bank;
+            }
+            for (uint32_t address = 0x8000; address <= 0xFFFF; address += 0x400) {
+                const uint32_t expected = (address < 0xC000 ? low : high) * 16 + (address & 0x3FFF) / 0x400;
+                ASSERT_EQ(cartridge.CpuRead(address), expected) << std::hex << address << " control " << +control;
+            }
+
+            const bool chr_4k = (control & 0x10) != 0;
+            const uint32_t chr_low = chr_4k ? bank * 3 : (bank * 3) & 0x1E;
+            const uint32_t chr_high = chr_4k ? bank * 3 + 1 : chr_low + 1;
+            for (uint16_t address = 0; address < 0x2000; address += 0x400) {
+                const uint32_t expected = (address < 0x1000 ? chr_low : chr_high) % 32 * 4 + (address & 0xFFF) / 0x400;
+                ASSERT_EQ(cartridge.PpuRead(address), expected) << std::hex << address << " control " << +control;
+            }
+        }
+    }
+}
+
+// The MMC3 windows must follow the eight bank registers in both PRG modes and CHR inversions
+TEST(MapperTest, Mmc3WindowsFollowTheBankRegisters) {
+    const TestRom rom = WriteRom(4, 8, 16); // 16 PRG banks of 8KB, 128 CHR banks of 1KB
+    const Cartridge cartridge(rom.Path());
+    ASSERT_TRUE(cartridge.isLoaded());
+
+    const uint8_t banks[8] = {0x13, 0x26, 0x31, 0x42, 0x53, 0x64, 0x05, 0x0A};
+    for (uint8_t mode = 0; mode < 4; mode++) {
+        const auto select = static_cast<uint8_t>((mode & 1 ? 0x40 : 0x00) | (mode & 2 ? 0x80 : 0x00));
+        for (uint8_t r = 0; r < 8; r++) {
+            cartridge.CpuWrite(0x8000, select | r);
+            cartridge.CpuWrite(0x8001, banks[r]);
+        }
+
+        const uint32_t prg[4] = {mode & 1 ? 14u : banks[6], banks[7], mode & 1 ? banks[6] : 14u, 15};
+        for (uint32_t address = 0x8000; address <= 0xFFFF; address += 0x400) {
+            const uint32_t expected = prg[(address - 0x8000) / 0x2000] * 8 + (address & 0x1FFF) / 0x400;
+            ASSERT_EQ(cartridge.CpuRead(address), expected) << std::hex << address << " mode " << +mode;
+        }
+
+        const uint32_t chr[8] = {banks[0] & 0xFEu, banks[0] | 1u, banks[1] & 0xFEu, banks[1] | 1u,
+                                 banks[2], banks[3], banks[4], banks[5]};
+        for (uint16_t address = 0; address < 0x2000; address += 0x400) {
+            const uint32_t slot = (address ^ (mode & 2 ? 0x1000 : 0)) / 0x400;
+            ASSERT_EQ(cartridge.PpuRead(address), chr[slot]) << std::hex << address << " mode " << +mode;
+        }
+    }
+
+    cartridge.PpuWrite(0x1234, 0x5A); // CHR ROM, R0 there with the inversion of the last mode
+    EXPECT_EQ(cartridge.PpuRead(0x1234), banks[0] & 0xFE);
+
+    cartridge.CpuWrite(0xA000, 0x01);
+    EXPECT_EQ(cartridge.mirroring_, Cartridge::MirroringType::kHorizontal);
+    cartridge.CpuWrite(0xA000, 0x00);
+    EXPECT_EQ(cartridge.mirroring_, Cartridge::MirroringType::kVertical);
+}
+
+// The MMC3 counter reloads from the latch when it reaches zero or after $C001, and raises the IRQ
+// on reaching zero while enabled, until $E000 acknowledges it
+TEST(MapperTest, Mmc3CounterRaisesIrqs) {
+    const TestRom rom = WriteRom(4, 2, 1);
+    const Cartridge cartridge(rom.Path());
+    ASSERT_TRUE(cartridge.isLoaded());
+
+    cartridge.CpuWrite(0xC000, 3); // Latch
+    cartridge.CpuWrite(0xC001, 0); // Reload on the next rise
+    cartridge.CpuWrite(0xE001, 0); // Enable
+    for (int line = 0; line < 12; line++) {
+        cartridge.OnA12Rise();
+        EXPECT_EQ(cartridge.Irq(), line >= 3) << "line " << line;
+    }
+
+    cartridge.CpuWrite(0xE000, 0); // Acknowledge and disable
+    EXPECT_FALSE(cartridge.Irq());
+    for (int line = 0; line < 8; line++) cartridge.OnA12Rise();
+    EXPECT_FALSE(cartridge.Irq());
+
+    cartridge.CpuWrite(0xE001, 0); // The counter is at zero, so it reloads first
+    for (int line = 0; line < 3; line++) cartridge.OnA12Rise();
+    EXPECT_FALSE(cartridge.Irq());
+    cartridge.OnA12Rise();
+    EXPECT_TRUE(cartridge.Irq());
+}
+
+// CHR RAM is written through the windows, CHR ROM is not
+TEST(MapperTest, OnlyChrRamIsWritable) {
+    for (const uint8_t mapper : {0, 1, 3}) {
+        const TestRom ram_file = WriteRom(mapper, 2, 0);
+        const Cartridge ram_cartridge(ram_file.Path());
+        ram_cartridge.PpuWrite(0x1234, 0x5A);
+        EXPECT_EQ(ram_cartridge.PpuRead(0x1234), 0x5A) << "mapper " << +mapper;
+
+        const TestRom rom_file = WriteRom(mapper, 2, 1);
+        const Cartridge rom_cartridge(rom_file.Path());
+        rom_cartridge.PpuWrite(0x1234, 0x5A);
+        EXPECT_EQ(rom_cartridge.PpuRead(0x1234), 0x04) << "mapper " << +mapper;
+    }
+}
+
+// The virtual reads the mapper benchmark compares against see the same banks as the windows
+TEST(MapperTest, VirtualReadsMatchTheWindows) {
+    for (const uint8_t mapper : {0, 1, 3, 4}) {
+        const TestRom rom = WriteRom(mapper, mapper == 0 || mapper == 3 ? 2 : 8, mapper == 0 ? 1 : 16);
+        Cartridge cartridge(rom.Path());
+        ASSERT_TRUE(cartridge.isLoaded());
+        if (mapper == 1) WriteMmc1(cartridge, 0xE000, 5);
+        else if (mapper == 3) cartridge.CpuWrite(0x8000, 2);
+        else if (mapper == 4) {
+            cartridge.CpuWrite(0x8000, 6); // PRG bank at $8000
+            cartridge.CpuWrite(0x8001, 9);
+        }
+
+        std::vector<uint8_t> cpu_reads, ppu_reads, chr_rows;
+        for (uint32_t address = 0x8000; address <= 0xFFFF; address += 0x100) {
+            cpu_reads.push_back(cartridge.CpuRead(address));
+        }
+        for (uint16_t address = 0; address < 0x2000; address += 0x40) {
+            ppu_reads.push_back(cartridge.PpuRead(address));
+            chr_rows.push_back(cartridge.ChrRow(address).msb_);
+        }
+
+        cartridge.set_virtual_reads(true);
+        EXPECT_EQ(cartridge.CpuReadPage(0x8000), nullptr) << "mapper " << +mapper;
+        size_t i = 0;
+        for (uint32_t address = 0x8000; address <= 0xFFFF; address += 0x100, i++) {
+            ASSERT_EQ(cartridge.CpuRead(address), cpu_reads[i]) << std::hex << address << " mapper " << +mapper;
+        }
+        i = 0;
+        for (uint16_t address = 0; address < 0x2000; address += 0x40, i++) {
+            ASSERT_EQ(cartridge.PpuRead(address), ppu_reads[i]) << std::hex << address << " mapper " << +mapper;
+            ASSERT_EQ(cartridge.ChrRow(address).msb_, chr_rows[i]) << std::hex << address << " mapper " << +mapper;
+        }
+    }
+}
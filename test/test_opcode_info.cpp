@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include "cpu.h"
+#include "cpu/opcode_info.h"
+
+// The metadata table must describe the same addressing mode as the dispatch table
+TEST(OpcodeInfoTest, MatchesOpcodeTable) {
+    using AddrMode = OpcodeInfo::AddrMode;
+    for (int opcode = 0; opcode < 256; opcode++) {
+        const auto& entry = CPU::GetOpcodeEntry(opcode);
+        const auto& info = OpcodeInfo::Get(opcode);
+
+        AddrMode expected = AddrMode::kImp;
+        if (entry.addr_mode_ == &CPU::ADR_IMM) expected = AddrMode::kImm;
+        else if (entry.addr_mode_ == &CPU::ADR_REL) expected = AddrMode::kRel;
+        else if (entry.addr_mode_ == &CPU::ADR_ZP0) expected = AddrMode::kZp0;
+        else if (entry.addr_mode_ == &CPU::ADR_ZPX) expected = AddrMode::kZpx;
+        else if (entry.addr_mode_ == &CPU::ADR_ZPY) expected = AddrMode::kZpy;
+        else if (entry.addr_mode_ == &CPU::ADR_ABS) expected = AddrMode::kAbs;
+        else if (entry.addr_mode_ == &CPU::ADR_ABX) expected = AddrMode::kAbx;
+        else if (entry.addr_mode_ == &CPU::ADR_ABY) expected = AddrMode::kAby;
+        else if (entry.addr_mode_ == &CPU::ADR_IND) expected = AddrMode::kInd;
+        else if (entry.addr_mode_ == &CPU::ADR_IZX) expected = AddrMode::kIzx;
+        else if (entry.addr_mode_ == &CPU::ADR_IZY) expected = AddrMode::kIzy;
+
+        EXPECT_EQ(info.addr_mode_, expected) << "opcode " << opcode;
+    }
+}
+
+TEST(OpcodeInfoTest, Lengths) {
+    EXPECT_EQ(OpcodeInfo::Get(0xEA).length_, 1); // NOP
+    EXPECT_EQ(OpcodeInfo::Get(0xA9).length_, 2); // LDA #imm
+    EXPECT_EQ(OpcodeInfo::Get(0xD0).length_, 2); // BNE
+    EXPECT_EQ(OpcodeInfo::Get(0x6C).length_, 3); // JMP (ind)
+    EXPECT_EQ(OpcodeInfo::Get(0xBD).length_, 3); // LDA abs,X
+}
+
+TEST(OpcodeInfoTest, PageCrossPenaltyOnlyForIndexedReads) {
+    for (int opcode = 0; opcode < 256; opcode++) {
+        const auto& info = OpcodeInfo::Get(opcode);
+        if (info.page_cross_penalty_) {
+            EXPECT_EQ(info.access_, OpcodeInfo::Access::kRead) << "opcode " << opcode;
+        }
+    }
+    EXPECT_TRUE(OpcodeInfo::Get(0xB1).page_cross_penalty_); // LDA (ind),Y
+    EXPECT_FALSE(OpcodeInfo::Get(0x91).page_cross_penalty_); // STA (ind),Y
+    EXPECT_FALSE(OpcodeInfo::Get(0xFE).page_cross_penalty_); // INC abs,X
+}
+
+TEST(OpcodeInfoTest, ControlFlowAndOfficial) {
+    EXPECT_EQ(OpcodeInfo::Get(0x20).flow_, OpcodeInfo::Flow::kCall); // JSR
+    EXPECT_EQ(OpcodeInfo::Get(0x4C).flow_, OpcodeInfo::Flow::kJump); // JMP abs
+    EXPECT_EQ(OpcodeInfo::Get(0x60).flow_, OpcodeInfo::Flow::kReturn); // RTS
+    EXPECT_EQ(OpcodeInfo::Get(0xF0).flow_, OpcodeInfo::Flow::kBranch); // BEQ
+
+    int official = 0;
+    for (int opcode = 0; opcode < 256; opcode++) {
+        official += OpcodeInfo::Get(opcode).official_;
+    }
+    EXPECT_EQ(official, 151);
+}
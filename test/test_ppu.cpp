@@ -0,0 +1,621 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "cartridge/cartridge.h"
+#include "ppu/dirty_row_tracker.h"
+#include "ppu.h"
+#include "test_rom.h"
+#include "thread_pool.h"
+
+namespace {
+    // Sets up a PPU rendering the nestest CHR ROM with every sprite on screen
+    void SetUpRendering(PPU& ppu, const std::shared_ptr<Cartridge>& cartridge) {
+        ppu.SetCartridge(cartridge);
+        for (int i = 0; i < 64; i++) {
+            ppu.oam_.sprites[i].y_ = static_cast<uint8_t>(i * 3);
+            ppu.oam_.sprites[i].tile_id_ = static_cast<uint8_t>(0x30 + i);
+            ppu.oam_.sprites[i].x_ = static_cast<uint8_t>(i * 4);
+        }
+        ppu.InvalidateOamIndex();
+        ppu.CpuWrite(0, 0x80); // NMI enabled
+        ppu.CpuWrite(1, 0x1E); // Background and sprites shown
+    }
+
+    // Writes an NROM ROM whose CHR ROM is random, so tiles have opaque pixels in every column
+    TestRom WriteRandomChrRom(uint32_t seed) {
+        std::vector<uint8_t> chr(0x2000);
+        for (uint8_t& byte : chr) {
+            seed = seed * 1103515245 + 12345;
+            byte = static_cast<uint8_t>(seed >> 16);
+        }
+        return {0, std::vector<uint8_t>(0x4000, 0xEA), chr};
+    }
+
+    bool SameFrame(const PPU& a, const PPU& b) {
+        return a.GetFrameBuffer() == b.GetFrameBuffer();
+    }
+
+    // Shift registers, sprite line and scroll position, which the picture only shows later
+    bool SameRenderState(const PPU& a, const PPU& b) {
+        if (a.vram_address_.value_ != b.vram_address_.value_ || a.bg_tile_id_ != b.bg_tile_id_
+            || a.bg_attribute_ != b.bg_attribute_ || a.bg_lsb_ != b.bg_lsb_ || a.bg_msb_ != b.bg_msb_
+            || a.bg_lsb_shift_reg != b.bg_lsb_shift_reg || a.bg_msb_shift_reg != b.bg_msb_shift_reg
+            || a.bg_att_lsb_shift_reg != b.bg_att_lsb_shift_reg || a.bg_att_msb_shift_reg != b.bg_att_msb_shift_reg
+            || a.spriteZeroRendered_ != b.spriteZeroRendered_) {
+            return false;
+        }
+        return a.sprite_line_delay_ == b.sprite_line_delay_
+            && std::equal(std::begin(a.sprite_line_), std::end(a.sprite_line_), std::begin(b.sprite_line_));
+    }
+}
+
+TEST(PpuTest, RunMatchesStep) {
+    const auto cartridge = std::make_shared<Cartridge>("roms/nes-testroms/other/nestest.nes");
+    ASSERT_TRUE(cartridge->isLoaded());
+
+    PPU step_ppu, run_ppu;
+    SetUpRendering(step_ppu, cartridge);
+    SetUpRendering(run_ppu, cartridge);
+
+    // Chunks of varying length, so they start and end everywhere in the frame
+    uint32_t seed = 12345;
+    for (int chunk = 0; chunk < 1000; chunk++) {
+        seed = seed * 1103515245 + 12345;
+        const uint32_t dots = 1 + (seed >> 16) % 1000;
+
+        for (uint32_t i = 0; i < dots; i++) step_ppu.Step();
+        run_ppu.Run(dots);
+
+        ASSERT_EQ(step_ppu.DotsUntilVblank(), run_ppu.DotsUntilVblank()) << "chunk " << chunk;
+        ASSERT_EQ(step_ppu.DotsUntilFrameComplete(), run_ppu.DotsUntilFrameComplete()) << "chunk " << chunk;
+        ASSERT_EQ(step_ppu.frame_complete_, run_ppu.frame_complete_) << "chunk " << chunk;
+        ASSERT_EQ(step_ppu.was_nmi_triggered_, run_ppu.was_nmi_triggered_) << "chunk " << chunk;
+        ASSERT_EQ(step_ppu.status_.value_, run_ppu.status_.value_) << "chunk " << chunk;
+        ASSERT_TRUE(SameFrame(step_ppu, run_ppu)) << "chunk " << chunk;
+    }
+}
+
+// Random nametables, palettes, sprites and scroll, drawn a frame at a time so every visible line
+// takes the scanline path in Run() and the dot path in Step()
+TEST(PpuTest, ScanlineRenderingMatchesStep) {
+    const TestRom rom = WriteRandomChrRom(99);
+    const auto cartridge = std::make_shared<Cartridge>(rom.Path());
+    ASSERT_TRUE(cartridge->isLoaded());
+
+    uint32_t seed = 777;
+    const auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return static_cast<uint8_t>(seed >> 16);
+    };
+
+    // Background only, sprites only, both, then both with the left 8 pixels of either or both hidden,
+    // the last one in 8x16
+    const uint8_t masks[] = {0x0A, 0x14, 0x1E, 0x1A, 0x1C, 0x18};
+    for (const uint8_t mask : masks) {
+        PPU step_ppu, run_ppu;
+        for (PPU* ppu : {&step_ppu, &run_ppu}) ppu->SetCartridge(cartridge);
+
+        for (int frame = 0; frame < 8; frame++) {
+            for (uint16_t address = 0x2000; address < 0x2800; address++) {
+                const uint8_t value = random();
+                step_ppu.PpuWrite(address, value);
+                run_ppu.PpuWrite(address, value);
+            }
+            for (uint16_t address = 0x3F00; address < 0x3F20; address++) {
+                const uint8_t value = random();
+                step_ppu.PpuWrite(address, value);
+                run_ppu.PpuWrite(address, value);
+            }
+            for (int i = 0; i < 256; i++) {
+                const uint8_t value = random();
+                step_ppu.oam_.bytes[i] = value;
+                run_ppu.oam_.bytes[i] = value;
+            }
+            // Sprite 0 on screen and across the left 8 pixels, where it cannot hit the background.
+            // The hit flag is cleared for each frame, as the pre-render line does not clear it.
+            for (PPU* ppu : {&step_ppu, &run_ppu}) {
+                ppu->status_.value_ = 0;
+                ppu->oam_.sprites[0].y_ %= 200;
+                ppu->oam_.sprites[0].x_ = static_cast<uint8_t>(frame);
+                ppu->InvalidateOamIndex();
+            }
+
+            const uint8_t scroll_x = random(), scroll_y = random() % 240;
+            const uint8_t ctrl = (random() & 0x1B) | (mask == 0x18 ? 0x20 : 0x00);
+            for (PPU* ppu : {&step_ppu, &run_ppu}) {
+                ppu->CpuWrite(0, ctrl);
+                ppu->CpuWrite(1, mask);
+                ppu->CpuWrite(5, scroll_x);
+                ppu->CpuWrite(5, scroll_y);
+            }
+
+            // Stop after the visible part of line 0 first, where the rendering state is not yet reloaded
+            constexpr uint32_t kFirstLineDots = 341 + 256;
+            for (uint32_t i = 0; i < kFirstLineDots; i++) step_ppu.Step();
+            run_ppu.Run(kFirstLineDots);
+            ASSERT_TRUE(SameRenderState(step_ppu, run_ppu)) << "mask " << int(mask) << " frame " << frame;
+
+            const uint32_t dots = step_ppu.DotsUntilFrameComplete();
+            for (uint32_t i = 0; i < dots; i++) step_ppu.Step();
+            run_ppu.Run(dots);
+
+            ASSERT_TRUE(run_ppu.frame_complete_) << "mask " << int(mask) << " frame " << frame;
+            ASSERT_EQ(step_ppu.status_.value_, run_ppu.status_.value_) << "mask " << int(mask) << " frame " << frame;
+            ASSERT_EQ(step_ppu.spriteZeroRendered_, run_ppu.spriteZeroRendered_);
+            ASSERT_EQ(step_ppu.vram_address_.value_, run_ppu.vram_address_.value_);
+            ASSERT_TRUE(SameFrame(step_ppu, run_ppu)) << "mask " << int(mask) << " frame " << frame;
+            step_ppu.frame_complete_ = false;
+            run_ppu.frame_complete_ = false;
+        }
+    }
+}
+
+// A12 rises are predicted no later than Step() makes them, once on each of the 241 rendering lines
+TEST(PpuTest, A12RisesMatchStep) {
+    const auto cartridge = std::make_shared<Cartridge>("roms/nes-testroms/other/nestest.nes");
+    ASSERT_TRUE(cartridge->isLoaded());
+
+    // Background at $1000, sprites at $1000, 8x16 sprites, both at $1000, then nothing shown
+    const std::pair<uint8_t, uint8_t> settings[] = {{0x10, 0x1E}, {0x08, 0x1E}, {0x20, 0x0A}, {0x18, 0x1E},
+                                                     {0x10, 0x00}};
+    const uint32_t expected_rises[] = {241, 241, 241, 0, 0};
+    for (size_t i = 0; i < std::size(settings); i++) {
+        PPU ppu;
+        SetUpRendering(ppu, cartridge);
+        ppu.CpuWrite(0, settings[i].first);
+        ppu.CpuWrite(1, settings[i].second);
+        ppu.Run(ppu.DotsUntilFrameComplete()); // A fresh PPU starts after the pre-render line
+        ppu.frame_complete_ = false;
+        const uint64_t start = ppu.dot_count_;
+
+        std::vector<uint64_t> predictions; // Dot count of the predicted rise, before each dot
+        std::vector<uint64_t> rises;
+        for (int frame = 0; frame < 3; frame++) {
+            do {
+                const uint32_t dots = ppu.DotsUntilA12Rise();
+                predictions.push_back(dots == 0 ? UINT64_MAX : ppu.dot_count_ + dots);
+                ppu.Step();
+                if (ppu.A12RoseOnLastDot()) rises.push_back(ppu.dot_count_);
+            } while (!ppu.frame_complete_);
+            ppu.frame_complete_ = false;
+        }
+        ASSERT_EQ(rises.size(), 3 * expected_rises[i]) << "setting " << i;
+
+        size_t next = 0;
+        for (uint64_t dot = 0; dot < predictions.size(); dot++) {
+            while (next < rises.size() && rises[next] <= start + dot) next++;
+            if (next == rises.size()) break;
+            ASSERT_LE(predictions[dot], rises[next]) << "setting " << i << " dot " << dot;
+            ASSERT_GE(predictions[dot] + 1, rises[next]) << "setting " << i << " dot " << dot;
+        }
+    }
+}
+
+TEST(PpuTest, FrameBufferHoldsColorAndEmphasis) {
+    const auto cartridge = std::make_shared<Cartridge>("roms/nes-testroms/other/nestest.nes");
+    ASSERT_TRUE(cartridge->isLoaded());
+
+    PPU ppu;
+    ppu.SetCartridge(cartridge);
+    ppu.PpuWrite(0x3F00, 0x16);
+    ppu.CpuWrite(1, 0x21); // Grayscale and red emphasis, nothing rendered
+    ppu.Run(ppu.DotsUntilFrameComplete());
+
+    const auto& framebuffer = ppu.GetFrameBuffer();
+    for (int y = 0; y < PPU::kHeight; y++) {
+        for (int x = 0; x < PPU::kWidth - 1; x++) {
+            ASSERT_EQ(framebuffer[y * PPU::kWidth + x], 0x10 | 0x040) << x << ", " << y;
+        }
+    }
+}
+
+TEST(PpuTest, RgbaTableAppliesEmphasis) {
+    const PPU::RgbaTable table = PPU::BuildRgbaTable();
+    EXPECT_EQ(table[0x30], 0xECEEECFFu); // White, as in the palette
+    EXPECT_EQ(table[0x0F], 0x000000FFu);
+    EXPECT_EQ(table[0x30 | 0x040], 0xECC2C0FFu); // Red emphasis dims green and blue
+    EXPECT_EQ(table[0x30 | 0x1C0], 0xC0C2C0FFu); // All three dim every channel
+
+    std::vector<uint16_t> framebuffer = {0x30, 0x0F, 0x70};
+    uint32_t rgba[3];
+    PPU::ConvertToRgba(framebuffer, table, rgba);
+    EXPECT_EQ(rgba[0], table[0x30]);
+    EXPECT_EQ(rgba[1], table[0x0F]);
+    EXPECT_EQ(rgba[2], table[0x70]);
+}
+
+TEST(PpuTest, ConvertToRgbaHonoursPitch) {
+    const PPU::RgbaTable table = PPU::BuildRgbaTable();
+    std::vector<uint16_t> framebuffer(PPU::kWidth * 2, 0x30);
+    framebuffer[PPU::kWidth] = 0x0F;
+
+    // Padded rows like a locked texture, the padding is left alone
+    constexpr int kPitch = PPU::kWidth + 16;
+    std::vector<uint32_t> rgba(kPitch * 2, 0);
+    PPU::ConvertToRgba(framebuffer, table, rgba.data(), kPitch);
+    EXPECT_EQ(rgba[0], table[0x30]);
+    EXPECT_EQ(rgba[PPU::kWidth - 1], table[0x30]);
+    EXPECT_EQ(rgba[PPU::kWidth], 0u);
+    EXPECT_EQ(rgba[kPitch], table[0x0F]);
+    EXPECT_EQ(rgba[kPitch + 1], table[0x30]);
+}
+
+TEST(PpuTest, RenderPatternTableDrawsMirroredTiles) {
+    const TestRom rom = WriteRandomChrRom(99);
+    const auto cartridge = std::make_shared<Cartridge>(rom.Path());
+    ASSERT_TRUE(cartridge->isLoaded());
+    PPU ppu;
+    ppu.SetCartridge(cartridge);
+    for (int i = 0; i < 4; i++) ppu.PpuWrite(0x3F04 + i, static_cast<uint8_t>(0x11 + i));
+
+    const PPU::RgbaTable table = PPU::BuildRgbaTable();
+    constexpr int kPitch = PPU::kPatternTableSize + 8;
+    std::vector<uint32_t> rgba(kPitch * PPU::kPatternTableSize);
+    ppu.RenderPatternTable(1, 1, table, rgba.data(), kPitch);
+
+    for (int y = 0; y < PPU::kPatternTableSize; y++) {
+        for (int x = 0; x < PPU::kPatternTableSize; x++) {
+            const uint16_t address = 0x1000 + (y / 8) * 256 + (x / 8) * 16 + y % 8;
+            const int bit = x % 8; // Mirrored, so the leftmost pixel is bit 0
+            const int pixel = (cartridge->PpuRead(address) >> bit & 1)
+                | (cartridge->PpuRead(address + 8) >> bit & 1) << 1;
+            ASSERT_EQ(rgba[y * kPitch + x], table[ppu.GetPaletteRamColor(1, pixel)]) << x << ", " << y;
+        }
+    }
+}
+
+TEST(PpuTest, RowVersionsChangeOnlyWithPixels) {
+    const TestRom rom = WriteRandomChrRom(5);
+    const auto cartridge = std::make_shared<Cartridge>(rom.Path());
+    ASSERT_TRUE(cartridge->isLoaded());
+
+    // Per dot and whole lines at once
+    for (const bool use_step : {true, false}) {
+        PPU ppu;
+        ppu.SetCartridge(cartridge);
+        for (uint16_t address = 0x2000; address < 0x2400; address++) ppu.PpuWrite(address, address & 0xFF);
+        for (uint16_t address = 0x3F00; address < 0x3F10; address++) ppu.PpuWrite(address, address & 0x3F);
+        ppu.CpuWrite(1, 0x0A); // Background only
+        const auto run_frame = [&ppu, use_step]() {
+            ppu.vram_address_.value_ = 0; // Not reloaded from the scroll, as the pre-render line is skipped
+            const uint32_t dots = ppu.DotsUntilFrameComplete();
+            if (use_step) {
+                for (uint32_t i = 0; i < dots; i++) ppu.Step();
+            }
+            else {
+                ppu.Run(dots);
+            }
+        };
+
+        run_frame(); // The first line of the first frame lacks the tiles prefetched on the line before
+        run_frame();
+        const PPU::RowVersions first = ppu.GetRowVersions();
+        for (int y = 0; y < PPU::kHeight; y++) EXPECT_NE(first[y], 0u) << y;
+
+        run_frame();
+        EXPECT_EQ(ppu.GetRowVersions(), first) << "same picture";
+
+        ppu.PpuWrite(0x2000 + 5 * 32 + 3, 0x00); // A tile on lines 40 to 47
+        run_frame();
+        const PPU::RowVersions& changed = ppu.GetRowVersions();
+        for (int y = 0; y < PPU::kHeight; y++) {
+            EXPECT_EQ(changed[y] != first[y], y >= 40 && y < 48) << y;
+        }
+    }
+}
+
+TEST(PpuTest, DirtyRowTrackerReportsChangedRuns) {
+    PPU::RowVersions versions = {};
+    DirtyRowTracker tracker;
+    std::vector<std::pair<int, int>> runs;
+    const auto collect = [&runs](const int first_row, const int row_count) { runs.emplace_back(first_row, row_count); };
+
+    tracker.Collect(versions, collect);
+    EXPECT_EQ(runs, (std::vector<std::pair<int, int>>{{0, PPU::kHeight}})); // Nothing uploaded yet
+
+    runs.clear();
+    tracker.Collect(versions, collect);
+    EXPECT_TRUE(runs.empty());
+
+    versions[0]++;
+    versions[10]++;
+    versions[11]++;
+    versions[PPU::kHeight - 1]++;
+    tracker.Collect(versions, collect);
+    EXPECT_EQ(runs, (std::vector<std::pair<int, int>>{{0, 1}, {10, 2}, {PPU::kHeight - 1, 1}}));
+
+    runs.clear();
+    tracker.Reset();
+    tracker.Collect(versions, collect);
+    EXPECT_EQ(runs, (std::vector<std::pair<int, int>>{{0, PPU::kHeight}}));
+}
+
+TEST(PpuTest, HidingSpritesMidLineDelaysThem) {
+    const TestRom rom = WriteRandomChrRom(7);
+    const auto cartridge = std::make_shared<Cartridge>(rom.Path());
+    ASSERT_TRUE(cartridge->isLoaded());
+
+    PPU ppu;
+    ppu.SetCartridge(cartridge);
+    for (uint16_t address = 0x3F00; address < 0x3F20; address++) ppu.PpuWrite(address, address & 0x3F);
+    for (auto& sprite : ppu.oam_.sprites) sprite.y_ = 0xFF;
+    ppu.oam_.sprites[0] = {};
+    ppu.oam_.sprites[0].y_ = 9; // Drawn on line 10
+    ppu.oam_.sprites[0].tile_id_ = 1;
+    ppu.oam_.sprites[0].x_ = 20;
+    ppu.InvalidateOamIndex();
+    ppu.CpuWrite(1, 0x14); // Sprites only
+
+    // Hidden on dots 10 to 12 of line 10, before the sprite starts
+    for (int i = 0; i < 10 * 341 + 10; i++) ppu.Step();
+    ppu.CpuWrite(1, 0x00);
+    for (int i = 0; i < 3; i++) ppu.Step();
+    ppu.CpuWrite(1, 0x14);
+    for (int i = 0; i < 341; i++) ppu.Step();
+
+    const auto& pixels = cartridge->ChrRow(0x0010).pixels_;
+    const uint16_t* line = &ppu.GetFrameBuffer()[10 * PPU::kWidth];
+    for (int x = 0; x < PPU::kWidth - 1; x++) {
+        const int j = x - 23;
+        const uint8_t px = j >= 0 && j < 8 ? pixels[j] : 0;
+        ASSERT_EQ(line[x], ppu.GetPaletteRamColor(px ? 4 : 0, px)) << x;
+    }
+}
+
+TEST(PpuTest, SpriteEvaluationMatchesOamScan) {
+    const auto cartridge = std::make_shared<Cartridge>("roms/nes-testroms/other/nestest.nes");
+    ASSERT_TRUE(cartridge->isLoaded());
+
+    uint32_t seed = 31337;
+    const auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return static_cast<uint8_t>(seed >> 16);
+    };
+
+    for (int frame = 0; frame < 16; frame++) {
+        PPU ppu;
+        ppu.SetCartridge(cartridge);
+
+        // Crowded lines for the overflow flag, some frames in 8x16
+        for (auto& sprite : ppu.oam_.sprites) {
+            sprite.y_ = random() % 64 + (frame & 1) * 170;
+            sprite.x_ = random();
+        }
+        ppu.InvalidateOamIndex();
+        ppu.CpuWrite(0, frame & 2 ? 0x20 : 0x00);
+        ppu.CpuWrite(1, 0x14);
+
+        uint32_t dots = 0;
+        for (int line = 0; line < PPU::kHeight; line++) {
+            // Moved through OAMDATA while the frame is drawn
+            if (line % 16 == 8) {
+                ppu.CpuWrite(3, static_cast<uint8_t>(random() % 64 * 4));
+                ppu.CpuWrite(4, static_cast<uint8_t>(line + random() % 16));
+            }
+
+            // Up to and including dot 257, where the sprites are evaluated
+            for (; dots < line * 341 + 258u; dots++) ppu.Step();
+
+            std::vector<int> expected;
+            const int height = frame & 2 ? 16 : 8;
+            for (int i = 0; i < 64; i++) {
+                const int diff = line - ppu.oam_.sprites[i].y_;
+                if (diff >= 0 && diff < height) expected.push_back(i);
+            }
+            ASSERT_EQ(ppu.status_.sprite_overflow_, expected.size() > 8) << "frame " << frame << " line " << line;
+            ASSERT_EQ(ppu.spriteZeroHitPossible_, !expected.empty() && expected[0] == 0);
+            ASSERT_EQ(ppu.curr_scanline_sprite_count_, std::min<size_t>(expected.size(), 8));
+            for (int i = 0; i < ppu.curr_scanline_sprite_count_; i++) {
+                ASSERT_EQ(ppu.curr_scanline_sprites_[i].x_, ppu.oam_.sprites[expected[i]].x_)
+                    << "frame " << frame << " line " << line;
+            }
+        }
+    }
+}
+
+TEST(PpuTest, NametableMirroring) {
+    using Mirroring = Cartridge::MirroringType;
+    const auto cartridge = std::make_shared<Cartridge>("roms/nes-testroms/other/nestest.nes");
+    ASSERT_TRUE(cartridge->isLoaded());
+
+    // Page seen at $2000, $2400, $2800 and $2C00
+    const std::pair<Mirroring, std::array<int, 4>> cases[] = {
+        {Mirroring::kHorizontal, {0, 0, 1, 1}},
+        {Mirroring::kVertical, {0, 1, 0, 1}},
+        {Mirroring::kFourScreen, {0, 1, 2, 3}},
+        {Mirroring::kSingleScreenLower, {0, 0, 0, 0}},
+        {Mirroring::kSingleScreenUpper, {1, 1, 1, 1}},
+    };
+    for (const auto& [mirroring, pages] : cases) {
+        PPU ppu;
+        cartridge->mirroring_ = Mirroring::kFourScreen;
+        ppu.SetCartridge(cartridge);
+        for (int page = 0; page < 4; page++) ppu.PpuWrite(0x2000 + page * 0x400 + 0x123, page + 1);
+
+        cartridge->mirroring_ = mirroring;
+        ppu.UpdateNametablePages();
+        for (int slot = 0; slot < 4; slot++) {
+            EXPECT_EQ(ppu.PpuRead(0x2000 + slot * 0x400 + 0x123), pages[slot] + 1) << "slot " << slot;
+            EXPECT_EQ(ppu.PpuRead(0x3000 + slot * 0x400 + 0x123), pages[slot] + 1) << "slot " << slot;
+        }
+    }
+}
+
+TEST(PpuTest, BlankScanlinesMatchStep) {
+    const TestRom rom = WriteRandomChrRom(11);
+    const auto cartridge = std::make_shared<Cartridge>(rom.Path());
+    ASSERT_TRUE(cartridge->isLoaded());
+
+    uint32_t seed = 2718;
+    const auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return static_cast<uint8_t>(seed >> 16);
+    };
+
+    PPU step_ppu, run_ppu;
+    for (PPU* ppu : {&step_ppu, &run_ppu}) ppu->SetCartridge(cartridge);
+    for (uint16_t address = 0x2000; address < 0x2800; address++) {
+        const uint8_t value = random();
+        step_ppu.PpuWrite(address, value);
+        run_ppu.PpuWrite(address, value);
+    }
+    for (int i = 0; i < 256; i++) {
+        const uint8_t value = i % 4 == 0 ? random() % 240 : random();
+        step_ppu.oam_.bytes[i] = value;
+        run_ppu.oam_.bytes[i] = value;
+    }
+    for (PPU* ppu : {&step_ppu, &run_ppu}) ppu->InvalidateOamIndex();
+
+    // Mostly disabled, with emphasis or grayscale, sometimes rendering, and a new backdrop now and then
+    const uint8_t masks[] = {0x00, 0x00, 0xE1, 0x40, 0x1E, 0x0A};
+    for (int chunk = 0; chunk < 400; chunk++) {
+        const uint8_t mask = masks[random() % 6];
+        const uint8_t backdrop = random() & 0x3F;
+        // Often up to the start of a line, where the mask change takes effect from a whole line
+        const uint32_t to_line_start = (step_ppu.DotsUntilVblank() + 339) % 341;
+        const uint32_t dots = random() % 2 ? to_line_start + 341 * (random() % 4)
+                                           : 1 + (random() << 8 | random()) % 5000;
+        for (PPU* ppu : {&step_ppu, &run_ppu}) {
+            ppu->CpuWrite(1, mask);
+            if (chunk % 8 == 0) ppu->PpuWrite(0x3F00, backdrop);
+        }
+
+        for (uint32_t i = 0; i < dots; i++) step_ppu.Step();
+        run_ppu.Run(dots);
+
+        ASSERT_EQ(step_ppu.DotsUntilFrameComplete(), run_ppu.DotsUntilFrameComplete()) << "chunk " << chunk;
+        ASSERT_TRUE(SameRenderState(step_ppu, run_ppu)) << "chunk " << chunk;
+        ASSERT_EQ(step_ppu.status_.value_, run_ppu.status_.value_) << "chunk " << chunk;
+        ASSERT_EQ(step_ppu.curr_scanline_sprite_count_, run_ppu.curr_scanline_sprite_count_) << "chunk " << chunk;
+        ASSERT_EQ(step_ppu.spriteZeroHitPossible_, run_ppu.spriteZeroHitPossible_) << "chunk " << chunk;
+        ASSERT_TRUE(SameFrame(step_ppu, run_ppu)) << "chunk " << chunk;
+    }
+}
+
+// Without pixels to draw, Run() still finds every sprite 0 hit and leaves the same state behind,
+// and Step() and Run() count the same dots
+TEST(PpuTest, TimingOnlyRunKeepsHitsAndState) {
+    const TestRom rom = WriteRandomChrRom(5);
+    const auto cartridge = std::make_shared<Cartridge>(rom.Path());
+    ASSERT_TRUE(cartridge->isLoaded());
+
+    uint32_t seed = 4242;
+    const auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return static_cast<uint8_t>(seed >> 16);
+    };
+
+    PPU drawing_ppu, timing_ppu;
+    for (PPU* ppu : {&drawing_ppu, &timing_ppu}) ppu->SetCartridge(cartridge);
+    timing_ppu.render_pixels_ = false;
+    const std::vector<uint16_t> blank = timing_ppu.GetFrameBuffer();
+
+    int hits = 0;
+    for (int frame = 0; frame < 32; frame++) {
+        for (uint16_t address = 0x2000; address < 0x2800; address++) {
+            const uint8_t value = random();
+            drawing_ppu.PpuWrite(address, value);
+            timing_ppu.PpuWrite(address, value);
+        }
+        for (int i = 0; i < 256; i++) {
+            const uint8_t value = random();
+            drawing_ppu.oam_.bytes[i] = value;
+            timing_ppu.oam_.bytes[i] = value;
+        }
+        // Sprite 0 somewhere on screen, the hit flag is cleared for each frame
+        const uint8_t mask = frame % 2 ? 0x1E : 0x18;
+        const uint8_t sprite_y = random() % 232, sprite_x = random();
+        for (PPU* ppu : {&drawing_ppu, &timing_ppu}) {
+            ppu->status_.value_ = 0;
+            ppu->oam_.sprites[0].y_ = sprite_y;
+            ppu->oam_.sprites[0].x_ = sprite_x;
+            ppu->InvalidateOamIndex();
+            ppu->CpuWrite(1, mask);
+            ppu->vram_address_.value_ = 0;
+        }
+
+        const uint32_t dots = drawing_ppu.DotsUntilFrameComplete();
+        for (uint32_t i = 0; i < dots; i++) drawing_ppu.Step();
+        timing_ppu.Run(dots);
+
+        ASSERT_EQ(drawing_ppu.status_.value_, timing_ppu.status_.value_) << "frame " << frame;
+        ASSERT_EQ(drawing_ppu.dot_count_, timing_ppu.dot_count_) << "frame " << frame;
+        ASSERT_TRUE(SameRenderState(drawing_ppu, timing_ppu)) << "frame " << frame;
+        hits += drawing_ppu.status_.sprite_0_hit_;
+        for (PPU* ppu : {&drawing_ppu, &timing_ppu}) ppu->frame_complete_ = false;
+    }
+    EXPECT_GT(hits, 8);
+    EXPECT_EQ(timing_ppu.GetFrameBuffer(), blank);
+    EXPECT_EQ(timing_ppu.GetRowVersions(), PPU::RowVersions{});
+}
+
+// Lines recorded while the frame runs and drawn afterwards across a pool look the same as lines drawn
+// as they run. Chunks of random length draw some lines dot by dot, which are not recorded.
+TEST(PpuTest, RecordedScanlinesMatchDirectDrawing) {
+    const TestRom rom = WriteRandomChrRom(31);
+    const auto cartridge = std::make_shared<Cartridge>(rom.Path());
+    ASSERT_TRUE(cartridge->isLoaded());
+
+    uint32_t seed = 1618;
+    const auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return static_cast<uint8_t>(seed >> 16);
+    };
+
+    PPU direct_ppu, recording_ppu;
+    for (PPU* ppu : {&direct_ppu, &recording_ppu}) ppu->SetCartridge(cartridge);
+    recording_ppu.record_scanlines_ = true;
+    ThreadPool pool(4);
+
+    // Rendering disabled on some frames, whose lines are filled with the backdrop at once
+    const uint8_t masks[] = {0x1E, 0x0A, 0x14, 0x00, 0x18, 0x1E, 0x3E};
+    for (int frame = 0; frame < 24; frame++) {
+        for (uint16_t address = 0x2000; address < 0x2800; address++) {
+            const uint8_t value = random();
+            direct_ppu.PpuWrite(address, value);
+            recording_ppu.PpuWrite(address, value);
+        }
+        for (uint16_t address = 0x3F00; address < 0x3F20; address++) {
+            const uint8_t value = random();
+            direct_ppu.PpuWrite(address, value);
+            recording_ppu.PpuWrite(address, value);
+        }
+        for (int i = 0; i < 256; i++) {
+            const uint8_t value = random();
+            direct_ppu.oam_.bytes[i] = value;
+            recording_ppu.oam_.bytes[i] = value;
+        }
+        const uint8_t mask = masks[frame % 7], scroll_x = random(), scroll_y = random() % 240;
+        for (PPU* ppu : {&direct_ppu, &recording_ppu}) {
+            ppu->status_.value_ = 0;
+            ppu->InvalidateOamIndex();
+            ppu->vram_address_.value_ = 0;
+            ppu->CpuWrite(1, mask);
+            ppu->CpuWrite(5, scroll_x);
+            ppu->CpuWrite(5, scroll_y);
+        }
+
+        for (uint32_t left = direct_ppu.DotsUntilFrameComplete(); left > 0;) {
+            const uint32_t dots = std::min<uint32_t>(left, 1 + (random() << 4 | random() >> 4) % 3000);
+            direct_ppu.Run(dots);
+            recording_ppu.Run(dots);
+            left -= dots;
+            ASSERT_EQ(direct_ppu.status_.value_, recording_ppu.status_.value_) << "frame " << frame;
+        }
+
+        // Every other frame, so the rows recorded on one frame are all drawn again on the next
+        if (frame % 2 == 1) {
+            std::atomic<int> rows{0};
+            recording_ppu.DrawRecordedScanlines(pool, [&rows](int) { rows++; });
+            EXPECT_EQ(rows, PPU::kHeight);
+            ASSERT_TRUE(SameFrame(direct_ppu, recording_ppu)) << "frame " << frame;
+        }
+        for (PPU* ppu : {&direct_ppu, &recording_ppu}) ppu->frame_complete_ = false;
+    }
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "bus.h"
+#include "cpu.h"
+#include "ppu.h"
+#include "ppu_render_thread.h"
+#include "test_rom.h"
+
+namespace {
+    constexpr int kFrames = 40;
+
+    // Builds a CNROM ROM that sets up a palette, enables rendering and NMI, then switches CHR banks,
+    // polls PPUSTATUS and writes PPUSCROLL from a loop with a varying delay, while the NMI handler
+    // starts an OAM DMA of sprites the loop keeps moving
+    TestRom WriteBankSwitchRom() {
+        std::vector<uint8_t> prg(0x4000, 0xEA);
+
+        const std::vector<uint8_t> code = {
+            0xA9, 0x3F, 0x8D, 0x06, 0x20, // $C000 LDA #$3F, STA $2006
+            0xA9, 0x00, 0x8D, 0x06, 0x20, // $C005 LDA #$00, STA $2006
+            0xA9, 0x0F, 0x8D, 0x07, 0x20, // $C00A LDA #$0F, STA $2007
+            0xA9, 0x16, 0x8D, 0x07, 0x20, // $C00F LDA #$16, STA $2007
+            0xA9, 0x2A, 0x8D, 0x07, 0x20, // $C014 LDA #$2A, STA $2007
+            0xA9, 0x12, 0x8D, 0x07, 0x20, // $C019 LDA #$12, STA $2007
+            0xA9, 0x1E, 0x8D, 0x01, 0x20, // $C01E LDA #$1E, STA $2001
+            0xA9, 0x80, 0x8D, 0x00, 0x20, // $C023 LDA #$80, STA $2000
+            0xE8, 0x8A, 0x29, 0x01, 0x8D, 0x00, 0x80, // $C028 INX, TXA, AND #1, STA $8000
+            0x8A, 0x9D, 0x00, 0x02, // $C02F TXA, STA $0200,X
+            0xAD, 0x02, 0x20, // $C033 LDA $2002
+            0x8E, 0x05, 0x20, 0xEA, 0xEA, 0xEA, // $C036 STX $2005, NOP x3
+            0x8A, 0x29, 0x7F, 0xA8, 0x88, 0x10, 0xFD, // $C03C TXA, AND #$7F, TAY, DEY, BPL $C040
+            0x4C, 0x28, 0xC0 // $C043 JMP $C028
+        };
+        std::copy(code.begin(), code.end(), prg.begin());
+
+        const std::vector<uint8_t> nmi = {
+            0xA9, 0x02, 0x8D, 0x14, 0x40, 0x40 // $C050 LDA #$02, STA $4014, RTI
+        };
+        std::copy(nmi.begin(), nmi.end(), prg.begin() + 0x50);
+
+        prg[0x3FFA] = 0x50; // NMI vector $C050
+        prg[0x3FFB] = 0xC0;
+        prg[0x3FFC] = 0x00; // Reset vector $C000
+        prg[0x3FFD] = 0xC0;
+
+        // Solid color 1 tiles in the first bank, stripes of colors 1 and 2 in the second
+        std::vector<uint8_t> chr(0x4000);
+        for (size_t i = 0; i < chr.size(); i++) {
+            const bool second_bank = i >= 0x2000;
+            const bool msb_plane = (i & 0x08) != 0;
+            chr[i] = second_bank ? (msb_plane ? 0x55 : 0xAA) : (msb_plane ? 0x00 : 0xFF);
+        }
+        return {3, prg, chr};
+    }
+}
+
+// The render thread replays the logged inputs into a copy of the PPU, so its frames and the timing
+// the CPU sees must be those of a PPU drawing them itself
+TEST(PpuRenderThreadTest, FramesMatchSingleThread) {
+    const TestRom rom = WriteBankSwitchRom();
+    CPU plain_cpu, threaded_cpu;
+    PPU plain_ppu, threaded_ppu;
+    Bus plain_bus(&plain_cpu, &plain_ppu);
+    Bus threaded_bus(&threaded_cpu, &threaded_ppu);
+    ASSERT_TRUE(plain_bus.LoadCartridge(rom.Path()));
+    ASSERT_TRUE(threaded_bus.LoadCartridge(rom.Path()));
+    threaded_bus.EnableRenderThread(true);
+    ASSERT_NE(threaded_bus.render_thread_, nullptr);
+
+    // Versions count changes per dot or per line depending on how the PPU was run, so only their
+    // changes are compared
+    std::set<uint16_t> colors;
+    PpuRenderThread::Frame previous{plain_ppu.GetFrameBuffer(), plain_ppu.GetRowVersions()};
+    for (int frame = 0; frame < kFrames; frame++) {
+        plain_bus.RunFrame();
+        plain_ppu.frame_complete_ = false;
+        threaded_bus.RunFrame();
+        threaded_ppu.frame_complete_ = false;
+
+        ASSERT_EQ(plain_bus.total_cycles_, threaded_bus.total_cycles_) << "frame " << frame;
+        ASSERT_EQ(plain_cpu.PC(), threaded_cpu.PC()) << "frame " << frame;
+        ASSERT_EQ(plain_ppu.status_.value_, threaded_ppu.status_.value_) << "frame " << frame;
+
+        threaded_bus.render_thread_->WaitForFrame(frame + 1);
+        const PpuRenderThread::Frame& rendered = threaded_bus.render_thread_->CurrentFrame();
+        ASSERT_EQ(rendered.number_, static_cast<uint64_t>(frame + 1));
+        ASSERT_EQ(rendered.framebuffer_, plain_ppu.GetFrameBuffer()) << "frame " << frame;
+        for (int row = 0; row < PPU::kHeight; row++) {
+            const auto first = rendered.framebuffer_.begin() + row * PPU::kWidth;
+            if (std::equal(first, first + PPU::kWidth, previous.framebuffer_.begin() + row * PPU::kWidth)) continue;
+            ASSERT_NE(rendered.row_versions_[row], previous.row_versions_[row]) << "frame " << frame << " row " << row;
+        }
+        previous = rendered;
+        colors.insert(plain_ppu.GetFrameBuffer().begin(), plain_ppu.GetFrameBuffer().end());
+    }
+    EXPECT_GE(colors.size(), 3u); // Both banks and the sprites were drawn
+
+    // Turned off mid-frame, the PPU takes over the pixels drawn so far and goes on drawing
+    for (int i = 0; i < 20000; i++) {
+        plain_bus.Step();
+        threaded_bus.Step();
+    }
+    threaded_bus.EnableRenderThread(false);
+    EXPECT_EQ(threaded_ppu.GetFrameBuffer(), plain_ppu.GetFrameBuffer());
+    plain_ppu.frame_complete_ = false;
+    threaded_ppu.frame_complete_ = false;
+    plain_bus.RunFrame();
+    threaded_bus.RunFrame();
+    EXPECT_EQ(threaded_ppu.GetFrameBuffer(), plain_ppu.GetFrameBuffer());
+}
+
+// Frames the display did not take are dropped, it only ever gets the newest one
+TEST(PpuRenderThreadTest, DisplayTakesNewestFrame) {
+    const TestRom rom = WriteBankSwitchRom();
+    CPU cpu;
+    PPU ppu;
+    Bus bus(&cpu, &ppu);
+    ASSERT_TRUE(bus.LoadCartridge(rom.Path()));
+    bus.EnableRenderThread(true);
+
+    EXPECT_EQ(bus.render_thread_->CurrentFrame().number_, 0u);
+    EXPECT_FALSE(bus.render_thread_->AcquireFrame());
+    for (int frame = 0; frame < 5; frame++) {
+        bus.RunFrame();
+        ppu.frame_complete_ = false;
+    }
+    bus.render_thread_->WaitForFrame(5);
+    EXPECT_EQ(bus.render_thread_->CurrentFrame().number_, 5u);
+    EXPECT_FALSE(bus.render_thread_->AcquireFrame());
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// An iNES ROM written to a file of its own in the temporary directory and removed again when the
+// object goes out of scope. Names are unique within a process and across the processes ctest runs
+// the tests in, so tests never share a file.
+class TestRom {
+public:
+    // PRG ROM is a multiple of 16KB and CHR ROM of 8KB, no CHR ROM gives the cartridge CHR RAM
+    TestRom(const uint8_t mapper, const std::vector<uint8_t>& prg, const std::vector<uint8_t>& chr = {})
+        : path_(UniquePath()) {
+        std::vector<uint8_t> rom = {'N', 'E', 'S', 0x1A, static_cast<uint8_t>(prg.size() / 0x4000),
+                                    static_cast<uint8_t>(chr.size() / 0x2000), static_cast<uint8_t>(mapper << 4),
+                                    static_cast<uint8_t>(mapper & 0xF0), 0, 0, 0, 0, 0, 0, 0, 0};
+        rom.insert(rom.end(), prg.begin(), prg.end());
+        rom.insert(rom.end(), chr.begin(), chr.end());
+
+        std::ofstream file(path_, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(rom.data()), static_cast<std::streamsize>(rom.size()));
+    }
+
+    ~TestRom() {
+        std::error_code error;
+        std::filesystem::remove(path_, error);
+    }
+
+    TestRom(const TestRom&) = delete;
+    TestRom& operator=(const TestRom&) = delete;
+
+    [[nodiscard]] const std::string& Path() const { return path_; }
+
+private:
+    std::string path_;
+
+    static std::string UniquePath() {
+        // The clock keeps processes apart where random_device is deterministic
+        static const uint32_t process_key = std::random_device{}()
+            ^ static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        static std::atomic<uint32_t> count{0};
+        const std::string name = "nes_test_" + std::to_string(process_key) + "_" + std::to_string(count++) + ".nes";
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+};
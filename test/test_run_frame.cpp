@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "bus.h"
+#include "cpu.h"
+#include "ppu.h"
+#include "test_rom.h"
+
+namespace {
+    constexpr int kFrames = 60;
+    const std::string kNestestPath = "roms/nes-testroms/other/nestest.nes";
+
+    // Builds an NROM ROM with rendering and NMI enabled that starts an OAM DMA from its main loop,
+    // after a delay that changes the cycle parity, and from its NMI handler
+    TestRom WriteDmaLoopRom() {
+        std::vector<uint8_t> prg(0x4000, 0xEA);
+
+        const std::vector<uint8_t> code = {
+            0xA9, 0x80, 0x8D, 0x00, 0x20, // $C000 LDA #$80, STA $2000
+            0xA9, 0x1E, 0x8D, 0x01, 0x20, // $C005 LDA #$1E, STA $2001
+            0xE8, 0x8A, 0x9D, 0x00, 0x02, // $C00A INX, TXA, STA $0200,X
+            0x29, 0x03, 0xA8, 0x88, 0x10, 0xFD, // $C00F AND #3, TAY, DEY, BPL $C012
+            0xA9, 0x02, 0x8D, 0x14, 0x40, // $C015 LDA #$02, STA $4014
+            0x4C, 0x0A, 0xC0 // $C01A JMP $C00A
+        };
+        std::copy(code.begin(), code.end(), prg.begin());
+
+        const std::vector<uint8_t> nmi = {
+            0xE6, 0x10, 0xA9, 0x02, 0x8D, 0x14, 0x40, 0x40 // $C020 INC $10, LDA #$02, STA $4014, RTI
+        };
+        std::copy(nmi.begin(), nmi.end(), prg.begin() + 0x20);
+
+        prg[0x3FFA] = 0x20; // NMI vector $C020
+        prg[0x3FFB] = 0xC0;
+        prg[0x3FFC] = 0x00; // Reset vector $C000
+        prg[0x3FFD] = 0xC0;
+        return {0, prg, std::vector<uint8_t>(0x2000)};
+    }
+
+    // Builds an MMC3 ROM rendering with the sprites at $1000 that takes a scanline IRQ every few
+    // lines, the handler acknowledging it and loading another latch, and counts NMIs and IRQs in
+    // $11 and $10
+    TestRom WriteMmc3IrqRom() {
+        std::vector<uint8_t> prg(0x8000, 0xEA);
+        const size_t last = 0x6000; // $E000, the fixed bank
+
+        const std::vector<uint8_t> code = {
+            0xA9, 0x88, 0x8D, 0x00, 0x20, // $E000 LDA #$88, STA $2000
+            0xA9, 0x1E, 0x8D, 0x01, 0x20, // $E005 LDA #$1E, STA $2001
+            0xA9, 0x1F, 0x8D, 0x00, 0xC0, // $E00A LDA #$1F, STA $C000
+            0x8D, 0x01, 0xC0, 0x8D, 0x01, 0xE0, // $E00F STA $C001, STA $E001
+            0x58, // $E015 CLI
+            0xE8, 0x4C, 0x16, 0xE0 // $E016 INX, JMP $E016
+        };
+        std::copy(code.begin(), code.end(), prg.begin() + last);
+
+        const std::vector<uint8_t> irq = {
+            0x8D, 0x00, 0xE0, 0x8D, 0x01, 0xE0, // $E020 STA $E000, STA $E001
+            0x8A, 0x29, 0x1F, 0x09, 0x04, 0x8D, 0x00, 0xC0, // $E026 TXA, AND #$1F, ORA #$04, STA $C000
+            0xE6, 0x10, 0x40 // $E02E INC $10, RTI
+        };
+        std::copy(irq.begin(), irq.end(), prg.begin() + last + 0x20);
+        const std::vector<uint8_t> nmi = {0xE6, 0x11, 0x40}; // $E040 INC $11, RTI
+        std::copy(nmi.begin(), nmi.end(), prg.begin() + last + 0x40);
+
+        prg[0x7FFA] = 0x40; // NMI vector $E040
+        prg[0x7FFB] = 0xE0;
+        prg[0x7FFC] = 0x00; // Reset vector $E000
+        prg[0x7FFD] = 0xE0;
+        prg[0x7FFE] = 0x20; // IRQ vector $E020
+        prg[0x7FFF] = 0xE0;
+        return {4, prg, std::vector<uint8_t>(0x2000)};
+    }
+
+    bool SameFrame(const PPU& a, const PPU& b) {
+        return a.GetFrameBuffer() == b.GetFrameBuffer();
+    }
+
+    // Runs a ROM frame by frame through Step() and through RunFrame(), pressing Start on the same
+    // frames so the nestest menu runs its tests, and checks that both agree at the end of every frame
+    void ExpectRunFrameMatchesStep(const std::string& rom_path, const CPU::Core core) {
+        CPU step_cpu, run_cpu;
+        PPU step_ppu, run_ppu;
+        Bus step_bus(&step_cpu, &step_ppu);
+        Bus run_bus(&run_cpu, &run_ppu);
+        ASSERT_TRUE(step_bus.LoadCartridge(rom_path));
+        ASSERT_TRUE(run_bus.LoadCartridge(rom_path));
+        step_cpu.set_core(core);
+        run_cpu.set_core(core);
+
+        for (int frame = 0; frame < kFrames; frame++) {
+            const uint8_t buttons = frame >= 20 && frame < 24 ? 0x10 : 0x00;
+            step_bus.curr_controller_state[0] = buttons;
+            run_bus.curr_controller_state[0] = buttons;
+
+            do { step_bus.Step(); }
+            while (!step_ppu.frame_complete_);
+            step_ppu.frame_complete_ = false;
+
+            run_bus.RunFrame();
+            run_ppu.frame_complete_ = false;
+
+            ASSERT_EQ(step_bus.total_cycles_, run_bus.total_cycles_) << "frame " << frame;
+            ASSERT_EQ(step_cpu.TotalCycles(), run_cpu.TotalCycles()) << "frame " << frame;
+            ASSERT_EQ(step_cpu.PC(), run_cpu.PC()) << "frame " << frame;
+            ASSERT_EQ(step_cpu.A(), run_cpu.A()) << "frame " << frame;
+            ASSERT_EQ(step_cpu.P(), run_cpu.P()) << "frame " << frame;
+            ASSERT_EQ(step_cpu.SP(), run_cpu.SP()) << "frame " << frame;
+            ASSERT_EQ(step_bus.ram_, run_bus.ram_) << "frame " << frame;
+            ASSERT_TRUE(std::equal(std::begin(step_ppu.oam_.bytes), std::end(step_ppu.oam_.bytes),
+                                   std::begin(run_ppu.oam_.bytes))) << "frame " << frame;
+            ASSERT_TRUE(SameFrame(step_ppu, run_ppu)) << "frame " << frame;
+        }
+    }
+}
+
+TEST(RunFrameTest, MatchesStepOnNestest) {
+    ExpectRunFrameMatchesStep(kNestestPath, CPU::Core::kTable);
+}
+
+TEST(RunFrameTest, MatchesStepOnNestestWithCachedCore) {
+    ExpectRunFrameMatchesStep(kNestestPath, CPU::Core::kCached);
+}
+
+// Overshoot at the end of the cycle budget is largest with whole blocks
+TEST(RunFrameTest, MatchesStepOnNestestWithJit) {
+    if (!JitCompiler::IsSupported()) GTEST_SKIP() << "JIT not supported on this platform";
+    ExpectRunFrameMatchesStep(kNestestPath, CPU::Core::kJit);
+}
+
+// OAM DMA halts the CPU between scheduled events and runs across NMIs
+TEST(RunFrameTest, MatchesStepWithOamDma) {
+    const TestRom rom = WriteDmaLoopRom();
+    ExpectRunFrameMatchesStep(rom.Path(), CPU::Core::kCached);
+}
+
+// Scanline IRQs come from events predicted from the PPU timing, and are taken after NMIs too
+TEST(RunFrameTest, MatchesStepWithMmc3Irqs) {
+    const TestRom rom = WriteMmc3IrqRom();
+    for (const CPU::Core core : {CPU::Core::kTable, CPU::Core::kCached, CPU::Core::kJit}) {
+        if (core == CPU::Core::kJit && !JitCompiler::IsSupported()) continue;
+        ExpectRunFrameMatchesStep(rom.Path(), core);
+    }
+
+    CPU cpu;
+    PPU ppu;
+    Bus bus(&cpu, &ppu);
+    ASSERT_TRUE(bus.LoadCartridge(rom.Path()));
+    for (int frame = 0; frame < 10; frame++) {
+        bus.RunFrame();
+        ppu.frame_complete_ = false;
+    }
+    EXPECT_GE(bus.ram_[0x11], 9); // NMIs
+    EXPECT_GE(bus.ram_[0x10], 9 * 241 / 36); // IRQs, the latch being at most 35
+}
+
+TEST(RunFrameTest, RunStopsAtTheBudget) {
+    CPU cpu;
+    PPU ppu;
+    Bus bus(&cpu, &ppu);
+    ASSERT_TRUE(bus.LoadCartridge(kNestestPath));
+    cpu.set_PC(0xC000);
+
+    // Reset takes 7 cycles, then JMP $C5F5 takes 3
+    EXPECT_EQ(cpu.Run(5), 2);
+    EXPECT_EQ(cpu.TotalCycles(), 5u);
+    EXPECT_EQ(cpu.Run(3), 2); // Finishes the reset, then runs JMP at once
+    EXPECT_EQ(cpu.TotalCycles(), 8u);
+    EXPECT_EQ(cpu.PC(), 0xC5F5);
+    EXPECT_EQ(cpu.Run(2), 0);
+    EXPECT_EQ(cpu.TotalCycles(), 10u);
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+
+#include "ppu/scanline_compositor.h"
+
+namespace {
+    using Kernel = ScanlineCompositor::Kernel;
+    using Line = std::array<uint8_t, ScanlineCompositor::kWidth>;
+
+    constexpr Kernel kKernels[] = {Kernel::kScalar, Kernel::kSse2, Kernel::kAvx2};
+}
+
+TEST(ScanlineCompositorTest, PriorityTransparencyAndHits) {
+    Line background{}, sprites{}, out{};
+    background[10] = 0x05; // Background only
+    sprites[11] = 0x12; // Sprite only
+    background[12] = 0x06; // Sprite in front
+    sprites[12] = 0x13;
+    background[13] = 0x07; // Sprite behind
+    sprites[13] = 0x11 | ScanlineCompositor::kBehindBackground;
+    sprites[14] = 0x00 | ScanlineCompositor::kSpriteZero; // Transparent sprite 0 pixel, no hit
+    background[14] = 0x01;
+
+    for (const Kernel kernel : kKernels) {
+        if (!ScanlineCompositor::IsSupported(kernel)) continue;
+
+        EXPECT_FALSE(ScanlineCompositor::Compose(kernel, background.data(), sprites.data(), true, true, out.data()));
+        EXPECT_EQ(out[9], 0x00);
+        EXPECT_EQ(out[10], 0x05);
+        EXPECT_EQ(out[11], 0x12);
+        EXPECT_EQ(out[12], 0x13);
+        EXPECT_EQ(out[13], 0x07);
+        EXPECT_EQ(out[14], 0x01);
+
+        // Sprite 0 hits even behind the background
+        Line hit_sprites = sprites;
+        hit_sprites[13] |= ScanlineCompositor::kSpriteZero;
+        EXPECT_TRUE(ScanlineCompositor::Compose(kernel, background.data(), hit_sprites.data(), true, true,
+                                                out.data()));
+    }
+}
+
+TEST(ScanlineCompositorTest, LeftMaskHidesLayers) {
+    Line background{}, sprites{}, out{};
+    background.fill(0x02);
+    sprites.fill(0x15 | ScanlineCompositor::kBehindBackground);
+    sprites[3] = 0x15 | ScanlineCompositor::kSpriteZero;
+
+    for (const Kernel kernel : kKernels) {
+        if (!ScanlineCompositor::IsSupported(kernel)) continue;
+
+        EXPECT_TRUE(ScanlineCompositor::Compose(kernel, background.data(), sprites.data(), true, true, out.data()));
+        EXPECT_EQ(out[3], 0x15);
+
+        EXPECT_FALSE(ScanlineCompositor::Compose(kernel, background.data(), sprites.data(), false, true, out.data()));
+        EXPECT_EQ(out[3], 0x15);
+        EXPECT_EQ(out[7], 0x15); // Behind a hidden background
+        EXPECT_EQ(out[8], 0x02);
+
+        EXPECT_FALSE(ScanlineCompositor::Compose(kernel, background.data(), sprites.data(), true, false, out.data()));
+        EXPECT_EQ(out[3], 0x02);
+
+        EXPECT_FALSE(ScanlineCompositor::Compose(kernel, background.data(), sprites.data(), false, false, out.data()));
+        EXPECT_EQ(out[7], 0x00);
+        EXPECT_EQ(out[8], 0x02);
+    }
+}
+
+TEST(ScanlineCompositorTest, KernelsMatchScalar) {
+    uint32_t seed = 2024;
+    const auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return static_cast<uint8_t>(seed >> 16);
+    };
+
+    for (int round = 0; round < 2000; round++) {
+        Line background{}, sprites{};
+        for (int x = 0; x < ScanlineCompositor::kWidth; x++) {
+            background[x] = random() % 2 ? random() & 0x0F : 0;
+            const uint8_t index = random() % 2 ? 0x10 | (random() & 0x0F) : 0;
+            const uint8_t behind = random() % 2 ? ScanlineCompositor::kBehindBackground : 0;
+            const uint8_t zero = random() % 128 == 0 ? ScanlineCompositor::kSpriteZero : 0; // Rare, so some lines miss
+            sprites[x] = index | behind | zero;
+        }
+        const bool show_background_left = random() & 1;
+        const bool show_sprites_left = random() & 1;
+
+        Line expected{};
+        const bool expected_hit = ScanlineCompositor::Compose(Kernel::kScalar, background.data(), sprites.data(),
+                                                              show_background_left, show_sprites_left, expected.data());
+        for (const Kernel kernel : kKernels) {
+            if (!ScanlineCompositor::IsSupported(kernel)) continue;
+
+            Line out{};
+            EXPECT_EQ(ScanlineCompositor::Compose(kernel, background.data(), sprites.data(), show_background_left,
+                                                  show_sprites_left, out.data()), expected_hit);
+            ASSERT_EQ(out, expected) << "kernel " << static_cast<int>(kernel) << " round " << round;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include "scheduler.h"
+
+using Event = Scheduler::Event;
+
+TEST(SchedulerTest, PopsEventsInTimestampOrder) {
+    Scheduler scheduler;
+    scheduler.Schedule(Event::kFrameEnd, 300);
+    scheduler.Schedule(Event::kNmi, 100);
+    scheduler.Schedule(Event::kDmaEnd, 200);
+
+    EXPECT_EQ(scheduler.NextTimestamp(), 100u);
+    EXPECT_EQ(scheduler.Pop(), Event::kNmi);
+    EXPECT_EQ(scheduler.NextTimestamp(), 200u);
+    EXPECT_EQ(scheduler.Pop(), Event::kDmaEnd);
+    EXPECT_EQ(scheduler.Pop(), Event::kFrameEnd);
+    EXPECT_TRUE(scheduler.IsEmpty());
+}
+
+TEST(SchedulerTest, SchedulingAgainReplacesThePendingEvent) {
+    Scheduler scheduler;
+    scheduler.Schedule(Event::kNmi, 100);
+    scheduler.Schedule(Event::kFrameEnd, 200);
+    scheduler.Schedule(Event::kNmi, 300);
+
+    EXPECT_EQ(scheduler.Pop(), Event::kFrameEnd);
+    EXPECT_EQ(scheduler.NextTimestamp(), 300u);
+    EXPECT_EQ(scheduler.Pop(), Event::kNmi);
+    EXPECT_TRUE(scheduler.IsEmpty());
+}
+
+TEST(SchedulerTest, CancelRemovesOnlyThatEvent) {
+    Scheduler scheduler;
+    scheduler.Schedule(Event::kNmi, 100);
+    scheduler.Schedule(Event::kDmaEnd, 150);
+    scheduler.Cancel(Event::kNmi);
+    scheduler.Cancel(Event::kFrameEnd); // Not scheduled
+
+    EXPECT_FALSE(scheduler.IsScheduled(Event::kNmi));
+    EXPECT_TRUE(scheduler.IsScheduled(Event::kDmaEnd));
+    EXPECT_EQ(scheduler.Pop(), Event::kDmaEnd);
+    EXPECT_TRUE(scheduler.IsEmpty());
+}
+
+TEST(SchedulerTest, EventsOnTheSameTickPopInSchedulingOrder) {
+    Scheduler scheduler;
+    scheduler.Schedule(Event::kDmaEnd, 100);
+    scheduler.Schedule(Event::kNmi, 100);
+
+    EXPECT_EQ(scheduler.Pop(), Event::kDmaEnd);
+    EXPECT_EQ(scheduler.Pop(), Event::kNmi);
+}
+
+// 32-bit master tick counters wrapped after about 13 minutes of emulated time
+TEST(SchedulerTest, OrdersTimestampsPastThirtyTwoBits) {
+    constexpr uint64_t kTwoHours = 2ull * 60 * 60 * 5369318; // NTSC master ticks per second
+    Scheduler scheduler;
+    scheduler.Schedule(Event::kFrameEnd, kTwoHours + 89342);
+    scheduler.Schedule(Event::kNmi, kTwoHours + 82523);
+
+    EXPECT_EQ(scheduler.NextTimestamp(), kTwoHours + 82523);
+    EXPECT_EQ(scheduler.Pop(), Event::kNmi);
+    EXPECT_EQ(scheduler.NextTimestamp(), kTwoHours + 89342);
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <numeric>
+#include <vector>
+
+#include "bus.h"
+#include "cpu.h"
+#include "ppu.h"
+#include "test_rom.h"
+
+namespace {
+    constexpr uint16_t kHaltAddress = 0xC020;
+
+    // Builds an NROM ROM running a loop made of every kind of pair, followed by a copy to a PPU
+    // register that must not be fused
+    TestRom WriteIdiomRom() {
+        std::vector<uint8_t> prg(0x4000, 0xEA);
+
+        const std::vector<uint8_t> code = {
+            0xA2, 0x05, // $C000 LDX #5
+            0xA9, 0x80, 0x85, 0x10, // $C002 LDA #$80, STA $10
+            0xAD, 0x10, 0x00, 0x10, 0xFB, // $C006 LDA $0010, BPL $C006 (not taken)
+            0xAD, 0x10, 0x00, 0x8D, 0x00, 0x03, // $C00B LDA $0010, STA $0300
+            0x18, 0x69, 0x7F, // $C011 CLC, ADC #$7F
+            0x18, 0x65, 0x10, // $C014 CLC, ADC $10
+            0xCA, 0xD0, 0xEC, // $C017 DEX, BNE $C006
+            0xAD, 0x10, 0x00, 0x8D, 0x00, 0x20, // $C01A LDA $0010, STA $2000
+            0x4C, kHaltAddress & 0xFF, kHaltAddress >> 8 // $C020 JMP to itself
+        };
+        std::copy(code.begin(), code.end(), prg.begin());
+
+        prg[0x3FFC] = 0x00; // Reset vector $C000
+        prg[0x3FFD] = 0xC0;
+        return {0, prg, std::vector<uint8_t>(0x2000)};
+    }
+
+    size_t PairIndex(const char* name) {
+        for (size_t i = 0; i < Superinstructions::kPairs.size(); i++) {
+            if (std::string(Superinstructions::kPairs[i].name_) == name) return i;
+        }
+        return Superinstructions::kNoPair;
+    }
+
+    // Runs the fused CPU one dispatch at a time and the switch core until it reaches the same
+    // cycle, then checks that both CPUs agree on every register and on RAM
+    void RunLockstep(CPU& reference_cpu, const Bus& reference_bus, CPU& fused_cpu, const Bus& fused_bus,
+                     const std::function<bool()>& done, const int max_dispatches) {
+        for (int i = 0; i < max_dispatches && !done(); i++) {
+            fused_cpu.StepInstruction();
+            while (reference_cpu.TotalCycles() < fused_cpu.TotalCycles()) {
+                reference_cpu.StepInstruction();
+            }
+
+            ASSERT_EQ(reference_cpu.TotalCycles(), fused_cpu.TotalCycles()) << "dispatch " << i;
+            ASSERT_EQ(reference_cpu.PC(), fused_cpu.PC()) << "dispatch " << i;
+            ASSERT_EQ(reference_cpu.A(), fused_cpu.A()) << "dispatch " << i;
+            ASSERT_EQ(reference_cpu.X(), fused_cpu.X()) << "dispatch " << i;
+            ASSERT_EQ(reference_cpu.Y(), fused_cpu.Y()) << "dispatch " << i;
+            ASSERT_EQ(reference_cpu.P(), fused_cpu.P()) << "dispatch " << i;
+            ASSERT_EQ(reference_cpu.SP(), fused_cpu.SP()) << "dispatch " << i;
+            ASSERT_EQ(reference_bus.ram_, fused_bus.ram_) << "dispatch " << i;
+        }
+        EXPECT_TRUE(done());
+    }
+}
+
+TEST(SuperinstructionsTest, MatchSkipsTimingSensitiveAccesses) {
+    EXPECT_EQ(Superinstructions::Match(0xAD, 0x8D, 0x0300), PairIndex("LDA abs / STA abs"));
+    EXPECT_EQ(Superinstructions::Match(0xAD, 0x8D, 0x6000), PairIndex("LDA abs / STA abs"));
+    EXPECT_EQ(Superinstructions::Match(0xAD, 0x8D, 0x2000), Superinstructions::kNoPair); // PPU register
+    EXPECT_EQ(Superinstructions::Match(0xAD, 0x8D, 0x4014), Superinstructions::kNoPair); // OAM DMA
+    EXPECT_EQ(Superinstructions::Match(0xAD, 0x8D, 0x8000), Superinstructions::kNoPair); // Mapper register
+    EXPECT_EQ(Superinstructions::Match(0x18, 0x6D, 0x2002), Superinstructions::kNoPair);
+    EXPECT_EQ(Superinstructions::Match(0x18, 0x6D, 0xC000), PairIndex("CLC / ADC abs"));
+    EXPECT_EQ(Superinstructions::Match(0xAD, 0x10, 0x00FB), PairIndex("LDA abs / BPL"));
+    EXPECT_EQ(Superinstructions::Match(0xA9, 0x10, 0x00FB), Superinstructions::kNoPair);
+}
+
+TEST(SuperinstructionsTest, PairsMatchSwitchCore) {
+    const TestRom rom = WriteIdiomRom();
+
+    CPU reference_cpu, fused_cpu;
+    PPU reference_ppu, fused_ppu;
+    Bus reference_bus(&reference_cpu, &reference_ppu);
+    Bus fused_bus(&fused_cpu, &fused_ppu);
+    ASSERT_TRUE(reference_bus.LoadCartridge(rom.Path()));
+    ASSERT_TRUE(fused_bus.LoadCartridge(rom.Path()));
+    reference_cpu.set_core(CPU::Core::kSwitch);
+    fused_cpu.set_fusion_enabled(true);
+
+    RunLockstep(reference_cpu, reference_bus, fused_cpu, fused_bus, [&] { return fused_cpu.PC() == kHaltAddress; },
+                1000);
+
+    const auto& counts = fused_cpu.FusedCounts();
+    EXPECT_EQ(counts[PairIndex("LDA abs / BPL")], 5u);
+    EXPECT_EQ(counts[PairIndex("LDA abs / STA abs")], 5u); // The copy to $2000 is not fused
+    EXPECT_EQ(counts[PairIndex("CLC / ADC imm")], 5u);
+    EXPECT_EQ(counts[PairIndex("CLC / ADC zp")], 5u);
+    EXPECT_EQ(counts[PairIndex("DEX / BNE")], 5u);
+    EXPECT_EQ(fused_cpu.Read(0x0300), 0x80);
+}
+
+TEST(SuperinstructionsTest, MatchesSwitchCoreOnNestest) {
+    const std::string rom_path = "roms/nes-testroms/other/nestest.nes";
+
+    CPU reference_cpu, fused_cpu;
+    PPU reference_ppu, fused_ppu;
+    Bus reference_bus(&reference_cpu, &reference_ppu);
+    Bus fused_bus(&fused_cpu, &fused_ppu);
+    ASSERT_TRUE(reference_bus.LoadCartridge(rom_path));
+    ASSERT_TRUE(fused_bus.LoadCartridge(rom_path));
+    reference_cpu.set_core(CPU::Core::kSwitch);
+    fused_cpu.set_fusion_enabled(true);
+    reference_cpu.set_PC(0xC000); // Automatic test PC
+    fused_cpu.set_PC(0xC000);
+
+    RunLockstep(reference_cpu, reference_bus, fused_cpu, fused_bus, [&] { return fused_cpu.SP() == 0xFF; }, 20000);
+
+    const auto& counts = fused_cpu.FusedCounts();
+    EXPECT_GT(std::accumulate(counts.begin(), counts.end(), uint64_t{0}), 0u);
+    EXPECT_EQ(fused_cpu.Read(0x02), reference_cpu.Read(0x02));
+    EXPECT_EQ(fused_cpu.Read(0x03), reference_cpu.Read(0x03));
+}
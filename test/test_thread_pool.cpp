@@ -0,0 +1,29 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "thread_pool.h"
+
+TEST(ThreadPoolTest, RunsEveryIterationOnce) {
+    for (const unsigned threads : {1u, 4u}) {
+        ThreadPool pool(threads);
+        EXPECT_EQ(pool.ThreadCount(), threads);
+
+        // Several loops in a row, so workers pick up new ones after finishing the last
+        for (const int count : {0, 1, 240, 1000}) {
+            std::vector<std::atomic<int>> calls(count);
+            pool.ParallelFor(count, [&](const int i) { calls[i]++; });
+            for (int i = 0; i < count; i++) ASSERT_EQ(calls[i], 1) << "threads " << threads << " index " << i;
+        }
+    }
+}
+
+TEST(ThreadPoolTest, WritesAreVisibleAfterTheLoop) {
+    ThreadPool pool(3);
+    std::vector<int> values(500, 0);
+    for (int round = 1; round <= 20; round++) {
+        pool.ParallelFor(static_cast<int>(values.size()), [&](const int i) { values[i] += i * round; });
+    }
+    for (int i = 0; i < static_cast<int>(values.size()); i++) EXPECT_EQ(values[i], i * 210);
+}